@@ -1,37 +1,309 @@
 #include "app.h"
 #include "engine/input-handler.h"
 #include "engine/game-handler.h"
+#include "profiler.h"
 
-#include <time.h>
 #include <math.h>
 
 /**
- * @brief The width of textures.png
+ * @brief The maximum frame rate when the window is not focused.
  */
-#define TEXTURE_WIDTH 96.0F
+#define UNFOCUSED_FRAME_RATE 10
+
+/**
+ * @brief The end of a frame limiter wait (in seconds) that is spent spinning instead of sleeping.
+ */
+#define FRAME_LIMITER_SPIN_DURATION 0.002
+
+/**
+ * @brief The number of frames whose CPU durations are kept until their GPU duration is read back.
+ */
+#define FRAME_TIMING_HISTORY (HXF_MAX_RENDERED_FRAMES + 1)
+
+/**
+ * @brief The steps of the startup that run at the same time, on the startup threads.
+ */
+typedef enum StartupTask {
+    STARTUP_TASK_WORLD, ///< Load the world and build the cubes’ faces.
+    STARTUP_TASK_GRAPHICS, ///< Initialize Vulkan, the memory, the textures and the pipelines.
+    STARTUP_TASK_COUNT
+} StartupTask;
+
 /**
- * @brief The height of textures.png
+ * @brief The data shared by the startup tasks.
  */
-#define TEXTURE_HEIGHT 80.0F
+typedef struct StartupData {
+    HxfAppData* app; ///< The application that is started.
+    double durations[STARTUP_TASK_COUNT]; ///< The duration (in seconds) of each task.
+} StartupData;
+
+/**
+ * @brief Run a startup task, it is called by the startup threads.
+ *
+ * @param userData A pointer to the StartupData.
+ * @param taskIndex The StartupTask to run.
+ */
+static void runStartupTask(void* userData, uint32_t taskIndex) {
+    StartupData* const startup = userData;
+    const double startTime = hxfGetTime();
+
+    // The world only writes the cubes’ faces to the drawing data, which the graphics
+    // initialization does not read
+
+    switch (taskIndex) {
+    case STARTUP_TASK_WORLD:
+        hxfGameInit(&startup->app->game);
+        break;
+    case STARTUP_TASK_GRAPHICS:
+        hxfGraphicsInit(&startup->app->graphics);
+        break;
+    }
+
+    startup->durations[taskIndex] = hxfGetTime() - startTime;
+}
+
+/**
+ * @brief Wait until the given time.
+ *
+ * The thread sleeps first, then spins for the last milliseconds as a sleep can end later than
+ * asked.
+ *
+ * @param timer The timer to sleep on.
+ * @param time The time (from hxfGetTime) to wait for.
+ */
+static void waitUntil(const HxfSleepTimer* restrict timer, double time) {
+    const double remaining = time - hxfGetTime();
+    if (remaining > FRAME_LIMITER_SPIN_DURATION) {
+        hxfSleep(timer, remaining - FRAME_LIMITER_SPIN_DURATION);
+    }
+
+    while (hxfGetTime() < time) {}
+}
+
+/**
+ * @brief Read the window messages and the input, then update the game.
+ *
+ * @param app A pointer to the application.
+ * @param frameIndex The index of the frame, the camera is placed on its path at that frame.
+ */
+static void updateGame(HxfAppData* restrict app, uint32_t frameIndex) {
+    hxfReadWindowMessages(&app->mainWindow);
+    if (app->cameraPath.keyframeCount != 0) {
+        // The input then only updates the camera direction from the path's angles
+        hxfCameraPathApply(&app->cameraPath, frameIndex, &app->game.camera);
+    }
+
+    // The cubes placed or destroyed by the input are all updated at once
+    hxfGameBeginEdit(&app->game);
+    hxfHandleInput(app);
+    hxfGameCommitEdit(&app->game);
+
+    hxfGameFrame(&app->game);
+}
+
+/**
+ * @brief Write the durations of a frame as a row of the timings file.
+ *
+ * The GPU durations are the ones of the last frame read back, the passes that did not run in
+ * the frame are left empty.
+ *
+ * @param frameIndex The index of the frame.
+ * @param gameDuration The time spent updating the game in the frame (in seconds).
+ * @param recordDuration The time spent recording the command buffers in the frame (in seconds).
+ */
+static void writeFrameTimings(HxfAppData* restrict app, uint64_t frameIndex, double gameDuration, double recordDuration) {
+    fprintf(app->timingsFile, "%llu,%.3f,%.3f", (unsigned long long)frameIndex, gameDuration * 1000.0, recordDuration * 1000.0);
+    for (int i = HXF_GPU_PASS_FRAME; i != HXF_GPU_PASS_UPLOAD; i++) {
+        const double passTime = hxfGraphicsGetGpuPassTime(&app->graphics, i);
+        if (passTime >= 0.0) {
+            fprintf(app->timingsFile, ",%.3f", passTime);
+        }
+        else {
+            fprintf(app->timingsFile, ",");
+        }
+    }
+    fprintf(app->timingsFile, "\n");
+}
 
 /**
  * @brief The game loop.
  */
 static void mainLoop(HxfAppData* restrict app) {
-    const clock_t startClock = clock(); ///< The time when the loop started.
-    clock_t currentClock = startClock; ///< The time when the current frame started.
+    double currentTime = hxfGetTime(); ///< The time when the current frame started.
+    float statisticsDuration = 0.0f; ///< The time since the statistics were printed.
+    int isFirstFrame = 1; ///< Set to 0 once the first frame is submitted.
+    double recordDuration = 0.0; ///< The time spent recording the command buffers since the statistics were printed.
+    uint64_t vertexInvocationCount = 0; ///< The number of vertex shader invocations since the statistics were printed.
+    uint64_t clippingPrimitiveCount = 0; ///< The number of primitives output by the clipping since the statistics were printed.
+    uint64_t fragmentInvocationCount = 0; ///< The number of fragment shader invocations since the statistics were printed.
+    double gpuPassTimes[HXF_GPU_PASS_COUNT] = { 0 }; ///< The GPU time of each pass since the statistics were printed.
+    uint32_t gpuPassFrameCounts[HXF_GPU_PASS_COUNT] = { 0 }; ///< The number of frames each pass was measured in since the statistics were printed.
+    uint32_t frameCount = 0; ///< The number of frames since the statistics were printed.
+    size_t scratchPeak = 0; ///< The most frame arena memory used by a frame since the statistics were printed.
+    uint32_t frameIndex = 0; ///< The index of the current frame.
+    double gameDurations[FRAME_TIMING_HISTORY]; ///< The time spent updating the game in the last frames.
+    double recordDurations[FRAME_TIMING_HISTORY]; ///< The time spent recording the command buffers in the last frames.
+    uint64_t submittedFrameCount = 0; ///< The number of frames submitted, when the durations were last kept.
+    uint64_t readTimingCount = 0; ///< The number of frames whose GPU durations have been read.
+
+    // The GPU duration of the whole frame, then of each of its passes, the uploads are not part of the frames
+    if (app->timingsFile != NULL) {
+        fprintf(app->timingsFile, "frame,game_ms,record_ms,gpu_ms");
+        for (int i = HXF_GPU_PASS_FRAME + 1; i != HXF_GPU_PASS_UPLOAD; i++) {
+            fprintf(app->timingsFile, ",%s_ms", hxfGraphicsGetGpuPassName(i));
+        }
+        fprintf(app->timingsFile, "\n");
+    }
 
     while (app->run) {
-        clock_t lastClock = currentClock; // Get the last clock
-        currentClock = clock(); // Update the current clock
-        app->frameDuration = (float)(currentClock - lastClock) / (float)CLOCKS_PER_SEC; // Time duration of the last frame (in seconds)
+        // Limit the frame rate, the frames are slowed down further when the window is not focused
+        uint32_t maxFrameRate = app->maxFrameRate;
+        if (!app->mainWindow.isFocused && (maxFrameRate == 0 || maxFrameRate > UNFOCUSED_FRAME_RATE)) {
+            maxFrameRate = UNFOCUSED_FRAME_RATE;
+        }
+        if (maxFrameRate != 0) {
+            waitUntil(&app->sleepTimer, currentTime + 1.0 / maxFrameRate);
+        }
+
+        const double lastTime = currentTime;
+        currentTime = hxfGetTime();
+        app->frameDuration = (float)(currentTime - lastTime); // Time duration of the last frame (in seconds)
 
-        hxfReadWindowMessages(&app->mainWindow);
-        hxfHandleInput(app);
-        hxfGameFrame(&app->game);
-        hxfGraphicsFrame(&app->graphics);
+        double gameDuration;
 
-        app->run = !app->mainWindow.shouldDestroyed;
+        if (app->graphics.lowLatency) {
+            // The input is read once the device is ready for a new frame, just before recording
+            const int isImageAcquired = hxfGraphicsBeginFrame(&app->graphics);
+            const double gameStartTime = hxfGetTime();
+            updateGame(app, frameIndex);
+            gameDuration = hxfGetTime() - gameStartTime;
+            if (isImageAcquired) {
+                hxfGraphicsEndFrame(&app->graphics);
+            }
+        }
+        else {
+            const double gameStartTime = hxfGetTime();
+            updateGame(app, frameIndex);
+            gameDuration = hxfGetTime() - gameStartTime;
+            hxfGraphicsFrame(&app->graphics);
+        }
+
+        // The GPU duration of a frame is only known a frame later, the CPU durations wait for it
+        if (app->timingsFile != NULL) {
+            // Nothing was submitted if no swapchain image was available
+            if (app->graphics.frameCount != submittedFrameCount) {
+                submittedFrameCount = app->graphics.frameCount;
+                gameDurations[(submittedFrameCount - 1) % FRAME_TIMING_HISTORY] = gameDuration;
+                recordDurations[(submittedFrameCount - 1) % FRAME_TIMING_HISTORY] = app->graphics.recordDuration;
+            }
+
+        }
+
+        if (app->graphics.timedFrameCount != readTimingCount) {
+            const uint64_t timedFrameIndex = app->graphics.timedFrameCount - 1;
+            readTimingCount = app->graphics.timedFrameCount;
+
+            if (app->timingsFile != NULL) {
+                writeFrameTimings(
+                    app, timedFrameIndex,
+                    gameDurations[timedFrameIndex % FRAME_TIMING_HISTORY],
+                    recordDurations[timedFrameIndex % FRAME_TIMING_HISTORY]
+                );
+            }
+
+            for (int i = HXF_GPU_PASS_FRAME; i != HXF_GPU_PASS_UPLOAD; i++) {
+                const double passTime = hxfGraphicsGetGpuPassTime(&app->graphics, i);
+                if (passTime >= 0.0) {
+                    gpuPassTimes[i] += passTime;
+                    gpuPassFrameCounts[i]++;
+                }
+            }
+        }
+
+        // The frame arena is the scratch arena of the thread that runs the game loop, everything
+        // allocated in it during the frame is released
+        const size_t frameScratchPeak = hxfArenaEndFrame(hxfGetScratchArena());
+        if (frameScratchPeak > scratchPeak) {
+            scratchPeak = frameScratchPeak;
+        }
+
+        frameIndex++;
+        HXF_PROFILER_FRAME();
+
+        if (isFirstFrame) {
+            if (app->printRecordTime) {
+                printf("First frame after %.3f ms\n", (hxfGetTime() - app->startTime) * 1000.0);
+            }
+            isFirstFrame = 0;
+        }
+
+        // Print the occlusion culling debug counters, the recording time, the pipeline statistics
+        // and the GPU timings every second
+        if (app->graphics.occlusionCulling || app->printRecordTime || app->graphics.pipelineStatistics || app->printGpuTimings) {
+            statisticsDuration += app->frameDuration;
+            recordDuration += app->graphics.recordDuration;
+            vertexInvocationCount += app->graphics.vertexInvocationCount;
+            clippingPrimitiveCount += app->graphics.clippingPrimitiveCount;
+            fragmentInvocationCount += app->graphics.fragmentInvocationCount;
+            frameCount++;
+
+            if (statisticsDuration >= 1.0f) {
+                if (app->graphics.occlusionCulling) {
+                    printf("Occlusion culling: %u pieces and %u faces culled\n", app->graphics.occlusionCulledPieceCount, app->graphics.occlusionCulledFaceCount);
+                }
+                if (app->printRecordTime) {
+                    printf("Command buffers recording: %.3f ms per frame\n", recordDuration * 1000.0 / frameCount);
+                    printf("Frame arena: %zu bytes at most per frame\n", scratchPeak);
+                }
+                if (app->graphics.pipelineStatistics) {
+                    printf(
+                        "Pipeline statistics: %llu vertex shader invocations, %llu clipping primitives and %llu fragment shader invocations per frame\n",
+                        (unsigned long long)(vertexInvocationCount / frameCount),
+                        (unsigned long long)(clippingPrimitiveCount / frameCount),
+                        (unsigned long long)(fragmentInvocationCount / frameCount)
+                    );
+                }
+                if (app->printGpuTimings && app->graphics.gpuTimings) {
+                    printf("GPU timings (ms per frame):");
+                    for (int i = HXF_GPU_PASS_FRAME; i != HXF_GPU_PASS_UPLOAD; i++) {
+                        if (gpuPassFrameCounts[i] != 0) {
+                            printf(" %s %.3f", hxfGraphicsGetGpuPassName(i), gpuPassTimes[i] / gpuPassFrameCounts[i]);
+                        }
+                        gpuPassTimes[i] = 0.0;
+                        gpuPassFrameCounts[i] = 0;
+                    }
+
+                    const double uploadTime = hxfGraphicsGetGpuPassTime(&app->graphics, HXF_GPU_PASS_UPLOAD);
+                    if (uploadTime >= 0.0) {
+                        printf(", last upload %.3f", uploadTime);
+                    }
+                    printf("\n");
+                }
+                statisticsDuration = 0.0f;
+                recordDuration = 0.0;
+                vertexInvocationCount = 0;
+                clippingPrimitiveCount = 0;
+                fragmentInvocationCount = 0;
+                frameCount = 0;
+                scratchPeak = 0;
+            }
+        }
+
+        app->run = !app->mainWindow.shouldDestroyed && (app->frameLimit == 0 || frameIndex != app->frameLimit);
+    }
+
+    // The last frames are only read back by the frames after them, they are read once the device
+    // is idle so that the file has a row for every submitted frame
+    if (app->timingsFile != NULL) {
+        hxfGraphicsStop(&app->graphics);
+        while (hxfGraphicsReadRemainingTimings(&app->graphics)) {
+            const uint64_t timedFrameIndex = app->graphics.timedFrameCount - 1;
+            writeFrameTimings(
+                app, timedFrameIndex,
+                gameDurations[timedFrameIndex % FRAME_TIMING_HISTORY],
+                recordDurations[timedFrameIndex % FRAME_TIMING_HISTORY]
+            );
+        }
     }
 }
 
@@ -39,12 +311,44 @@ void hxfAppStart(const HxfAppParam* restrict param) {
     const int halfWindowHeight = param->windowHeight / 2;
     const int selectorCubeSize = 100.0f; ///< Size of the selector cube icon (in pixels).
 
+    // The profiler starts first so that the startup is in the trace
+#if defined(HXF_PROFILER)
+    hxfProfilerInit(param->traceFile, param->hitchThreshold / 1000.0);
+#else
+    if (param->traceFile != NULL || param->hitchThreshold != 0.0f) {
+        HXF_MSG_ERROR("The game is built without the profiler, no trace is written");
+    }
+#endif
+
     // Set the default app data
 
     HxfAppData app = {
+        .startTime = hxfGetTime(),
         .appdataDirectory = param->appDataDirectory,
+        .printRecordTime = param->printRecordTime,
+        .printGpuTimings = param->printGpuTimings,
+        .maxFrameRate = param->maxFrameRate,
+        .frameLimit = param->frameLimit,
         .game.appdataDirectory = param->appDataDirectory,
+        .game.world.seed = param->seed,
+        .game.world.printStatistics = param->printRecordTime,
+        .game.pieceConnectivity = param->caveCulling,
         .graphics.appdataDirectory = param->appDataDirectory,
+        .graphics.gpuCulling = param->gpuCulling,
+        .graphics.occlusionCulling = param->occlusionCulling,
+        .graphics.caveCulling = param->caveCulling,
+        .graphics.commandBufferMode = param->commandBufferMode,
+        .graphics.presentMode = param->presentMode,
+        .graphics.lowLatency = param->lowLatency,
+        .graphics.sortPieces = param->sortPieces,
+        .graphics.depthPrepass = param->depthPrepass,
+        .graphics.pipelineStatistics = param->pipelineStatistics,
+        .graphics.levelOfDetail = param->levelOfDetail,
+        .graphics.vertexPulling = param->vertexPulling,
+        .graphics.gpuTimings = param->timingsFile != NULL || param->printGpuTimings,
+        .graphics.printPipelineTime = param->printRecordTime,
+        .graphics.capturePath = param->captureFile,
+        .graphics.captureFrame = param->captureFrame,
 
         .run = 1,
 
@@ -59,35 +363,35 @@ void hxfAppStart(const HxfAppParam* restrict param) {
         .graphics.drawingData = {
             .cubesVertices = {
                 // top
-                { { 0.0f, 1.0f, 1.0f }, { 64.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 1.0f, 0.0f }, { 64.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 0.0f }, { 80.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 1.0f }, { 80.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
+                { { 0.0f, 1.0f, 1.0f }, { 0.0f, 1.0f }, 4 },
+                { { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f }, 4 },
+                { { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f }, 4 },
+                { { 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f }, 4 },
                 // back
-                { { 0.0f, 1.0f, 0.0f }, { 32.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 0.0f, 0.0f }, { 32.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 0.0f, 0.0f }, { 48.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 0.0f }, { 48.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
+                { { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f }, 2 },
+                { { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f }, 2 },
+                { { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f }, 2 },
+                { { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f }, 2 },
                 // bottom
-                { { 0.0f, 0.0f, 0.0f }, { 80.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 0.0f, 1.0f }, { 80.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 0.0f, 1.0f }, { 96.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 0.0f, 0.0f }, { 96.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
+                { { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f }, 5 },
+                { { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, 5 },
+                { { 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, 5 },
+                { { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f }, 5 },
                 // front
-                { { 0.0f, 0.0f, 1.0f }, { 0.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 1.0f, 1.0f }, { 0.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 1.0f }, { 16.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 0.0f, 1.0f }, { 16.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
+                { { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, 0 },
+                { { 0.0f, 1.0f, 1.0f }, { 0.0f, 0.0f }, 0 },
+                { { 1.0f, 1.0f, 1.0f }, { 1.0f, 0.0f }, 0 },
+                { { 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f }, 0 },
                 // right
-                { { 1.0f, 0.0f, 1.0f }, { 16.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 1.0f }, { 16.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 1.0f, 0.0f }, { 32.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 1.0f, 0.0f, 0.0f }, { 32.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
+                { { 1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, 1 },
+                { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f }, 1 },
+                { { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f }, 1 },
+                { { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f }, 1 },
                 // left
-                { { 0.0f, 0.0f, 0.0f }, { 48.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 1.0f, 0.0f }, { 48.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 1.0f, 1.0f }, { 64.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { 0.0f, 0.0f, 1.0f }, { 64.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } }
+                { { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f }, 3 },
+                { { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f }, 3 },
+                { { 0.0f, 1.0f, 1.0f }, { 1.0f, 0.0f }, 3 },
+                { { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f }, 3 }
             },
             .cubesVertexIndices = {
                 0, 1, 2, 2, 3, 0,
@@ -103,10 +407,10 @@ void hxfAppStart(const HxfAppParam* restrict param) {
                 .projection = hxfPerspectiveProjectionMatrix(0.01f, (float)HXF_HORIZONTAL_VIEW_DISTANCE * 16.0f * 0.5f, M_PI / 180.0f * 60.0f, (float)param->windowWidth / (float)param->windowHeight)
             },
             .iconVertices = {
-                { { 0.0f - selectorCubeSize / 2, halfWindowHeight - selectorCubeSize }, { 0.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { selectorCubeSize - selectorCubeSize / 2, halfWindowHeight - selectorCubeSize }, { 16.0f / TEXTURE_WIDTH, 0.0f / TEXTURE_HEIGHT } },
-                { { selectorCubeSize - selectorCubeSize / 2, halfWindowHeight }, { 16.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
-                { { 0.0f - selectorCubeSize / 2, halfWindowHeight }, { 0.0f / TEXTURE_WIDTH, 16.0f / TEXTURE_HEIGHT } },
+                { { 0.0f - selectorCubeSize / 2, halfWindowHeight - selectorCubeSize }, { 0.0f, 0.0f } },
+                { { selectorCubeSize - selectorCubeSize / 2, halfWindowHeight - selectorCubeSize }, { 1.0f, 0.0f } },
+                { { selectorCubeSize - selectorCubeSize / 2, halfWindowHeight }, { 1.0f, 1.0f } },
+                { { 0.0f - selectorCubeSize / 2, halfWindowHeight }, { 0.0f, 1.0f } },
             },
             .iconVertexIndices = {
                 0, 1, 2, 2, 3, 0
@@ -114,26 +418,97 @@ void hxfAppStart(const HxfAppParam* restrict param) {
             .iconInstances = {
                 { 1 }
             },
-            .cubeInstances = hxfMalloc(HXF_CUBE_INSTANCES_SIZE)
+            .cubeInstances = hxfMalloc(HXF_CUBE_INSTANCES_SIZE, HXF_ALLOC_MESH)
         },
     };
 
     // Create the main window
 
     HxfWindowParam windowParameter = {
+#if defined(HXF_WIN32)
         param->hInstance,
         param->nCmdShow,
+#endif
         param->windowWidth,
         param->windowHeight
     };
     hxfCreateMainWindow(&windowParameter, &app.mainWindow);
     app.graphics.mainWindow = &app.mainWindow;
 
-    // Initialization
+    const double windowDuration = hxfGetTime() - app.startTime;
+
+    // Initialization, the world is loaded while Vulkan is initialized
 
     hxfInputInit(&app);
-    hxfGameInit(&app.game);
-    hxfGraphicsInit(&app.graphics);
+    hxfSleepTimerCreate(&app.sleepTimer);
+
+    // The benchmark options, the application stops at the end of the camera path by default
+
+    if (param->cameraPathFile != NULL) {
+        if (hxfCameraPathLoad(&app.cameraPath, param->cameraPathFile) != HXF_SUCCESS) {
+            HXF_FATAL("Could not load the camera path %s", param->cameraPathFile);
+        }
+        if (app.frameLimit == 0) {
+            app.frameLimit = hxfCameraPathGetLastFrame(&app.cameraPath) + 1;
+        }
+    }
+    if (param->timingsFile != NULL) {
+        app.timingsFile = fopen(param->timingsFile, "w");
+        if (app.timingsFile == NULL) {
+            HXF_FATAL("Could not open the timings file %s", param->timingsFile);
+        }
+    }
+
+    StartupData startup = {
+        .app = &app
+    };
+    const double tasksStartTime = hxfGetTime();
+
+    HxfThreadPool startupThreadPool;
+    hxfThreadPoolCreate(&startupThreadPool, STARTUP_TASK_COUNT);
+    hxfThreadPoolRun(&startupThreadPool, runStartupTask, &startup, STARTUP_TASK_COUNT);
+    hxfThreadPoolDestroy(&startupThreadPool);
+
+    const double tasksDuration = hxfGetTime() - tasksStartTime;
+
+    // The graphics handler has disabled the options the device does not support, the cave
+    // culling is now final
+
+    app.game.pieceConnectivity = app.graphics.caveCulling;
+
+    // The cubes can only be uploaded once both are done
+
+    const double uploadStartTime = hxfGetTime();
+    hxfGraphicsUpdateCubeBuffer(&app.graphics);
+    const double uploadDuration = hxfGetTime() - uploadStartTime;
+
+    // Print the duration of each phase and the memory used in the device local heap
+
+    if (app.printRecordTime) {
+        const char* graphicsPhaseNames[HXF_GRAPHICS_INIT_PHASE_COUNT] = {
+            "instance and device",
+            "images and memory",
+            "swapchain",
+            "pipelines"
+        };
+
+        printf("Startup:\n");
+        printf("    window: %.3f ms\n", windowDuration * 1000.0);
+        printf("    world and graphics (at the same time): %.3f ms\n", tasksDuration * 1000.0);
+        printf("        world loading and meshing: %.3f ms\n", startup.durations[STARTUP_TASK_WORLD] * 1000.0);
+        printf("        graphics: %.3f ms\n", startup.durations[STARTUP_TASK_GRAPHICS] * 1000.0);
+        for (int i = 0; i != HXF_GRAPHICS_INIT_PHASE_COUNT; i++) {
+            printf("            %s: %.3f ms\n", graphicsPhaseNames[i], app.graphics.initDurations[i] * 1000.0);
+        }
+        printf("    cubes upload: %.3f ms\n", uploadDuration * 1000.0);
+
+        HxfMemoryBudget deviceMemory;
+        hxfGetMemoryBudget(&app.graphics.memoryAllocator, HXF_MEMORY_USAGE_DEVICE, &deviceMemory);
+        printf(
+            "Device memory: %.1f MiB allocated in %.1f MiB of blocks, for a budget of %.1f MiB\n",
+            deviceMemory.allocationBytes / 1048576.0, deviceMemory.blockBytes / 1048576.0, deviceMemory.budget / 1048576.0
+        );
+    }
 
     // Run the main loop
 
@@ -145,6 +520,18 @@ void hxfAppStart(const HxfAppParam* restrict param) {
     hxfGameStop(&app.game);
     hxfGraphicsDestroy(&app.graphics);
     hxfDestroyMainWindow(&app.mainWindow);
+    hxfSleepTimerDestroy(&app.sleepTimer);
+
+    if (app.cameraPath.keyframeCount != 0) {
+        hxfCameraPathDestroy(&app.cameraPath);
+    }
+    if (app.timingsFile != NULL) {
+        fclose(app.timingsFile);
+    }
 
     hxfFree(app.graphics.drawingData.cubeInstances);
+
+#if defined(HXF_PROFILER)
+    hxfProfilerDestroy();
+#endif
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "world.h"
 #include "engine/graphics-handler.h"
 #include "engine/game-handler.h"
+#include "camera-path.h"
 
 /**
  * @struct HxfAppData
@@ -28,6 +29,14 @@ typedef struct HxfAppData {
     int run; ///< If set to 0, it indicates that the app should stop.
     float frameDuration; ///< The duration (in seconds) of the last frame.
     char* appdataDirectory; ///< The path to the appdataDirectory.
+    int printRecordTime; ///< If set to 1, the startup times are printed, then the average time spent recording the command buffers every second.
+    double startTime; ///< The time (from hxfGetTime) when the application started, to measure the time to the first frame.
+    uint32_t maxFrameRate; ///< The maximum number of frames per second, 0 means no limit.
+    HxfSleepTimer sleepTimer; ///< The timer the frame limiter sleeps on.
+    HxfCameraPath cameraPath; ///< The path the camera follows instead of the input, no keyframe if there is none.
+    uint32_t frameLimit; ///< The number of frames after which the application stops, 0 means no limit.
+    FILE* timingsFile; ///< The CSV file that receives the durations of each frame, NULL if they are not written.
+    int printGpuTimings; ///< If set to 1, the average GPU duration of each pass is printed every second.
 } HxfAppData;
 
 /**
@@ -42,6 +51,28 @@ typedef struct HxfAppParam {
     int windowWidth; ///< The main window’s width.
     int windowHeight; ///< The main window’s height.
     char* appDataDirectory; ///< The path to the appdata directory.
+    int gpuCulling; ///< If set to 1, the cubes are culled by a compute shader.
+    int occlusionCulling; ///< If set to 1, the pieces hidden by the previous frame are also culled (needs gpuCulling).
+    int caveCulling; ///< If set to 1, the pieces that can not be reached through air from the camera are culled.
+    HxfCommandBufferMode commandBufferMode; ///< How the draw command buffers are recorded.
+    int printRecordTime; ///< If set to 1, the startup times are printed, then the average time spent recording the command buffers every second.
+    VkPresentModeKHR presentMode; ///< The present mode of the swapchain.
+    uint32_t maxFrameRate; ///< The maximum number of frames per second, 0 means no limit.
+    int lowLatency; ///< If set to 1, only one frame is queued and the input is read just before recording.
+    int sortPieces; ///< If set to 1, the pieces are drawn from the nearest to the farthest from the camera.
+    int depthPrepass; ///< If set to 1, the depth of the cubes is drawn before the cubes.
+    int pipelineStatistics; ///< If set to 1, the average pipeline statistics are printed every second.
+    int levelOfDetail; ///< If set to 1, the distant pieces are drawn with larger cubes.
+    int vertexPulling; ///< If set to 1, the cubes are drawn without vertex input, from a storage buffer of faces.
+    char* cameraPathFile; ///< The camera path the camera follows, NULL to use the input.
+    uint32_t frameLimit; ///< The number of frames after which the application stops, 0 means no limit.
+    char* timingsFile; ///< The CSV file the durations of each frame are written to, NULL to not write them.
+    uint32_t captureFrame; ///< The index of the frame that is written to captureFile.
+    char* captureFile; ///< The PPM image the frame captureFrame is written to, NULL to not capture a frame.
+    int printGpuTimings; ///< If set to 1, the average GPU duration of each pass is printed every second.
+    char* traceFile; ///< The Chrome trace file the profiler writes at the end, NULL to not write it (only with the profiler).
+    float hitchThreshold; ///< The frame duration (in milliseconds) above which the last frames are written, 0 to ignore the hitches (only with the profiler).
+    uint32_t seed; ///< The seed the terrain of a new world is generated from, random if --seed is not given.
 } HxfAppParam;
 
 /**
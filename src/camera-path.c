@@ -0,0 +1,106 @@
+#include "camera-path.h"
+#include <math.h>
+
+/**
+ * @brief The maximum length of a line of a camera path file.
+ */
+#define LINE_LENGTH 256
+
+HxfResult hxfCameraPathLoad(HxfCameraPath* restrict path, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        return HXF_ERROR;
+    }
+
+    uint32_t capacity = 16;
+    path->keyframes = hxfMalloc(capacity * sizeof(HxfCameraKeyframe), HXF_ALLOC_OTHER);
+    path->keyframeCount = 0;
+
+    char line[LINE_LENGTH];
+    int lineNumber = 0;
+    HxfResult result = HXF_SUCCESS;
+
+    while (result == HXF_SUCCESS && fgets(line, LINE_LENGTH, file) != NULL) {
+        lineNumber++;
+
+        // Skip the empty lines and the comments
+        char* start = line;
+        while (*start == ' ' || *start == '\t') {
+            start++;
+        }
+        if (*start == '\0' || *start == '\n' || *start == '\r' || *start == '#') {
+            continue;
+        }
+
+        HxfCameraKeyframe keyframe;
+        float yaw;
+        float pitch;
+        if (sscanf(start, "%u %f %f %f %f %f", &keyframe.frame, &keyframe.position.x, &keyframe.position.y, &keyframe.position.z, &yaw, &pitch) != 6) {
+            HXF_MSG_ERROR("Wrong keyframe at line %d of the camera path %s", lineNumber, filename);
+            result = HXF_ERROR;
+        }
+        else if (path->keyframeCount != 0 && keyframe.frame <= path->keyframes[path->keyframeCount - 1].frame) {
+            HXF_MSG_ERROR("The keyframes of the camera path %s are not sorted by frame, at line %d", filename, lineNumber);
+            result = HXF_ERROR;
+        }
+        else {
+            keyframe.yaw = yaw * (float)M_PI / 180.0f;
+            keyframe.pitch = pitch * (float)M_PI / 180.0f;
+
+            if (path->keyframeCount == capacity) {
+                capacity *= 2;
+                path->keyframes = hxfRealloc(path->keyframes, capacity * sizeof(HxfCameraKeyframe), HXF_ALLOC_OTHER);
+            }
+            path->keyframes[path->keyframeCount++] = keyframe;
+        }
+    }
+
+    fclose(file);
+
+    if (result == HXF_SUCCESS && path->keyframeCount == 0) {
+        HXF_MSG_ERROR("The camera path %s has no keyframe", filename);
+        result = HXF_ERROR;
+    }
+
+    if (result != HXF_SUCCESS) {
+        hxfCameraPathDestroy(path);
+    }
+
+    return result;
+}
+
+void hxfCameraPathDestroy(HxfCameraPath* restrict path) {
+    hxfFree(path->keyframes);
+    path->keyframes = NULL;
+    path->keyframeCount = 0;
+}
+
+void hxfCameraPathApply(const HxfCameraPath* restrict path, uint32_t frame, HxfCamera* restrict camera) {
+    // The first keyframe that is not before the frame
+    uint32_t next = 0;
+    while (next != path->keyframeCount && path->keyframes[next].frame < frame) {
+        next++;
+    }
+
+    if (next == 0 || next == path->keyframeCount) {
+        const HxfCameraKeyframe* const keyframe = &path->keyframes[next == 0 ? 0 : next - 1];
+        camera->position = keyframe->position;
+        camera->yaw = keyframe->yaw;
+        camera->pitch = keyframe->pitch;
+        return;
+    }
+
+    const HxfCameraKeyframe* const a = &path->keyframes[next - 1];
+    const HxfCameraKeyframe* const b = &path->keyframes[next];
+    const float t = (float)(frame - a->frame) / (float)(b->frame - a->frame);
+
+    camera->position.x = a->position.x + (b->position.x - a->position.x) * t;
+    camera->position.y = a->position.y + (b->position.y - a->position.y) * t;
+    camera->position.z = a->position.z + (b->position.z - a->position.z) * t;
+    camera->yaw = a->yaw + (b->yaw - a->yaw) * t;
+    camera->pitch = a->pitch + (b->pitch - a->pitch) * t;
+}
+
+uint32_t hxfCameraPathGetLastFrame(const HxfCameraPath* restrict path) {
+    return path->keyframes[path->keyframeCount - 1].frame;
+}
\ No newline at end of file
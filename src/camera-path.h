@@ -0,0 +1,62 @@
+/**
+ * @file camera-path.h
+ * @brief A scripted camera movement, to render the same frames on each run.
+ */
+#pragma once
+
+#include "hxf.h"
+#include "camera.h"
+#include <stdint.h>
+
+/**
+ * @brief The camera at a given frame of a path.
+ */
+typedef struct HxfCameraKeyframe {
+    uint32_t frame; ///< The frame the camera reaches the keyframe at.
+    HxfVec3 position; ///< The position of the camera.
+    float yaw; ///< The yaw of the camera (in radians).
+    float pitch; ///< The pitch of the camera (in radians).
+} HxfCameraKeyframe;
+
+/**
+ * @brief A camera path, the camera moves in a straight line from a keyframe to the next.
+ */
+typedef struct HxfCameraPath {
+    HxfCameraKeyframe* keyframes; ///< The keyframes sorted by frame.
+    uint32_t keyframeCount; ///< The number of elements of keyframes, 0 if there is no path.
+} HxfCameraPath;
+
+/**
+ * @brief Load a camera path from a text file.
+ *
+ * Each line is a keyframe: the frame, the position x, y and z, then the yaw and the pitch in
+ * degrees, separated by spaces. The empty lines and the lines starting with # are ignored.
+ *
+ * @param path A pointer to the HxfCameraPath that receives the keyframes.
+ * @param filename The name of the file.
+ *
+ * @return HXF_ERROR if the file could not be read or has no keyframe, HXF_SUCCESS otherwise.
+ */
+HxfResult hxfCameraPathLoad(HxfCameraPath* restrict path, const char* filename);
+
+/**
+ * @brief Free the keyframes of a camera path.
+ */
+void hxfCameraPathDestroy(HxfCameraPath* restrict path);
+
+/**
+ * @brief Place the camera where the path is at a frame.
+ *
+ * The position and the angles are interpolated between the keyframes around the frame. Before
+ * the first keyframe and after the last one, the camera stays at that keyframe.
+ *
+ * @param path A pointer to the path.
+ * @param frame The frame.
+ * @param camera A pointer to the camera, its position, yaw and pitch are set.
+ */
+void hxfCameraPathApply(const HxfCameraPath* restrict path, uint32_t frame, HxfCamera* restrict camera);
+
+/**
+ * @brief Get the frame of the last keyframe of a camera path.
+ */
+uint32_t hxfCameraPathGetLastFrame(const HxfCameraPath* restrict path);
\ No newline at end of file
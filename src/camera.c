@@ -1,54 +1,156 @@
 #include "camera.h"
 #include <math.h>
+#include <stddef.h>
 
 void hxfUpdatePointedCube(HxfCamera* restrict camera, const HxfWorld* restrict world) {
-    const int maxPointingDistance = 5; // Maximum distance at which the block can be selected
-    const int precision = 50;
+    const float maxPointingDistance = 5.0f; // Maximum distance at which the block can be selected
 
-    int i = 1;
-    int cubeNotFound = 1;
+    if (camera->isPickValid
+        && camera->pickPosition.x == camera->position.x
+        && camera->pickPosition.y == camera->position.y
+        && camera->pickPosition.z == camera->position.z
+        && camera->pickDirection.x == camera->direction.x
+        && camera->pickDirection.y == camera->direction.y
+        && camera->pickDirection.z == camera->direction.z) {
+        return;
+    }
+    camera->pickPosition = camera->position;
+    camera->pickDirection = camera->direction;
+    camera->isPickValid = 1;
+    camera->isPointingToCube = 0;
+
+    // A cube at (x, y, z) goes from x - 0.5 to x + 0.5, so the ray starts half a cube further
+    // to work with the cubes' corners
 
-    const HxfVec3 forward = { camera->direction.x / (float)precision, camera->direction.y / (float)precision, camera->direction.z / (float)precision };
+    const float origin[3] = {
+        camera->position.x + 0.5f,
+        camera->position.y + 0.5f,
+        camera->position.z + 0.5f
+    };
+    const float direction[3] = {
+        camera->direction.x,
+        camera->direction.y,
+        camera->direction.z
+    };
 
-    HxfVec3 floatPosition = camera->position;
-    HxfIvec3 nearCube = { 0 };
-    int nearCubeNotSet = 1;
+    int32_t cube[3]; // The cube the ray is in
+    int32_t step[3]; // The direction the ray goes to on each axis (-1, 0 or 1)
+    float tMax[3]; // The distance along the ray at which the next cube of each axis is entered
+    float tDelta[3]; // The distance along the ray to cross a cube on each axis
 
-    while (cubeNotFound && i != maxPointingDistance * precision) {
-        // Select the next cube
+    for (int i = 0; i != 3; i++) {
+        cube[i] = (int32_t)floorf(origin[i]);
 
-        floatPosition = hxfVec3Add(&floatPosition, &forward);
-        HxfIvec3 intPosition = roundVector(&floatPosition);
+        if (direction[i] > 0.0f) {
+            step[i] = 1;
+            tDelta[i] = 1.0f / direction[i];
+            tMax[i] = ((float)cube[i] + 1.0f - origin[i]) * tDelta[i];
+        }
+        else if (direction[i] < 0.0f) {
+            step[i] = -1;
+            tDelta[i] = -1.0f / direction[i];
+            tMax[i] = (origin[i] - (float)cube[i]) * tDelta[i];
+        }
+        else {
+            step[i] = 0;
+            tDelta[i] = INFINITY;
+            tMax[i] = INFINITY;
+        }
+    }
 
-        const HxfIvec3 worldPiecePosition = hxfWorldGetPiecePositionF(&floatPosition);
-        HxfMapElement* const worldPieceElement = hxfMapGet(&world->pieces, &worldPiecePosition);
+    // The piece of the last cube, it is only searched again when the ray leaves it
+    HxfIvec3 piecePosition = { 0 };
+    const HxfWorldPiece* piece = NULL;
+    int isPieceSearched = 0;
 
-        if (worldPieceElement != NULL) {
-            HxfWorldPiece* const worldPiece = (HxfWorldPiece*)worldPieceElement->value;
+    int crossedAxis = -1; // The axis of the face the ray entered the cube through, -1 for the first cube
+    float distance = 0.0f;
 
-            const HxfIvec3 worldPieceRelativePosition = hxfWorldGetLocalPosition(&intPosition);
-            if (worldPiece->cubes[worldPieceRelativePosition.x][worldPieceRelativePosition.y][worldPieceRelativePosition.z] != 0) {
-                camera->pointedCube = intPosition;
-                camera->isPointingToCube = 1;
-                cubeNotFound = 0;
+    while (distance <= maxPointingDistance) {
+        const HxfIvec3 position = { cube[0], cube[1], cube[2] };
+        const HxfIvec3 cubePiecePosition = hxfWorldGetPiecePositionI(&position);
+
+        if (!isPieceSearched || cubePiecePosition.x != piecePosition.x || cubePiecePosition.y != piecePosition.y || cubePiecePosition.z != piecePosition.z) {
+            HxfMapElement* const pieceElement = hxfMapGet(&world->pieces, &cubePiecePosition);
+            piece = pieceElement != NULL ? (const HxfWorldPiece*)pieceElement->value : NULL;
+            piecePosition = cubePiecePosition;
+            isPieceSearched = 1;
+        }
+
+        // A piece of air, or that is not loaded, is crossed at once: the ray goes to the face it
+        // leaves the piece through without looking at its cubes
+
+        if (piece == NULL || (piece->block == NULL && piece->uniformCube == 0)) {
+            const int32_t pieceMin[3] = {
+                piecePosition.x * HXF_WORLD_PIECE_SIZE,
+                piecePosition.y * HXF_WORLD_PIECE_SIZE,
+                piecePosition.z * HXF_WORLD_PIECE_SIZE
+            };
+            int exitAxis = -1;
+            float exitDistance = INFINITY;
+
+            for (int i = 0; i != 3; i++) {
+                if (step[i] != 0) {
+                    // The number of faces of this axis the ray crosses before leaving the piece
+                    const int32_t crossingCount = step[i] > 0 ? pieceMin[i] + HXF_WORLD_PIECE_SIZE - 1 - cube[i] : cube[i] - pieceMin[i];
+                    const float axisExitDistance = tMax[i] + crossingCount * tDelta[i];
+
+                    if (axisExitDistance < exitDistance) {
+                        exitAxis = i;
+                        exitDistance = axisExitDistance;
+                    }
+                }
+            }
+
+            if (exitAxis == -1) {
+                return;
             }
-            else {
-                nearCube = intPosition;
-                nearCubeNotSet = 0;
+
+            // The other axes cross the faces that are before the exit
+            for (int i = 0; i != 3; i++) {
+                while (i != exitAxis && tMax[i] < exitDistance) {
+                    cube[i] += step[i];
+                    tMax[i] += tDelta[i];
+                }
             }
+
+            crossedAxis = exitAxis;
+            distance = exitDistance;
+            cube[exitAxis] = step[exitAxis] > 0 ? pieceMin[exitAxis] + HXF_WORLD_PIECE_SIZE : pieceMin[exitAxis] - 1;
+            tMax[exitAxis] = exitDistance + tDelta[exitAxis];
+
+            continue;
         }
-        else {
-            nearCube = intPosition;
-            nearCubeNotSet = 0;
+
+        // The cubes of a uniform piece that is not air are all solid
+        const HxfIvec3 localPosition = hxfWorldGetLocalPosition(&position);
+
+        if (piece->block == NULL || piece->block->cubes[localPosition.x][localPosition.y][localPosition.z] != 0) {
+            // The cube the camera is in can not be pointed to, there is no face to place a cube on
+            if (crossedAxis != -1) {
+                int32_t normal[3] = { 0, 0, 0 };
+                normal[crossedAxis] = -step[crossedAxis];
+
+                camera->pointedCube = position;
+                camera->pointedFaceNormal = (HxfIvec3){ normal[0], normal[1], normal[2] };
+                camera->nearPointedCube = (HxfIvec3){ cube[0] + normal[0], cube[1] + normal[1], cube[2] + normal[2] };
+                camera->isPointingToCube = 1;
+            }
+
+            return;
         }
 
-        i++;
-    }
+        // Go to the next cube through the nearest face
 
-    if (cubeNotFound || nearCubeNotSet) {
-        camera->isPointingToCube = 0;
-    }
-    else {
-        camera->nearPointedCube = nearCube;
+        if (tMax[0] < tMax[1]) {
+            crossedAxis = tMax[0] < tMax[2] ? 0 : 2;
+        }
+        else {
+            crossedAxis = tMax[1] < tMax[2] ? 1 : 2;
+        }
+
+        distance = tMax[crossedAxis];
+        cube[crossedAxis] += step[crossedAxis];
+        tMax[crossedAxis] += tDelta[crossedAxis];
     }
 }
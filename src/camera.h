@@ -20,11 +20,19 @@ typedef struct HxfCamera {
     HxfIvec3 pointedCube; ///< The coordinate of the cube the camera is pointing to.
     int isPointingToCube; ///< Set to 1 if the camera is pointing to a cube, 0 otherwise.
     HxfIvec3 nearPointedCube; ///< The cube that is just before the pointed cube. Especially used to place a cube.
+    HxfIvec3 pointedFaceNormal; ///< The normal of the face of the pointed cube the camera is pointing to.
+    HxfVec3 pickPosition; ///< The position the pointed cube was last searched from.
+    HxfVec3 pickDirection; ///< The direction the pointed cube was last searched in.
+    int isPickValid; ///< Set to 0 when the cubes changed, so that the pointed cube is searched again.
 } HxfCamera;
 
 /**
  * @brief Update the pointed cube.
  *
+ * The ray goes through each cube it crosses once (Amanatides and Woo grid traversal), until it
+ * hits a cube or goes further than the pointing distance. Nothing is done if the camera did not
+ * move since the last search and the cubes did not change (isPickValid).
+ *
  * @param camera The camera that is aiming at the cube.
  * @param world The world where the cubes are.
  */
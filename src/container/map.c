@@ -16,7 +16,7 @@ void hxfMapSet(HxfMap* map, void* key, void* value) {
     // Set the first element if the map is empty.
 
     if (map->start == NULL) {
-        HxfMapElement* newElement = hxfMalloc(sizeof(HxfMapElement));
+        HxfMapElement* newElement = hxfMalloc(sizeof(HxfMapElement), HXF_ALLOC_WORLD);
         newElement->key = key;
         newElement->value = value;
         newElement->next = NULL;
@@ -34,7 +34,7 @@ void hxfMapSet(HxfMap* map, void* key, void* value) {
         }
 
         if (differentKey) {
-            HxfMapElement* newElement = hxfMalloc(sizeof(HxfMapElement));
+            HxfMapElement* newElement = hxfMalloc(sizeof(HxfMapElement), HXF_ALLOC_WORLD);
             newElement->key = key;
             newElement->value = value;
             newElement->next = NULL;
@@ -1,28 +1,172 @@
 #include "game-handler.h"
+#include "../profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 static const char WORLD_DIRECTORY[] = "/world"; ///< The path to the world file
 
+/**
+ * @brief The distance (in pieces) from the camera’s piece from which each level of detail is used.
+ */
+static const int LOD_DISTANCES[HXF_WORLD_LOD_COUNT] = { 0, 3, 5 };
+
 /**
  * @brief Append a new cube’s face that will be drawn.
  *
  * @param face A pointer to an array of faces where the face will be added.
  * @param position The position of the new face in the world.
  * @param textureIndex The texture index of the face.
+ * @param size The width of the cube, in cubes.
  * @param index The index of the new face. It is incremented after the cube is added.
  */
-static void addDrawnFace(HxfCubeInstanceData* restrict faces, const HxfVec3* restrict position, uint32_t textureIndex, size_t* index) {
+static void addDrawnFace(HxfCubeInstanceData* restrict faces, const HxfVec3* restrict position, uint32_t textureIndex, uint32_t size, size_t* index) {
     faces->position = *position;
     faces->textureIndex = textureIndex;
+    faces->size = size;
     (*index)++;
 }
 
+/**
+ * @brief Append the faces of the cubes of a world piece that are not hidden by other cubes.
+ *
+ * The faces on the sides of the piece are always added, so the pieces drawn with different
+ * levels of detail never leave a hole between them.
+ *
+ * @param drawingData A pointer to the drawing data where the faces are added.
+ * @param cubes The cubes of the piece, or of one of its levels of detail.
+ * @param level The level of detail of the cubes.
+ * @param piecePosition The position of the piece inside the world.
+ */
+static void addPieceFaces(HxfDrawingData* restrict drawingData, uint32_t cubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE], uint32_t level, const HxfIvec3* restrict piecePosition) {
+    const int cubeCount = HXF_WORLD_PIECE_SIZE >> level; // The number of cubes in each dimension
+    const int last = cubeCount - 1;
+    const uint32_t size = 1 << level;
+
+    for (int x = 0; x != cubeCount; x++) {
+        for (int y = 0; y != cubeCount; y++) {
+            for (int z = 0; z != cubeCount; z++) {
+                const uint32_t textureId = cubes[x][y][z];
+                const HxfVec3 position = {
+                    x * size + piecePosition->x * HXF_WORLD_PIECE_SIZE,
+                    y * size + piecePosition->y * HXF_WORLD_PIECE_SIZE,
+                    z * size + piecePosition->z * HXF_WORLD_PIECE_SIZE
+                };
+
+                if (textureId != 0) {
+                    if ((x != last && cubes[x + 1][y][z] == 0)
+                        || x == last) {
+                        size_t* index = &drawingData->faceRightCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_RIGHT_OFFSET + *index], &position, textureId, size, index);
+                    }
+                    if ((x != 0 && cubes[x - 1][y][z] == 0)
+                        || x == 0) {
+                        size_t* index = &drawingData->faceLeftCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_LEFT_OFFSET + *index], &position, textureId, size, index);
+                    }
+                    if ((y != last && cubes[x][y + 1][z] == 0)
+                        || y == last) {
+                        size_t* index = &drawingData->faceTopCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_TOP_OFFSET + *index], &position, textureId, size, index);
+                    }
+                    if ((y != 0 && cubes[x][y - 1][z] == 0)
+                        || y == 0) {
+                        size_t* index = &drawingData->faceBottomCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BOTTOM_OFFSET + *index], &position, textureId, size, index);
+                    }
+                    if ((z != last && cubes[x][y][z + 1] == 0)
+                        || z == last) {
+                        size_t* index = &drawingData->faceFrontCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_FRONT_OFFSET + *index], &position, textureId, size, index);
+                    }
+                    if ((z != 0 && cubes[x][y][z - 1] == 0)
+                        || z == 0) {
+                        size_t* index = &drawingData->faceBackCount;
+                        addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BACK_OFFSET + *index], &position, textureId, size, index);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Append the faces of a uniform world piece, only the faces on its sides are visible.
+ *
+ * @param drawingData A pointer to the drawing data where the faces are added.
+ * @param textureId The texture index of all the cubes of the piece, nothing is added for air.
+ * @param level The level of detail the piece is drawn with.
+ * @param piecePosition The position of the piece inside the world.
+ */
+static void addUniformPieceFaces(HxfDrawingData* restrict drawingData, uint32_t textureId, uint32_t level, const HxfIvec3* restrict piecePosition) {
+    if (textureId == 0) {
+        return;
+    }
+
+    const int cubeCount = HXF_WORLD_PIECE_SIZE >> level; // The number of cubes in each dimension
+    const uint32_t size = 1 << level;
+    const float origin[3] = {
+        piecePosition->x * HXF_WORLD_PIECE_SIZE,
+        piecePosition->y * HXF_WORLD_PIECE_SIZE,
+        piecePosition->z * HXF_WORLD_PIECE_SIZE
+    };
+    const float last = (cubeCount - 1) * size; // The position of the last cubes inside the piece
+
+    for (int i = 0; i != cubeCount; i++) {
+        for (int j = 0; j != cubeCount; j++) {
+            const float a = i * size;
+            const float b = j * size;
+            const HxfVec3 right = { origin[0] + last, origin[1] + a, origin[2] + b };
+            const HxfVec3 left = { origin[0], origin[1] + a, origin[2] + b };
+            const HxfVec3 top = { origin[0] + a, origin[1] + last, origin[2] + b };
+            const HxfVec3 bottom = { origin[0] + a, origin[1], origin[2] + b };
+            const HxfVec3 front = { origin[0] + a, origin[1] + b, origin[2] + last };
+            const HxfVec3 back = { origin[0] + a, origin[1] + b, origin[2] };
+
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_RIGHT_OFFSET + drawingData->faceRightCount], &right, textureId, size, &drawingData->faceRightCount);
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_LEFT_OFFSET + drawingData->faceLeftCount], &left, textureId, size, &drawingData->faceLeftCount);
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_TOP_OFFSET + drawingData->faceTopCount], &top, textureId, size, &drawingData->faceTopCount);
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BOTTOM_OFFSET + drawingData->faceBottomCount], &bottom, textureId, size, &drawingData->faceBottomCount);
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_FRONT_OFFSET + drawingData->faceFrontCount], &front, textureId, size, &drawingData->faceFrontCount);
+            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BACK_OFFSET + drawingData->faceBackCount], &back, textureId, size, &drawingData->faceBackCount);
+        }
+    }
+}
+
+/**
+ * @brief Get the level of detail a world piece is drawn with.
+ *
+ * @param piecePosition The position of the piece inside the world.
+ * @param cameraPiecePosition The position of the piece the camera is in.
+ *
+ * @return The highest level whose distance in LOD_DISTANCES is reached.
+ */
+static uint32_t getPieceLevelOfDetail(const HxfIvec3* restrict piecePosition, const HxfIvec3* restrict cameraPiecePosition) {
+    // Only the horizontal distance, as the pieces are only loaded again when the camera
+    // changes of piece horizontally
+    const int dx = abs(piecePosition->x - cameraPiecePosition->x);
+    const int dz = abs(piecePosition->z - cameraPiecePosition->z);
+    const int distance = dx > dz ? dx : dz;
+
+    uint32_t level = 0;
+    while (level != HXF_WORLD_LOD_COUNT - 1 && distance >= LOD_DISTANCES[level + 1]) {
+        level++;
+    }
+
+    return level;
+}
+
 /**
  * @brief Update the drawing data’s faces to draw only those that are needed.
  *
  * @param game A pointer to game that own the drawing data.
  */
 static void updateDrawnFaces(HxfGameData* restrict game) {
+    HXF_ZONE("game.updateDrawnFaces");
+
     HxfDrawingData* const drawingData = &game->graphics->drawingData;
+    const HxfIvec3 cameraPiecePosition = hxfWorldGetPiecePositionF(&game->camera.position);
+    uint32_t lodCubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE];
 
     // Reset all the faces. No faces are drawn.
 
@@ -33,53 +177,54 @@ static void updateDrawnFaces(HxfGameData* restrict game) {
     drawingData->faceRightCount = 0;
     drawingData->faceLeftCount = 0;
 
+    drawingData->pieceCount = 0;
+
     // Select the faces that are not hidden by other cubes.
     HxfMapElement* iterator = game->world.pieces.start;
     while (iterator != NULL) { // For each world piece.
-        for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
-            for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
-                for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
-                    HxfWorldPiece* const worldPiece = (HxfWorldPiece*)iterator->value;
-                    HxfIvec3* const worldPiecePosition = (HxfIvec3*)iterator->key;
-
-                    const uint32_t textureId = worldPiece->cubes[x][y][z];
-                    const HxfVec3 position = { x + worldPiecePosition->x * HXF_WORLD_PIECE_SIZE, y + worldPiecePosition->y * HXF_WORLD_PIECE_SIZE, z + worldPiecePosition->z * HXF_WORLD_PIECE_SIZE };
-
-                    if (textureId != 0) {
-                        if ((x != HXF_WORLD_PIECE_SIZE - 1 && worldPiece->cubes[x + 1][y][z] == 0)
-                            || x == HXF_WORLD_PIECE_SIZE - 1) {
-                            size_t* index = &drawingData->faceRightCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_RIGHT_OFFSET + *index], &position, textureId, index);
-                        }
-                        if ((x != 0 && worldPiece->cubes[x - 1][y][z] == 0)
-                            || x == 0) {
-                            size_t* index = &drawingData->faceLeftCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_LEFT_OFFSET + *index], &position, textureId, index);
-                        }
-                        if ((y != HXF_WORLD_PIECE_SIZE - 1 && worldPiece->cubes[x][y + 1][z] == 0)
-                            || y == HXF_WORLD_PIECE_SIZE - 1) {
-                            size_t* index = &drawingData->faceTopCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_TOP_OFFSET + *index], &position, textureId, index);
-                        }
-                        if ((y != 0 && worldPiece->cubes[x][y - 1][z] == 0)
-                            || y == 0) {
-                            size_t* index = &drawingData->faceBottomCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BOTTOM_OFFSET + *index], &position, textureId, index);
-                        }
-                        if ((z != HXF_WORLD_PIECE_SIZE - 1 && worldPiece->cubes[x][y][z + 1] == 0)
-                            || z == HXF_WORLD_PIECE_SIZE - 1) {
-                            size_t* index = &drawingData->faceFrontCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_FRONT_OFFSET + *index], &position, textureId, index);
-                        }
-                        if ((z != 0 && worldPiece->cubes[x][y][z - 1] == 0)
-                            || z == 0) {
-                            size_t* index = &drawingData->faceBackCount;
-                            addDrawnFace(&drawingData->cubeInstances[HXF_FACES_BACK_OFFSET + *index], &position, textureId, index);
-                        }
-                    }
-                }
-            }
+        // The faces of the piece are contiguous inside each direction, so only the first face
+        // and the number of faces are needed for the culling.
+
+        HxfPieceDrawData* const pieceDrawData = &drawingData->pieces[drawingData->pieceCount];
+        HxfWorldPiece* const worldPiece = (HxfWorldPiece*)iterator->value;
+        const HxfIvec3* const piecePosition = (HxfIvec3*)iterator->key;
+        pieceDrawData->position.x = piecePosition->x * HXF_WORLD_PIECE_SIZE;
+        pieceDrawData->position.y = piecePosition->y * HXF_WORLD_PIECE_SIZE;
+        pieceDrawData->position.z = piecePosition->z * HXF_WORLD_PIECE_SIZE;
+        pieceDrawData->faceOffsets[0] = HXF_FACES_TOP_OFFSET + drawingData->faceTopCount;
+        pieceDrawData->faceOffsets[1] = HXF_FACES_BACK_OFFSET + drawingData->faceBackCount;
+        pieceDrawData->faceOffsets[2] = HXF_FACES_BOTTOM_OFFSET + drawingData->faceBottomCount;
+        pieceDrawData->faceOffsets[3] = HXF_FACES_FRONT_OFFSET + drawingData->faceFrontCount;
+        pieceDrawData->faceOffsets[4] = HXF_FACES_RIGHT_OFFSET + drawingData->faceRightCount;
+        pieceDrawData->faceOffsets[5] = HXF_FACES_LEFT_OFFSET + drawingData->faceLeftCount;
+
+        // The distant pieces are drawn with larger cubes, which have fewer faces
+        const uint32_t level = game->graphics->levelOfDetail ? getPieceLevelOfDetail(piecePosition, &cameraPiecePosition) : 0;
+        if (worldPiece->block == NULL) {
+            addUniformPieceFaces(drawingData, worldPiece->uniformCube, level, piecePosition);
         }
+        else if (level == 0) {
+            addPieceFaces(drawingData, worldPiece->block->cubes, 0, piecePosition);
+        }
+        else {
+            hxfWorldDownsamplePiece(worldPiece, level, lodCubes);
+            addPieceFaces(drawingData, lodCubes, level, piecePosition);
+        }
+
+        pieceDrawData->faceCounts[0] = HXF_FACES_TOP_OFFSET + drawingData->faceTopCount - pieceDrawData->faceOffsets[0];
+        pieceDrawData->faceCounts[1] = HXF_FACES_BACK_OFFSET + drawingData->faceBackCount - pieceDrawData->faceOffsets[1];
+        pieceDrawData->faceCounts[2] = HXF_FACES_BOTTOM_OFFSET + drawingData->faceBottomCount - pieceDrawData->faceOffsets[2];
+        pieceDrawData->faceCounts[3] = HXF_FACES_FRONT_OFFSET + drawingData->faceFrontCount - pieceDrawData->faceOffsets[3];
+        pieceDrawData->faceCounts[4] = HXF_FACES_RIGHT_OFFSET + drawingData->faceRightCount - pieceDrawData->faceOffsets[4];
+        pieceDrawData->faceCounts[5] = HXF_FACES_LEFT_OFFSET + drawingData->faceLeftCount - pieceDrawData->faceOffsets[5];
+
+        // Which sides of the piece can see each other, for the cave culling
+        if (game->pieceConnectivity) {
+            drawingData->pieceConnectivities[drawingData->pieceCount] = hxfWorldGetPieceConnectivity(worldPiece);
+        }
+
+        drawingData->pieceCount++;
+
         iterator = iterator->next;
     }
 }
@@ -88,7 +233,7 @@ void hxfGameInit(HxfGameData* restrict game) {
     game->cubeSelector = 1;
 
     char** worldpath = &game->world.directoryPath;
-    *worldpath = hxfMalloc(sizeof(char) * (strlen(game->appdataDirectory) + sizeof(WORLD_DIRECTORY)));
+    *worldpath = hxfMalloc(sizeof(char) * (strlen(game->appdataDirectory) + sizeof(WORLD_DIRECTORY)), HXF_ALLOC_IO);
     strcpy(*worldpath, game->appdataDirectory);
     strcat(*worldpath, WORLD_DIRECTORY);
 
@@ -117,17 +262,62 @@ void hxfGameStop(HxfGameData* restrict game) {
 }
 
 void hxfGameFrame(HxfGameData* restrict game) {
+    HXF_ZONE("game.frame");
+
     // Update the pointer
     hxfUpdatePointedCube(&game->camera, &game->world);
 
     // Update the world’s pieces
     if (hxfWorldUpdatePiece(&game->world, &game->camera.position)) {
         // Update the faces to draw if pieces were removed/added
+        game->camera.isPickValid = 0;
         updateDrawnFaces(game);
         hxfGraphicsUpdateCubeBuffer(game->graphics);
     }
 }
 
+void hxfGameBeginEdit(HxfGameData* restrict game) {
+    game->editDepth++;
+}
+
+void hxfGameCommitEdit(HxfGameData* restrict game) {
+    game->editDepth--;
+
+    if (game->editDepth == 0 && game->isEdited) {
+        HXF_ZONE("game.commitEdit");
+
+        game->isEdited = 0;
+        game->camera.isPickValid = 0;
+
+        updateDrawnFaces(game);
+        hxfGraphicsUpdateCubeBuffer(game->graphics);
+    }
+}
+
+void hxfGameFill(HxfGameData* restrict game, const HxfIvec3* restrict min, const HxfIvec3* restrict max, uint32_t textureIndex) {
+    hxfGameBeginEdit(game);
+    if (hxfWorldFill(&game->world, min, max, textureIndex) != 0) {
+        game->isEdited = 1;
+    }
+    hxfGameCommitEdit(game);
+}
+
+void hxfGameCarveSphere(HxfGameData* restrict game, const HxfVec3* restrict center, float radius) {
+    hxfGameBeginEdit(game);
+    if (hxfWorldCarveSphere(&game->world, center, radius) != 0) {
+        game->isEdited = 1;
+    }
+    hxfGameCommitEdit(game);
+}
+
+void hxfGamePaste(HxfGameData* restrict game, const HxfWorldStructure* restrict structure, const HxfIvec3* restrict position) {
+    hxfGameBeginEdit(game);
+    if (hxfWorldPaste(&game->world, structure, position) != 0) {
+        game->isEdited = 1;
+    }
+    hxfGameCommitEdit(game);
+}
+
 void hxfReplaceCube(HxfGameData* restrict game, const HxfIvec3* restrict position, uint32_t textureIndex) {
     // Replace the cube if it is inside a world piece that is loaded
 
@@ -136,9 +326,12 @@ void hxfReplaceCube(HxfGameData* restrict game, const HxfIvec3* restrict positio
 
     if (worldPieceElement != NULL) {
         HxfIvec3 localPosition = hxfWorldGetLocalPosition(position);
-        ((HxfWorldPiece*)worldPieceElement->value)->cubes[localPosition.x][localPosition.y][localPosition.z] = textureIndex;
 
-        updateDrawnFaces(game);
-        hxfGraphicsUpdateCubeBuffer(game->graphics);
+        hxfGameBeginEdit(game);
+        // The block of the piece can be shared with other pieces, it is copied before it changes
+        HxfWorldBlock* const block = hxfWorldGetWritableBlock(&game->world, worldPieceElement->value);
+        block->cubes[localPosition.x][localPosition.y][localPosition.z] = textureIndex;
+        game->isEdited = 1;
+        hxfGameCommitEdit(game);
     }
 }
\ No newline at end of file
@@ -11,6 +11,15 @@ typedef struct HxfGameData {
     HxfCamera camera; ///< The player’s camera.
     HxfWorld world; ///< The world that is made of cubes.
     uint32_t cubeSelector; ///< The texture index of the cube that will be placed.
+    uint32_t editDepth; ///< The number of hxfGameBeginEdit that are not committed yet.
+    int isEdited; ///< Set to 1 if cubes were changed since the first hxfGameBeginEdit.
+    /**
+     * @brief If set to 1, the connectivity of each piece is computed with its faces, for the cave culling.
+     *
+     * It is the requested cave culling while the world is loaded, as the graphics handler may
+     * disable it at the same time, then the cave culling that is actually used.
+     */
+    int pieceConnectivity;
 } HxfGameData;
 
 /**
@@ -28,9 +37,57 @@ void hxfGameStop(HxfGameData* restrict game);
  */
 void hxfGameFrame(HxfGameData* restrict game);
 
+/**
+ * @brief Begin a batch of cube changes.
+ *
+ * The faces to draw are only updated and uploaded once, by the hxfGameCommitEdit that ends the
+ * batch. The batches can be nested, the outermost one updates the faces.
+ *
+ * @param game The game where the cubes are.
+ */
+void hxfGameBeginEdit(HxfGameData* restrict game);
+
+/**
+ * @brief End a batch of cube changes, the faces are updated if it is the outermost batch and a
+ * cube changed.
+ *
+ * @param game The game where the cubes are.
+ */
+void hxfGameCommitEdit(HxfGameData* restrict game);
+
+/**
+ * @brief Set all the cubes of a box to a texture index (hxfWorldFill).
+ *
+ * @param game The game where the cubes are.
+ * @param min The cube of the box with the lowest coordinates.
+ * @param max The cube of the box with the highest coordinates, it is included in the box.
+ * @param textureIndex The texture index to set, 0 for air.
+ */
+void hxfGameFill(HxfGameData* restrict game, const HxfIvec3* restrict min, const HxfIvec3* restrict max, uint32_t textureIndex);
+
+/**
+ * @brief Replace the cubes inside a sphere by air (hxfWorldCarveSphere).
+ *
+ * @param game The game where the cubes are.
+ * @param center The center of the sphere.
+ * @param radius The radius of the sphere (in cubes).
+ */
+void hxfGameCarveSphere(HxfGameData* restrict game, const HxfVec3* restrict center, float radius);
+
+/**
+ * @brief Copy a structure into the world (hxfWorldPaste).
+ *
+ * @param game The game where the cubes are.
+ * @param structure The structure to copy.
+ * @param position The position of the first cube of the structure.
+ */
+void hxfGamePaste(HxfGameData* restrict game, const HxfWorldStructure* restrict structure, const HxfIvec3* restrict position);
+
 /**
  * @brief Replace the cube at the position by textureIndex.
  *
+ * Inside a batch (hxfGameBeginEdit), the faces are only updated when the batch is committed.
+ *
  * @param game The game where the cubes are.
  * @param position The position of the cube to replace.
  * @param textureIndex The texture index to set.
@@ -1,6 +1,7 @@
 #include "graphics-handler.h"
 #include "pipeline.h"
 #include "../hxf.h"
+#include "../profiler.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -18,6 +19,63 @@ typedef struct TextureImageInfo {
     int channels; ///< The number of channels of the image (red, blue, green, alpha...)
 } TextureImageInfo;
 
+/**
+ * @brief The width (x and z) of the grid that the cave culling flood fill goes through.
+ *
+ * It contains the loaded pieces surrounded by a layer of empty pieces, so that the pieces can be
+ * reached from outside of the world.
+ */
+#define CAVE_GRID_WIDTH (HXF_HORIZONTAL_VIEW_DISTANCE + 2)
+/**
+ * @brief The height (y) of the grid that the cave culling flood fill goes through.
+ */
+#define CAVE_GRID_HEIGHT (HXF_VERTICAL_VIEW_DISTANCE + 2)
+#define CAVE_GRID_CELL_COUNT CAVE_GRID_WIDTH * CAVE_GRID_HEIGHT * CAVE_GRID_WIDTH
+
+/**
+ * @brief The number of distance buckets the pieces are sorted in, the farthest pieces share the last one.
+ */
+#define PIECE_SORT_BUCKET_COUNT 128
+
+/**
+ * @brief The range of distances (in cubes) covered by each bucket of the piece sorting.
+ */
+#define PIECE_SORT_BUCKET_WIDTH 4.0f
+
+/**
+ * @brief The statistics counted by the pipeline statistics queries, their results are in the order of the bits.
+ */
+#define PIPELINE_STATISTICS (VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT \
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT \
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT)
+
+/**
+ * @brief The set of timestamps of the uploads, after the sets of the frames.
+ */
+#define UPLOAD_TIMESTAMP_SET HXF_MAX_RENDERED_FRAMES
+
+/**
+ * @brief The index of the first timestamp of a pass in the timestamp query pool, the second one follows it.
+ */
+#define GPU_TIMESTAMP_INDEX(set, pass) (2 * ((set) * HXF_GPU_PASS_COUNT + (pass)))
+
+/**
+ * @brief A step of the cave culling flood fill.
+ */
+typedef struct CaveCullingStep {
+    HxfIvec3 cell; ///< The cell of the grid that is entered.
+    int entrySide; ///< The side of the cell it is entered from, -1 for the camera’s cell.
+} CaveCullingStep;
+
+/**
+ * @brief The data shared by the worker tasks that record the pieces’ draw calls.
+ */
+typedef struct PieceGroupRecordData {
+    HxfGraphicsHandler* graphics; ///< The graphics handler, it is only read by the tasks.
+    uint32_t frameIndex; ///< The index of the frame that is recorded.
+    VkFramebuffer framebuffer; ///< The framebuffer the frame is rendered to.
+} PieceGroupRecordData;
+
 /*
 STATIC FORWARD DECLARATION
 */
@@ -43,6 +101,16 @@ static void createDevice(HxfGraphicsHandler* restrict graphics);
  */
 static void createSyncObjects(HxfGraphicsHandler* restrict graphics);
 
+#if defined(HXF_HEADLESS)
+/**
+ * @brief Create the offscreen images the frames are rendered to, instead of a swapchain.
+ *
+ * There is an image for each rendered frame, they are used as the swapchain images.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that will own them.
+ */
+static void createOffscreenImages(HxfGraphicsHandler* restrict graphics);
+#else
 /**
  * @brief Create the surface.
  *
@@ -59,6 +127,14 @@ static void createSurface(HxfGraphicsHandler* restrict graphics);
  * @param graphics A pointer to the HxfGraphicsHandler that will own it.
  */
 static void createSwapchain(HxfGraphicsHandler* restrict graphics);
+#endif
+
+/**
+ * @brief Create the buffer the captured frame is copied to.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that will own it.
+ */
+static void createCaptureBuffer(HxfGraphicsHandler* restrict graphics);
 
 /**
  * @brief Create the frame buffers in which the image views of the swapchain
@@ -84,6 +160,134 @@ static void createCommandBuffers(HxfGraphicsHandler* restrict graphics);
  */
 static void recordDrawCommandBuffer(HxfGraphicsHandler* restrict engine, uint32_t imageIndex, uint32_t currentFrameIndex);
 
+/**
+ * @brief Begin a secondary command buffer that continues the render pass.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the render pass.
+ * @param commandBuffer The secondary command buffer.
+ * @param framebuffer The framebuffer it will be used with, or VK_NULL_HANDLE if it is not known.
+ * @param flags Additional usage flags.
+ */
+static void beginSecondaryCommandBuffer(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkCommandBufferUsageFlags flags);
+
+/**
+ * @brief Bind the pipeline, the descriptor set and the buffers used to draw the cubes.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns them.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param currentFrameIndex The index of the frame that is currently rendered.
+ * @param pipeline The pipeline that draws the cubes, cubePipeline or cubePullingPipeline.
+ */
+static void bindCubeState(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex, VkPipeline pipeline);
+
+/**
+ * @brief Bind the cube state and record the draw calls of the cubes.
+ *
+ * With the depth prepass, the draw calls are first recorded with the depth prepass pipeline.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the cubes.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param currentFrameIndex The index of the frame that is currently rendered.
+ * @param firstPiece The first element of pieceDrawOrder that is drawn, when the pieces are drawn one by one.
+ * @param lastPiece The element after the last element of pieceDrawOrder that is drawn.
+ */
+static void recordCubePasses(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex, uint32_t firstPiece, uint32_t lastPiece);
+
+/**
+ * @brief Record the draw calls of the cubes with the pipeline that is bound.
+ *
+ * They are indirect with the GPU culling, per direction in the reuse mode and per piece otherwise.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the cubes.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param firstPiece The first element of pieceDrawOrder that is drawn, when the pieces are drawn one by one.
+ * @param lastPiece The element after the last element of pieceDrawOrder that is drawn.
+ */
+static void recordCubeDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t firstPiece, uint32_t lastPiece);
+
+/**
+ * @brief Record the indirect draw calls written by the cull compute shader.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the draw commands.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ */
+static void recordIndirectCubeDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer);
+
+/**
+ * @brief Record the draw calls of the faces of some pieces that can face the camera.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the pieces.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param firstPiece The first element of pieceDrawOrder that is drawn.
+ * @param lastPiece The element after the last element of pieceDrawOrder that is drawn.
+ */
+static void recordPieceDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t firstPiece, uint32_t lastPiece);
+
+/**
+ * @brief Record the draw calls of all the faces, without any culling.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the faces.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ */
+static void recordAllFacesDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer);
+
+/**
+ * @brief Record the draw calls of the pointed cube, the cube selector icon and the pointer.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns them.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param currentFrameIndex The index of the frame that is currently rendered.
+ */
+static void recordOverlayDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex);
+
+/**
+ * @brief Record the draw calls of a group of pieces in a secondary command buffer.
+ *
+ * It is run by the worker threads in the parallel recording mode.
+ *
+ * @param userData A pointer to the PieceGroupRecordData.
+ * @param groupIndex The index of the group, which is also the index of the command pool used.
+ */
+static void recordPieceGroup(void* userData, uint32_t groupIndex);
+
+/**
+ * @brief Record the dispatch of the cull compute shader that writes the indirect draw commands.
+ *
+ * It must be recorded outside of the render pass.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the cull pipeline.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ * @param currentFrameIndex The index of the frame that is currently rendered.
+ */
+static void recordCullCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex);
+
+/**
+ * @brief Record the commands that build the depth pyramid from the depth image.
+ *
+ * It must be recorded after the render pass. The depth pyramid is then used by the occlusion
+ * test of the next frame.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the depth pyramid.
+ * @param commandBuffer The command buffer in which the commands are recorded.
+ */
+static void recordDepthPyramidCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer);
+
+/**
+ * @brief Record the copy of a rendered image to the capture buffer.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler.
+ * @param commandBuffer The command buffer to record to, after the render pass.
+ * @param imageIndex The image that is copied.
+ */
+static void recordCaptureCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+/**
+ * @brief Write the content of the capture buffer to the capture path, as a PPM image.
+ *
+ * The frame that was copied to it must have been rendered.
+ */
+static void writeCaptureImage(HxfGraphicsHandler* restrict graphics);
+
 /**
  * @brief Transfer src buffer data to dst buffer.
  *
@@ -96,6 +300,30 @@ static void recordDrawCommandBuffer(HxfGraphicsHandler* restrict engine, uint32_
  */
 static void transferBuffers(HxfGraphicsHandler* restrict engine, VkBuffer src, VkBuffer dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size);
 
+/**
+ * @brief Write the timestamp at the beginning or at the end of a pass, if the GPU timings are enabled.
+ *
+ * @param timestampSet The frame index, or UPLOAD_TIMESTAMP_SET for the uploads.
+ * @param isEnd 0 for the beginning of the pass, 1 for its end.
+ */
+static void writeGpuTimestamp(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t timestampSet, HxfGpuPass pass, int isEnd);
+
+/**
+ * @brief Read back the GPU duration of a pass, without waiting for it.
+ *
+ * @param firstQuery The index of the timestamp at the beginning of the pass.
+ *
+ * @return The duration in seconds, or -1 if the timestamps of the pass were not written.
+ */
+static double readGpuDuration(HxfGraphicsHandler* restrict graphics, uint32_t firstQuery);
+
+/**
+ * @brief Read back the GPU durations of the passes of a frame whose queries are complete.
+ *
+ * @param frameIndex The index of the frame in flight (the timestamp set).
+ */
+static void readFrameTimings(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex);
+
 /**
  * @brief Determine the highest vulkan API version available.
  *
@@ -110,6 +338,14 @@ static uint32_t determineApiVersion();
  */
 static void getVulkanLimits(HxfGraphicsHandler* restrict graphics);
 
+/**
+ * @brief Disable the options that can not be used together.
+ *
+ * It runs once the options the device does not support are disabled, so that the options are
+ * checked against the ones that are actually used, and before anything depends on them.
+ */
+static void checkOptions(HxfGraphicsHandler* restrict graphics);
+
 /**
  * @brief Create the depth image.
  *
@@ -146,18 +382,44 @@ static void createTextureSampler(HxfGraphicsHandler* restrict graphics);
 static void createRessources(HxfGraphicsHandler* restrict graphics);
 
 /**
- * @brief Update the buffer that contains the model-view-projection matrices
+ * @brief Write the view-projection matrix and the pointed cube in the data of a frame.
+ *
+ * The frame must not be in use by the device.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that own the frame data.
+ * @param frameIndex The index of the frame.
+ */
+static void updateFrameData(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex);
+
+/**
+ * @brief Read the occlusion counters of a rendered frame and write the data of its next use.
+ *
+ * The frame must not be in use by the device.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that own the occlusion data.
+ * @param frameIndex The index of the frame.
+ */
+static void updateOcclusionData(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex);
+
+/**
+ * @brief Find the pieces that may be seen from the camera with a flood fill through the pieces’ air.
+ *
+ * The flood fill starts from the camera’s piece and only goes away from it. It can only
+ * cross a piece between two sides that are connected.
  *
- * @param graphics A pointer to the HxfGraphicsHandler that own the buffer.
+ * @param graphics A pointer to the HxfGraphicsHandler that own the pieces.
  */
-static void updateMvpBuffer(HxfGraphicsHandler* restrict graphics);
+static void updateVisiblePieces(HxfGraphicsHandler* restrict graphics);
 
 /**
- * @brief Update the buffer that hold the pointed cube.
+ * @brief Update the order in which the pieces are drawn.
  *
- * @param graphics A pointer to the HxfGraphicsHandler that hold them.
+ * With the piece sorting, the pieces are sorted by their distance to the camera with a bucket
+ * sort, otherwise they are drawn in the order of the pieces array.
+ *
+ * @param graphics A pointer to the HxfGraphicsHandler that owns the pieces.
  */
-static void updatePointedCubeBuffer(HxfGraphicsHandler* restrict graphics);
+static void updatePieceDrawOrder(HxfGraphicsHandler* restrict graphics);
 
 /**
  * @brief Return the extensions that are required for the Vulkan instance.
@@ -170,14 +432,6 @@ static void updatePointedCubeBuffer(HxfGraphicsHandler* restrict graphics);
  */
 static void getRequiredInstanceExtensions(char*** restrict extensions, int* restrict count);
 
-/**
- * @brief Return the memory type index of a device memory that has exactly the same properties as memoryProperties.
- *
- * @param deviceProperties A pointer to a VkPhysicalDeviceMemoryProperties of the physical device.
- * @param memoryProperties A VkMemoryPropertyFlags containing the required properties.
- */
-static uint32_t getMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties* restrict deviceProperties, VkMemoryPropertyFlags memoryProperties);
-
 #if defined(HXF_VALIDATION_LAYERS)
 /**
  * @brief The debug messenger callback used to print debug message during vkCreateInstance and
@@ -229,6 +483,12 @@ static void getVulkanLimits(HxfGraphicsHandler* restrict graphics) {
     vkGetPhysicalDeviceMemoryProperties(graphics->physicalDevice, &graphics->physicalDeviceMemoryProperties);
 
     graphics->physicalDeviceLimits = props.limits;
+
+    // The vertex pulling reads all the cube instances through a single storage buffer
+    if (graphics->vertexPulling && HXF_CUBE_INSTANCES_SIZE > graphics->physicalDeviceLimits.maxStorageBufferRange) {
+        HXF_MSG_ERROR("The cube instances do not fit in a storage buffer, the vertex pulling is disabled");
+        graphics->vertexPulling = 0;
+    }
 }
 
 static void createInstance(HxfGraphicsHandler* restrict graphics) {
@@ -253,10 +513,11 @@ static void createInstance(HxfGraphicsHandler* restrict graphics) {
     VkExtensionProperties* extensionsProperties = NULL;
 
     vkEnumerateInstanceExtensionProperties(NULL, &count, NULL);
-    extensionsProperties = hxfMalloc(count * sizeof(VkExtensionProperties));
+    extensionsProperties = hxfMalloc(count * sizeof(VkExtensionProperties), HXF_ALLOC_GRAPHICS);
     vkEnumerateInstanceExtensionProperties(NULL, &count, extensionsProperties);
 
-    int isUnavailable = 1;
+    // Nothing is unavailable if no extension is required, as in the headless build
+    int isUnavailable = requiredExtensionsCount != 0;
     int i = requiredExtensionsCount - 1;
 
     while (i != -1 && isUnavailable) {
@@ -279,7 +540,7 @@ static void createInstance(HxfGraphicsHandler* restrict graphics) {
 #if defined(HXF_VALIDATION_LAYERS)
     // Test that the validation layer is available
     vkEnumerateInstanceLayerProperties(&count, NULL);
-    VkLayerProperties* layerProperties = hxfMalloc(count * sizeof(VkLayerProperties));
+    VkLayerProperties* layerProperties = hxfMalloc(count * sizeof(VkLayerProperties), HXF_ALLOC_GRAPHICS);
     vkEnumerateInstanceLayerProperties(&count, layerProperties);
 
     const char* const validationLayers[] = { "VK_LAYER_KHRONOS_validation" };
@@ -305,7 +566,7 @@ static void createInstance(HxfGraphicsHandler* restrict graphics) {
 
     // Test that the debug utils extension is available
     vkEnumerateInstanceExtensionProperties(validationLayers[0], &count, NULL);
-    VkExtensionProperties* extensionProperties = hxfMalloc(count * sizeof(VkExtensionProperties));
+    VkExtensionProperties* extensionProperties = hxfMalloc(count * sizeof(VkExtensionProperties), HXF_ALLOC_GRAPHICS);
     vkEnumerateInstanceExtensionProperties(validationLayers[0], &count, extensionProperties);
 
     i = count - 1;
@@ -325,7 +586,7 @@ static void createInstance(HxfGraphicsHandler* restrict graphics) {
 
     // Add the debug utils extension to the required extensions
     requiredExtensionsCount += 1;
-    requiredExtensions = hxfRealloc(requiredExtensions, requiredExtensionsCount * sizeof(char*));
+    requiredExtensions = hxfRealloc(requiredExtensions, requiredExtensionsCount * sizeof(char*), HXF_ALLOC_GRAPHICS);
     requiredExtensions[requiredExtensionsCount - 1] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
 
     info.enabledExtensionCount = (uint32_t)requiredExtensionsCount;
@@ -362,7 +623,7 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
     }
 
     // Take the first device
-    VkPhysicalDevice* physicalDevices = hxfMalloc(count * sizeof(VkPhysicalDevice));
+    VkPhysicalDevice* physicalDevices = hxfMalloc(count * sizeof(VkPhysicalDevice), HXF_ALLOC_GRAPHICS);
     vkEnumeratePhysicalDevices(graphics->instance, &count, physicalDevices);
     graphics->physicalDevice = physicalDevices[0];
     hxfFree(physicalDevices);
@@ -376,12 +637,17 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
     };
 
     vkGetPhysicalDeviceQueueFamilyProperties(graphics->physicalDevice, &count, NULL);
-    VkQueueFamilyProperties* props = hxfMalloc(count * sizeof(VkQueueFamilyProperties));
+    VkQueueFamilyProperties* props = hxfMalloc(count * sizeof(VkQueueFamilyProperties), HXF_ALLOC_GRAPHICS);
     vkGetPhysicalDeviceQueueFamilyProperties(graphics->physicalDevice, &count, props);
+    // The cull compute shader is dispatched on the graphics queue
+    const VkQueueFlags requiredQueueFlags = graphics->gpuCulling
+        ? VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT
+        : VK_QUEUE_GRAPHICS_BIT;
+
     int queueNotFound = 1;
     int i = count - 1;
     while (i != -1 && queueNotFound) {
-        if (props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        if ((props[i].queueFlags & requiredQueueFlags) == requiredQueueFlags) {
             queueNotFound = 0;
             queueInfo.queueFamilyIndex = i;
             graphics->graphicsQueueFamilyIndex = i;
@@ -389,6 +655,15 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
         i--;
     }
 
+    // The timestamps are written in the graphics queue
+    if (!queueNotFound) {
+        graphics->timestampValidBits = props[graphics->graphicsQueueFamilyIndex].timestampValidBits;
+    }
+    if (graphics->gpuTimings && !queueNotFound && graphics->timestampValidBits == 0) {
+        HXF_MSG_ERROR("The graphics queue does not support the timestamps, the GPU timings are disabled");
+        graphics->gpuTimings = 0;
+    }
+
     hxfFree(props);
 
     if (queueNotFound) {
@@ -396,11 +671,17 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
     }
 
     // Verify the extensions are available
+#if defined(HXF_HEADLESS)
+    // Nothing is presented
+    const char* const* enabledExtensions = NULL;
+    const uint32_t enabledExtensionCount = 0;
+#else
     const char* const enabledExtensions[] = { "VK_KHR_swapchain" };
     const uint32_t enabledExtensionCount = 1;
+#endif
 
     vkEnumerateDeviceExtensionProperties(graphics->physicalDevice, NULL, &count, NULL);
-    VkExtensionProperties* extensionProperties = hxfMalloc(count * sizeof(VkExtensionProperties));
+    VkExtensionProperties* extensionProperties = hxfMalloc(count * sizeof(VkExtensionProperties), HXF_ALLOC_GRAPHICS);
     vkEnumerateDeviceExtensionProperties(graphics->physicalDevice, NULL, &count, extensionProperties);
 
     i = enabledExtensionCount - 1;
@@ -429,6 +710,42 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
         HXF_FATAL("Not all the required device extensions are available");
     }
 
+    // Enable the features needed by the GPU culling, or disable it if they are unavailable
+    VkPhysicalDeviceFeatures supportedFeatures;
+    VkPhysicalDeviceFeatures enabledFeatures = { 0 };
+    vkGetPhysicalDeviceFeatures(graphics->physicalDevice, &supportedFeatures);
+
+    if (graphics->gpuCulling) {
+        if (supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance) {
+            enabledFeatures.multiDrawIndirect = VK_TRUE;
+            enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+        }
+        else {
+            HXF_MSG_ERROR("The device does not support the GPU culling, it is disabled");
+            graphics->gpuCulling = 0;
+        }
+    }
+
+    // The occlusion test is done by the cull compute shader
+    if (graphics->occlusionCulling && !graphics->gpuCulling) {
+        HXF_MSG_ERROR("The occlusion culling needs the GPU culling, it is disabled");
+        graphics->occlusionCulling = 0;
+    }
+
+    // The query also has to be inherited when the cubes are drawn by secondary command buffers
+    if (graphics->pipelineStatistics) {
+        const int needsInheritedQueries = graphics->commandBufferMode != HXF_COMMAND_BUFFER_RECORD;
+
+        if (supportedFeatures.pipelineStatisticsQuery && (!needsInheritedQueries || supportedFeatures.inheritedQueries)) {
+            enabledFeatures.pipelineStatisticsQuery = VK_TRUE;
+            enabledFeatures.inheritedQueries = needsInheritedQueries ? VK_TRUE : VK_FALSE;
+        }
+        else {
+            HXF_MSG_ERROR("The device does not support the pipeline statistics queries, they are disabled");
+            graphics->pipelineStatistics = 0;
+        }
+    }
+
     // Create the logical device
     VkDeviceCreateInfo deviceInfo = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -436,6 +753,7 @@ static void createDevice(HxfGraphicsHandler* restrict graphics) {
         .pQueueCreateInfos = &queueInfo,
         .enabledExtensionCount = enabledExtensionCount,
         .ppEnabledExtensionNames = enabledExtensions,
+        .pEnabledFeatures = &enabledFeatures,
     };
 
     HXF_TRY_VK(vkCreateDevice(graphics->physicalDevice, &deviceInfo, NULL, &graphics->device));
@@ -462,9 +780,80 @@ static void createCommandBuffers(HxfGraphicsHandler* restrict graphics) {
         .commandBufferCount = sizeof(graphics->commandBuffers) / sizeof(VkCommandBuffer)
     };
     HXF_TRY_VK(vkAllocateCommandBuffers(graphics->device, &allocInfo, graphics->commandBuffers));
+
+    if (graphics->pipelineStatistics) {
+        VkQueryPoolCreateInfo queryPoolInfo = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+            .queryCount = HXF_MAX_RENDERED_FRAMES,
+            .pipelineStatistics = PIPELINE_STATISTICS,
+        };
+        HXF_TRY_VK(vkCreateQueryPool(graphics->device, &queryPoolInfo, NULL, &graphics->statisticsQueryPool));
+
+        for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+            graphics->isStatisticsQueryWritten[i] = 0;
+        }
+    }
+
+    if (graphics->gpuTimings) {
+        VkQueryPoolCreateInfo queryPoolInfo = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = GPU_TIMESTAMP_INDEX(UPLOAD_TIMESTAMP_SET + 1, 0),
+        };
+        HXF_TRY_VK(vkCreateQueryPool(graphics->device, &queryPoolInfo, NULL, &graphics->timestampQueryPool));
+
+        for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+            graphics->isTimestampQueryWritten[i] = 0;
+        }
+        // The uploads are only measured once the cubes or the icons are updated
+        for (int i = 0; i != HXF_GPU_PASS_COUNT; i++) {
+            graphics->gpuPassDurations[i] = -1.0;
+        }
+    }
+
+    if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_RECORD) {
+        return;
+    }
+
+    // The secondary command buffers recorded on the main thread
+
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = HXF_MAX_RENDERED_FRAMES;
+    HXF_TRY_VK(vkAllocateCommandBuffers(graphics->device, &allocInfo, graphics->overlayCommandBuffers));
+
+    if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_REUSE) {
+        HXF_TRY_VK(vkAllocateCommandBuffers(graphics->device, &allocInfo, graphics->cubeCommandBuffers));
+
+        // Nothing is recorded yet
+        graphics->cubeVersion = 1;
+        for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+            graphics->cubeCommandBufferVersions[i] = 0;
+        }
+    }
+    else {
+        // A command pool must only be used by one thread at a time, so each worker task has
+        // its own command pools, one for each frame so that they can be reset as a whole
+
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        allocInfo.commandBufferCount = 1;
+
+        for (int i = 0; i != HXF_RECORD_THREAD_COUNT; i++) {
+            for (int j = 0; j != HXF_MAX_RENDERED_FRAMES; j++) {
+                HXF_TRY_VK(vkCreateCommandPool(graphics->device, &poolInfo, NULL, &graphics->recordCommandPools[i][j]));
+
+                allocInfo.commandPool = graphics->recordCommandPools[i][j];
+                HXF_TRY_VK(vkAllocateCommandBuffers(graphics->device, &allocInfo, &graphics->recordCommandBuffers[i][j]));
+            }
+        }
+
+        hxfThreadPoolCreate(&graphics->recordThreadPool, HXF_RECORD_THREAD_COUNT);
+    }
 }
 
 static void recordDrawCommandBuffer(HxfGraphicsHandler* restrict graphics, uint32_t imageIndex, uint32_t currentFrameIndex) {
+    const VkCommandBuffer commandBuffer = graphics->drawCommandBuffers[currentFrameIndex];
+
     VkCommandBufferBeginInfo beginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
     };
@@ -486,12 +875,133 @@ static void recordDrawCommandBuffer(HxfGraphicsHandler* restrict graphics, uint3
         .framebuffer = graphics->swapchainFramebuffers[imageIndex],
     };
 
-    HXF_TRY_VK(vkBeginCommandBuffer(graphics->drawCommandBuffers[currentFrameIndex], &beginInfo));
+    HXF_TRY_VK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+    // The frame is measured from its first command to its last one. All the timestamps of the
+    // frame are reset, so the passes that do not run are read back as not written
+    if (graphics->gpuTimings) {
+        vkCmdResetQueryPool(commandBuffer, graphics->timestampQueryPool, GPU_TIMESTAMP_INDEX(currentFrameIndex, 0), 2 * HXF_GPU_PASS_COUNT);
+    }
+    writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_FRAME, 0);
+
+    if (graphics->gpuCulling) {
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_CULL, 0);
+        recordCullCommands(graphics, commandBuffer, currentFrameIndex);
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_CULL, 1);
+    }
+
+    // Only the draw calls of the render pass are counted
+    if (graphics->pipelineStatistics) {
+        vkCmdResetQueryPool(commandBuffer, graphics->statisticsQueryPool, currentFrameIndex, 1);
+        vkCmdBeginQuery(commandBuffer, graphics->statisticsQueryPool, currentFrameIndex, 0);
+    }
+
+    if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_RECORD) {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_CUBES, 0);
+        recordCubePasses(graphics, commandBuffer, currentFrameIndex, 0, graphics->drawingData.pieceCount);
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_CUBES, 1);
+
+        recordOverlayDraws(graphics, commandBuffer, currentFrameIndex);
+    }
+    else {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        VkCommandBuffer secondaryCommandBuffers[HXF_RECORD_THREAD_COUNT + 1];
+        uint32_t secondaryCommandBufferCount = 0;
+
+        if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_REUSE) {
+            // Only record the cubes again if they changed since the last time
+            const VkCommandBuffer cubeCommandBuffer = graphics->cubeCommandBuffers[currentFrameIndex];
+
+            if (graphics->cubeCommandBufferVersions[currentFrameIndex] != graphics->cubeVersion) {
+                vkResetCommandBuffer(cubeCommandBuffer, 0);
+
+                // No framebuffer, as it is used with all the swapchain images
+                beginSecondaryCommandBuffer(graphics, cubeCommandBuffer, VK_NULL_HANDLE, 0);
+                writeGpuTimestamp(graphics, cubeCommandBuffer, currentFrameIndex, HXF_GPU_PASS_CUBES, 0);
+                recordCubePasses(graphics, cubeCommandBuffer, currentFrameIndex, 0, graphics->drawingData.pieceCount);
+                writeGpuTimestamp(graphics, cubeCommandBuffer, currentFrameIndex, HXF_GPU_PASS_CUBES, 1);
+                HXF_TRY_VK(vkEndCommandBuffer(cubeCommandBuffer));
+
+                graphics->cubeCommandBufferVersions[currentFrameIndex] = graphics->cubeVersion;
+            }
+
+            secondaryCommandBuffers[secondaryCommandBufferCount++] = cubeCommandBuffer;
+        }
+        else {
+            // Each worker task records a group of pieces
+            PieceGroupRecordData recordData = {
+                .graphics = graphics,
+                .frameIndex = currentFrameIndex,
+                .framebuffer = graphics->swapchainFramebuffers[imageIndex]
+            };
+            hxfThreadPoolRun(&graphics->recordThreadPool, recordPieceGroup, &recordData, HXF_RECORD_THREAD_COUNT);
+
+            for (int i = 0; i != HXF_RECORD_THREAD_COUNT; i++) {
+                secondaryCommandBuffers[secondaryCommandBufferCount++] = graphics->recordCommandBuffers[i][currentFrameIndex];
+            }
+        }
+
+        // The pointed cube, the icon and the pointer change every frame
+
+        const VkCommandBuffer overlayCommandBuffer = graphics->overlayCommandBuffers[currentFrameIndex];
+        vkResetCommandBuffer(overlayCommandBuffer, 0);
+        beginSecondaryCommandBuffer(graphics, overlayCommandBuffer, graphics->swapchainFramebuffers[imageIndex], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        recordOverlayDraws(graphics, overlayCommandBuffer, currentFrameIndex);
+        HXF_TRY_VK(vkEndCommandBuffer(overlayCommandBuffer));
+        secondaryCommandBuffers[secondaryCommandBufferCount++] = overlayCommandBuffer;
+
+        vkCmdExecuteCommands(commandBuffer, secondaryCommandBufferCount, secondaryCommandBuffers);
+    }
+
+    vkCmdEndRenderPass(commandBuffer);
+
+    if (graphics->pipelineStatistics) {
+        vkCmdEndQuery(commandBuffer, graphics->statisticsQueryPool, currentFrameIndex);
+        graphics->isStatisticsQueryWritten[currentFrameIndex] = 1;
+    }
+
+    if (graphics->occlusionCulling) {
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_DEPTH_PYRAMID, 0);
+        recordDepthPyramidCommands(graphics, commandBuffer);
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_DEPTH_PYRAMID, 1);
+    }
+
+    if (graphics->capturePath != NULL && graphics->frameCount == graphics->captureFrame) {
+        recordCaptureCommands(graphics, commandBuffer, imageIndex);
+    }
+
+    if (graphics->gpuTimings) {
+        writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_FRAME, 1);
+        graphics->isTimestampQueryWritten[currentFrameIndex] = 1;
+    }
+
+    HXF_TRY_VK(vkEndCommandBuffer(commandBuffer));
+}
+
+static void beginSecondaryCommandBuffer(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkCommandBufferUsageFlags flags) {
+    VkCommandBufferInheritanceInfo inheritanceInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = graphics->renderPass,
+        .subpass = 0,
+        .framebuffer = framebuffer,
+        // The statistics query of the primary command buffer continues in the secondary ones
+        .pipelineStatistics = graphics->pipelineStatistics ? PIPELINE_STATISTICS : 0,
+    };
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags,
+        .pInheritanceInfo = &inheritanceInfo,
+    };
+    HXF_TRY_VK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+}
 
-    vkCmdBeginRenderPass(graphics->drawCommandBuffers[currentFrameIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(graphics->drawCommandBuffers[currentFrameIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->cubePipeline);
+static void bindCubeState(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex, VkPipeline pipeline) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     vkCmdBindDescriptorSets(
-        graphics->drawCommandBuffers[currentFrameIndex],
+        commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         graphics->cubePipelineLayout,
         0, 1, &graphics->cubeDescriptorSets[currentFrameIndex],
@@ -502,63 +1012,431 @@ static void recordDrawCommandBuffer(HxfGraphicsHandler* restrict graphics, uint3
         graphics->drawingData.deviceBuffer
     };
     VkDeviceSize offsets[] = {
-        graphics->drawingData.cubesVerticesOffset - graphics->drawingData.deviceBufferOffset,
-        graphics->drawingData.cubeInstancesOffset - graphics->drawingData.deviceBufferOffset
+        graphics->drawingData.cubesVerticesOffset,
+        graphics->drawingData.cubeInstancesOffset
     };
-    vkCmdBindVertexBuffers(graphics->drawCommandBuffers[currentFrameIndex], 0, 2, boundBuffers, offsets);
-    vkCmdBindIndexBuffer(graphics->drawCommandBuffers[currentFrameIndex], graphics->drawingData.deviceBuffer, graphics->drawingData.cubesVertexIndicesOffset - graphics->drawingData.deviceBufferOffset, VK_INDEX_TYPE_UINT32);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, boundBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, graphics->drawingData.deviceBuffer, graphics->drawingData.cubesVertexIndicesOffset, VK_INDEX_TYPE_UINT32);
+}
 
-    // The pointed cube
+static void recordCubePasses(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex, uint32_t firstPiece, uint32_t lastPiece) {
+    const VkPipeline cubePipeline = graphics->vertexPulling ? graphics->cubePullingPipeline : graphics->cubePipeline;
+    bindCubeState(graphics, commandBuffer, currentFrameIndex, cubePipeline);
 
-    if (graphics->camera->isPointingToCube) {
-        vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], HXF_CUBE_VERTEX_INDEX_COUNT, 1, 0, 0, HXF_CUBE_INSTANCE_COUNT * 6);
+    if (graphics->depthPrepass) {
+        // The same draw calls only write the depth, then the cubes are only shaded where they
+        // are visible
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->depthPrepassPipeline);
+        recordCubeDraws(graphics, commandBuffer, firstPiece, lastPiece);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, cubePipeline);
     }
 
-    // All the cubes
-    // (A draw call for each faces)
-
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceTopCount, 0, 0, HXF_FACES_TOP_OFFSET);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceBackCount, 6, 0, HXF_FACES_BACK_OFFSET);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceBottomCount, 12, 0, HXF_FACES_BOTTOM_OFFSET);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceFrontCount, 18, 0, HXF_FACES_FRONT_OFFSET);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceRightCount, 24, 0, HXF_FACES_RIGHT_OFFSET);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], 6, graphics->drawingData.faceLeftCount, 30, 0, HXF_FACES_LEFT_OFFSET);
-
-    // The cube selector icon
+    recordCubeDraws(graphics, commandBuffer, firstPiece, lastPiece);
+}
 
-    vkCmdBindPipeline(graphics->drawCommandBuffers[currentFrameIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->iconPipeline);
-    vkCmdBindDescriptorSets(
-        graphics->drawCommandBuffers[currentFrameIndex],
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        graphics->iconPipelineLayout,
-        0, 1, &graphics->iconDescriptorSets[currentFrameIndex],
-        0, NULL
-    );
-    offsets[0] = graphics->drawingData.iconVerticesOffset - graphics->drawingData.deviceBufferOffset;
-    offsets[1] = graphics->drawingData.iconInstancesOffset - graphics->drawingData.deviceBufferOffset;
-    vkCmdBindVertexBuffers(graphics->drawCommandBuffers[currentFrameIndex], 0, 2, boundBuffers, offsets);
-    vkCmdBindIndexBuffer(graphics->commandBuffers[currentFrameIndex], graphics->drawingData.deviceBuffer, graphics->drawingData.iconVertexIndicesOffset - graphics->drawingData.deviceBufferOffset, VK_INDEX_TYPE_UINT32);
-    HxfIconPushConstantData iconPushConstant = {
-        graphics->mainWindow->width,
-        graphics->mainWindow->height
-    };
-    vkCmdPushConstants(graphics->drawCommandBuffers[currentFrameIndex], graphics->iconPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(HxfIconPushConstantData), &iconPushConstant);
-    vkCmdDrawIndexed(graphics->drawCommandBuffers[currentFrameIndex], HXF_ICON_VERTEX_INDEX_COUNT, 1, 0, 0, 0);
+static void recordCubeDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t firstPiece, uint32_t lastPiece) {
+    if (graphics->gpuCulling) {
+        recordIndirectCubeDraws(graphics, commandBuffer);
+    }
+    else if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_REUSE) {
+        recordAllFacesDraws(graphics, commandBuffer);
+    }
+    else {
+        recordPieceDraws(graphics, commandBuffer, firstPiece, lastPiece);
+    }
+}
 
-    // The pointer
+static void recordIndirectCubeDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer) {
+    // A draw call for each faces of each pieces, written by the cull compute shader
+    if (graphics->vertexPulling) {
+        // The commands are VkDrawIndirectCommand, with the stride of the indexed ones
+        vkCmdDrawIndirect(
+            commandBuffer,
+            graphics->drawingData.deviceBuffer,
+            graphics->drawingData.drawCommandsOffset,
+            graphics->drawingData.pieceCount * HXF_FACE_DIRECTION_COUNT,
+            sizeof(VkDrawIndexedIndirectCommand)
+        );
+    }
+    else {
+        vkCmdDrawIndexedIndirect(
+            commandBuffer,
+            graphics->drawingData.deviceBuffer,
+            graphics->drawingData.drawCommandsOffset,
+            graphics->drawingData.pieceCount * HXF_FACE_DIRECTION_COUNT,
+            sizeof(VkDrawIndexedIndirectCommand)
+        );
+    }
+}
 
-    vkCmdBindPipeline(graphics->drawCommandBuffers[currentFrameIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->pointerPipeline);
-    HxfPointerPushConstantData HxfPointerPushConstantData = {
-        graphics->mainWindow->width,
-        graphics->mainWindow->height
-    };
-    vkCmdPushConstants(graphics->drawCommandBuffers[currentFrameIndex], graphics->pointerPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(HxfPointerPushConstantData), &iconPushConstant);
-    vkCmdDraw(graphics->drawCommandBuffers[currentFrameIndex], HXF_POINTER_VERTEX_COUNT, 1, 0, 0);
+static void recordPieceDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t firstPiece, uint32_t lastPiece) {
+    // A draw call for each faces direction of each pieces, except the directions that
+    // can not face the camera
+    for (uint32_t i = firstPiece; i != lastPiece; i++) {
+        const uint32_t pieceIndex = graphics->drawingData.pieceDrawOrder[i];
+        const HxfPieceDrawData* const piece = &graphics->drawingData.pieces[pieceIndex];
+        if (graphics->caveCulling && !graphics->drawingData.isPieceVisible[pieceIndex]) {
+            continue;
+        }
 
-    vkCmdEndRenderPass(graphics->drawCommandBuffers[currentFrameIndex]);
+        const uint32_t visibleDirections = hxfGetVisibleFaceDirections(&piece->position, &graphics->camera->position);
 
-    HXF_TRY_VK(vkEndCommandBuffer(graphics->drawCommandBuffers[currentFrameIndex]));
-}
+        for (uint32_t direction = 0; direction != HXF_FACE_DIRECTION_COUNT; direction++) {
+            if ((visibleDirections & (1 << direction)) && piece->faceCounts[direction] != 0) {
+                if (graphics->vertexPulling) {
+                    vkCmdDraw(commandBuffer, 6 * piece->faceCounts[direction], 1, 6 * piece->faceOffsets[direction], 0);
+                }
+                else {
+                    vkCmdDrawIndexed(commandBuffer, 6, piece->faceCounts[direction], direction * 6, 0, piece->faceOffsets[direction]);
+                }
+            }
+        }
+    }
+}
+
+static void recordAllFacesDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer) {
+    // The faces of a direction are contiguous, so a draw call for each direction is enough
+    const size_t faceCounts[HXF_FACE_DIRECTION_COUNT] = {
+        graphics->drawingData.faceTopCount,
+        graphics->drawingData.faceBackCount,
+        graphics->drawingData.faceBottomCount,
+        graphics->drawingData.faceFrontCount,
+        graphics->drawingData.faceRightCount,
+        graphics->drawingData.faceLeftCount
+    };
+
+    for (uint32_t direction = 0; direction != HXF_FACE_DIRECTION_COUNT; direction++) {
+        if (faceCounts[direction] != 0) {
+            if (graphics->vertexPulling) {
+                vkCmdDraw(commandBuffer, 6 * faceCounts[direction], 1, 6 * direction * HXF_CUBE_INSTANCE_COUNT, 0);
+            }
+            else {
+                vkCmdDrawIndexed(commandBuffer, 6, faceCounts[direction], direction * 6, 0, direction * HXF_CUBE_INSTANCE_COUNT);
+            }
+        }
+    }
+}
+
+static void recordOverlayDraws(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex) {
+    // The pointed cube
+
+    // It is an instance, so it is always drawn by the cube pipeline
+    if (graphics->camera->isPointingToCube) {
+        bindCubeState(graphics, commandBuffer, currentFrameIndex, graphics->cubePipeline);
+
+        // Its instance is in the frame’s data
+        const VkDeviceSize pointedCubeOffset = graphics->drawingData.frameDataOffset
+            + currentFrameIndex * graphics->drawingData.frameDataSize + offsetof(HxfFrameData, pointedCube);
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &graphics->drawingData.hostBuffer, &pointedCubeOffset);
+        vkCmdDrawIndexed(commandBuffer, HXF_CUBE_VERTEX_INDEX_COUNT, 1, 0, 0, 0);
+    }
+
+    // The cube selector icon
+
+    writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_ICON, 0);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->iconPipeline);
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        graphics->iconPipelineLayout,
+        0, 1, &graphics->iconDescriptorSets[currentFrameIndex],
+        0, NULL
+    );
+    VkBuffer boundBuffers[] = {
+        graphics->drawingData.deviceBuffer,
+        graphics->drawingData.deviceBuffer
+    };
+    VkDeviceSize offsets[] = {
+        graphics->drawingData.iconVerticesOffset,
+        graphics->drawingData.iconInstancesOffset
+    };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, boundBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, graphics->drawingData.deviceBuffer, graphics->drawingData.iconVertexIndicesOffset, VK_INDEX_TYPE_UINT32);
+    HxfIconPushConstantData iconPushConstant = {
+        graphics->mainWindow->width,
+        graphics->mainWindow->height
+    };
+    vkCmdPushConstants(commandBuffer, graphics->iconPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(HxfIconPushConstantData), &iconPushConstant);
+    vkCmdDrawIndexed(commandBuffer, HXF_ICON_VERTEX_INDEX_COUNT, 1, 0, 0, 0);
+    writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_ICON, 1);
+
+    // The pointer
+
+    writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_POINTER, 0);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->pointerPipeline);
+    HxfPointerPushConstantData pointerPushConstant = {
+        graphics->mainWindow->width,
+        graphics->mainWindow->height
+    };
+    vkCmdPushConstants(commandBuffer, graphics->pointerPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(HxfPointerPushConstantData), &pointerPushConstant);
+    vkCmdDraw(commandBuffer, HXF_POINTER_VERTEX_COUNT, 1, 0, 0);
+    writeGpuTimestamp(graphics, commandBuffer, currentFrameIndex, HXF_GPU_PASS_POINTER, 1);
+}
+
+static void recordPieceGroup(void* userData, uint32_t groupIndex) {
+    HXF_ZONE("graphics.recordPieceGroup");
+
+    const PieceGroupRecordData* const recordData = userData;
+    HxfGraphicsHandler* const graphics = recordData->graphics;
+    const uint32_t pieceCount = graphics->drawingData.pieceCount;
+    const uint32_t groupSize = (pieceCount + HXF_RECORD_THREAD_COUNT - 1) / HXF_RECORD_THREAD_COUNT;
+    const uint32_t firstPiece = groupIndex * groupSize < pieceCount ? groupIndex * groupSize : pieceCount;
+    const uint32_t lastPiece = firstPiece + groupSize < pieceCount ? firstPiece + groupSize : pieceCount;
+
+    // The command pool is only used by this task for this frame, and the frame is not in use
+    // by the device anymore
+    HXF_TRY_VK(vkResetCommandPool(graphics->device, graphics->recordCommandPools[groupIndex][recordData->frameIndex], 0));
+
+    const VkCommandBuffer commandBuffer = graphics->recordCommandBuffers[groupIndex][recordData->frameIndex];
+    beginSecondaryCommandBuffer(graphics, commandBuffer, recordData->framebuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    // The groups are executed in order, so the cubes begin in the first one and end in the last one
+    if (groupIndex == 0) {
+        writeGpuTimestamp(graphics, commandBuffer, recordData->frameIndex, HXF_GPU_PASS_CUBES, 0);
+    }
+    recordCubePasses(graphics, commandBuffer, recordData->frameIndex, firstPiece, lastPiece);
+    if (groupIndex == HXF_RECORD_THREAD_COUNT - 1) {
+        writeGpuTimestamp(graphics, commandBuffer, recordData->frameIndex, HXF_GPU_PASS_CUBES, 1);
+    }
+
+    HXF_TRY_VK(vkEndCommandBuffer(commandBuffer));
+}
+
+static void recordCullCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t currentFrameIndex) {
+    const HxfDrawingData* const drawingData = &graphics->drawingData;
+
+    // The frustum planes are extracted from projection × view × model
+
+    HxfCullPushConstantData pushConstant = {
+        .cameraPosition = graphics->camera->position,
+        .pieceCount = drawingData->pieceCount,
+        .vertexPulling = graphics->vertexPulling
+    };
+    hxfFrustumPlanes(&drawingData->viewProjection, pushConstant.frustumPlanes);
+
+    // The previous frame may still read the draw commands, the pieces may just have been
+    // transferred and the depth pyramid may just have been built, so wait for them before
+    // running the compute shader
+
+    VkMemoryBarrier piecesBarrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &piecesBarrier, 0, NULL, 0, NULL
+    );
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, graphics->cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, graphics->cullPipelineLayout, 0, 1, &graphics->cullDescriptorSets[currentFrameIndex], 0, NULL);
+    vkCmdPushConstants(commandBuffer, graphics->cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HxfCullPushConstantData), &pushConstant);
+    vkCmdDispatch(commandBuffer, (drawingData->pieceCount + HXF_CULL_WORKGROUP_SIZE - 1) / HXF_CULL_WORKGROUP_SIZE, 1, 1);
+
+    // The draw commands must be written before being read by the draw call
+
+    VkBufferMemoryBarrier drawCommandsBarrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = drawingData->deviceBuffer,
+        .offset = drawingData->drawCommandsOffset,
+        .size = drawingData->drawCommandsSize
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        0, NULL, 1, &drawCommandsBarrier, 0, NULL
+    );
+}
+
+static void recordDepthPyramidCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer) {
+    const HxfDrawingData* const drawingData = &graphics->drawingData;
+
+    // The depth image must be written before being sampled, and the cull compute shader must
+    // have read the depth pyramid before it is overwritten
+
+    VkImageMemoryBarrier depthBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = drawingData->depthImage,
+        .subresourceRange = {
+            .aspectMask = drawingData->depthImageAspects,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, NULL, 0, NULL, 1, &depthBarrier
+    );
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, graphics->depthPyramidPipeline);
+
+    // Each level is built from the previous one, the first one is a copy of the depth image
+
+    HxfDepthPyramidPushConstantData pushConstant = {
+        .inputSize = { drawingData->depthPyramidExtent.width, drawingData->depthPyramidExtent.height },
+        .outputSize = { drawingData->depthPyramidExtent.width, drawingData->depthPyramidExtent.height }
+    };
+
+    VkImageMemoryBarrier levelBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = drawingData->depthPyramidImage,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    };
+
+    for (uint32_t level = 0; level != drawingData->depthPyramidLevelCount; level++) {
+        if (level != 0) {
+            pushConstant.inputSize[0] = pushConstant.outputSize[0];
+            pushConstant.inputSize[1] = pushConstant.outputSize[1];
+            pushConstant.outputSize[0] = max(pushConstant.outputSize[0] / 2, 1);
+            pushConstant.outputSize[1] = max(pushConstant.outputSize[1] / 2, 1);
+        }
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, graphics->depthPyramidPipelineLayout, 0, 1, &graphics->depthPyramidDescriptorSets[level], 0, NULL);
+        vkCmdPushConstants(commandBuffer, graphics->depthPyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HxfDepthPyramidPushConstantData), &pushConstant);
+        vkCmdDispatch(
+            commandBuffer,
+            (pushConstant.outputSize[0] + HXF_DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / HXF_DEPTH_PYRAMID_WORKGROUP_SIZE,
+            (pushConstant.outputSize[1] + HXF_DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / HXF_DEPTH_PYRAMID_WORKGROUP_SIZE,
+            1
+        );
+
+        // The level must be written before the next one reads it
+
+        levelBarrier.subresourceRange.baseMipLevel = level;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, NULL, 0, NULL, 1, &levelBarrier
+        );
+    }
+
+    // The occlusion counters are read by the host once the frame is rendered
+
+    VkMemoryBarrier countersBarrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1, &countersBarrier, 0, NULL, 0, NULL
+    );
+}
+
+static void recordCaptureCommands(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    // The render pass leaves the image in the transfer layout, the copy waits for its writes
+
+    VkImageMemoryBarrier imageBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = graphics->swapchainImages[imageIndex],
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, NULL, 0, NULL, 1, &imageBarrier
+    );
+
+    VkBufferImageCopy region = {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = { 0, 0, 0 },
+        .imageExtent = { graphics->swapchainExtent.width, graphics->swapchainExtent.height, 1 }
+    };
+    vkCmdCopyImageToBuffer(commandBuffer, graphics->swapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, graphics->captureBuffer, 1, &region);
+
+    // The host reads the buffer once the frame's fence is signaled
+
+    VkBufferMemoryBarrier bufferBarrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = graphics->captureBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0, NULL, 1, &bufferBarrier, 0, NULL
+    );
+}
+
+static void writeCaptureImage(HxfGraphicsHandler* restrict graphics) {
+    FILE* file = fopen(graphics->capturePath, "wb");
+    if (!file) {
+        HXF_MSG_ERROR("Could not write the captured frame to %s", graphics->capturePath);
+        return;
+    }
+
+    const uint32_t width = graphics->swapchainExtent.width;
+    const uint32_t height = graphics->swapchainExtent.height;
+    const uint8_t* const pixels = graphics->captureBufferAllocation.data;
+
+    // A binary PPM only has the red, green and blue channels
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    for (uint32_t i = 0; i != width * height; i++) {
+        fwrite(&pixels[4 * i], 3, 1, file);
+    }
+
+    fclose(file);
+
+    printf("Frame %llu written to %s\n", (unsigned long long)graphics->captureFrame, graphics->capturePath);
+}
 
 static void transferBuffers(HxfGraphicsHandler* restrict graphics, VkBuffer src, VkBuffer dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size) {
     VkCommandBufferBeginInfo beginInfo = {
@@ -566,12 +1444,17 @@ static void transferBuffers(HxfGraphicsHandler* restrict graphics, VkBuffer src,
         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
     };
     HXF_TRY_VK(vkBeginCommandBuffer(*graphics->transferCommandBuffer, &beginInfo));
+    if (graphics->gpuTimings) {
+        vkCmdResetQueryPool(*graphics->transferCommandBuffer, graphics->timestampQueryPool, GPU_TIMESTAMP_INDEX(UPLOAD_TIMESTAMP_SET, HXF_GPU_PASS_UPLOAD), 2);
+    }
+    writeGpuTimestamp(graphics, *graphics->transferCommandBuffer, UPLOAD_TIMESTAMP_SET, HXF_GPU_PASS_UPLOAD, 0);
     VkBufferCopy copyRegion = {
         .srcOffset = srcOffset,
         .dstOffset = dstOffset,
         .size = size
     };
     vkCmdCopyBuffer(*graphics->transferCommandBuffer, src, dst, 1, &copyRegion);
+    writeGpuTimestamp(graphics, *graphics->transferCommandBuffer, UPLOAD_TIMESTAMP_SET, HXF_GPU_PASS_UPLOAD, 1);
     HXF_TRY_VK(vkEndCommandBuffer(*graphics->transferCommandBuffer));
 
     VkSubmitInfo submitInfo = {
@@ -582,8 +1465,61 @@ static void transferBuffers(HxfGraphicsHandler* restrict graphics, VkBuffer src,
     vkQueueSubmit(graphics->graphicsQueue, 1, &submitInfo, graphics->fence);
     vkWaitForFences(graphics->device, 1, &graphics->fence, VK_TRUE, UINT64_MAX);
     vkResetFences(graphics->device, 1, &graphics->fence);
+
+    // The transfer is already waited for, and it is only added once an update has begun
+    if (graphics->gpuTimings && graphics->gpuPassDurations[HXF_GPU_PASS_UPLOAD] >= 0.0) {
+        const double duration = readGpuDuration(graphics, GPU_TIMESTAMP_INDEX(UPLOAD_TIMESTAMP_SET, HXF_GPU_PASS_UPLOAD));
+        if (duration >= 0.0) {
+            graphics->gpuPassDurations[HXF_GPU_PASS_UPLOAD] += duration;
+        }
+    }
+}
+
+static void writeGpuTimestamp(HxfGraphicsHandler* restrict graphics, VkCommandBuffer commandBuffer, uint32_t timestampSet, HxfGpuPass pass, int isEnd) {
+    if (graphics->gpuTimings) {
+        vkCmdWriteTimestamp(
+            commandBuffer,
+            isEnd ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            graphics->timestampQueryPool,
+            GPU_TIMESTAMP_INDEX(timestampSet, pass) + isEnd
+        );
+    }
+}
+
+static double readGpuDuration(HxfGraphicsHandler* restrict graphics, uint32_t firstQuery) {
+    // The value and the availability of each timestamp, the unwritten ones stay unavailable
+    uint64_t results[2][2] = { 0 };
+    vkGetQueryPoolResults(
+        graphics->device,
+        graphics->timestampQueryPool,
+        firstQuery, 2,
+        sizeof(results), results, sizeof(results[0]),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+    );
+
+    if (results[0][1] == 0 || results[1][1] == 0) {
+        return -1.0;
+    }
+
+    // Only the valid bits are counted, so that the difference wraps around like the timestamps
+    const uint64_t mask = graphics->timestampValidBits >= 64 ? UINT64_MAX : (1ull << graphics->timestampValidBits) - 1;
+    const uint64_t ticks = ((results[1][0] & mask) - (results[0][0] & mask)) & mask;
+
+    return (double)ticks * graphics->physicalDeviceLimits.timestampPeriod / 1000000000.0;
 }
 
+static void readFrameTimings(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex) {
+    for (int i = 0; i != HXF_GPU_PASS_COUNT; i++) {
+        if (i != HXF_GPU_PASS_UPLOAD) {
+            graphics->gpuPassDurations[i] = readGpuDuration(graphics, GPU_TIMESTAMP_INDEX(frameIndex, i));
+        }
+    }
+
+    graphics->isTimestampQueryWritten[frameIndex] = 0;
+    graphics->timedFrameCount++;
+}
+
+#if !defined(HXF_HEADLESS)
 static void createSurface(HxfGraphicsHandler* restrict graphics) {
     hxfCreateWindowSurface(graphics->mainWindow, graphics->instance, &graphics->mainWindowSurface);
 
@@ -599,11 +1535,62 @@ static void createSurface(HxfGraphicsHandler* restrict graphics) {
     }
 
 }
+#endif
 
 static void getRequiredInstanceExtensions(char*** restrict extensions, int* restrict count) {
     hxfGetRequiredWindowExtensions(extensions, count);
 }
 
+#if defined(HXF_HEADLESS)
+static void createOffscreenImages(HxfGraphicsHandler* restrict graphics) {
+    // A format the swapchain would have, every device can render to it
+    graphics->swapchainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    graphics->swapchainExtent.width = graphics->mainWindow->width;
+    graphics->swapchainExtent.height = graphics->mainWindow->height;
+
+    // The frame uses the image of its index, so the fence of the frame also protects its image
+    graphics->swapchainImageCount = HXF_MAX_RENDERED_FRAMES;
+    graphics->swapchainImages = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImage), HXF_ALLOC_GRAPHICS);
+    graphics->swapchainImageView = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImageView), HXF_ALLOC_GRAPHICS);
+
+    VkImageCreateInfo imageInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = graphics->swapchainImageFormat,
+        .extent = { graphics->swapchainExtent.width, graphics->swapchainExtent.height, 1 },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 1,
+        .pQueueFamilyIndices = &graphics->graphicsQueueFamilyIndex,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkImageViewCreateInfo imageViewInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = graphics->swapchainImageFormat,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    };
+
+    for (int i = graphics->swapchainImageCount - 1; i != -1; i--) {
+        HXF_TRY_VK(vkCreateImage(graphics->device, &imageInfo, NULL, &graphics->swapchainImages[i]));
+        HXF_TRY_VK(hxfAllocateImageMemory(&graphics->memoryAllocator, graphics->swapchainImages[i], HXF_MEMORY_USAGE_DEVICE, HXF_ALLOCATION_STRATEGY_FREE_LIST, &graphics->offscreenImageAllocations[i]));
+
+        imageViewInfo.image = graphics->swapchainImages[i];
+        HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->swapchainImageView[i]));
+    }
+}
+#else
 static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
     // Get the surfaceInformations
     VkSurfaceCapabilitiesKHR surfaceCapabilities;
@@ -613,7 +1600,7 @@ static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(graphics->physicalDevice, graphics->mainWindowSurface, &surfaceCapabilities);
 
     vkGetPhysicalDeviceSurfaceFormatsKHR(graphics->physicalDevice, graphics->mainWindowSurface, &surfaceFormatCount, NULL);
-    surfaceFormats = hxfMalloc(surfaceFormatCount * sizeof(VkSurfaceFormatKHR));
+    surfaceFormats = hxfMalloc(surfaceFormatCount * sizeof(VkSurfaceFormatKHR), HXF_ALLOC_GRAPHICS);
     vkGetPhysicalDeviceSurfaceFormatsKHR(graphics->physicalDevice, graphics->mainWindowSurface, &surfaceFormatCount, surfaceFormats);
 
     // Choose the swapchain image format and colorspace
@@ -643,10 +1630,34 @@ static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
     if (imageCount < surfaceCapabilities.minImageCount) {
         imageCount = surfaceCapabilities.minImageCount;
     }
-    else if (imageCount > surfaceCapabilities.maxImageCount) {
+    else if (surfaceCapabilities.maxImageCount != 0 && imageCount > surfaceCapabilities.maxImageCount) {
+        // A maxImageCount of 0 means there is no limit
         imageCount = surfaceCapabilities.maxImageCount;
     }
 
+    // Check the present mode, FIFO is always available
+    if (graphics->presentMode != VK_PRESENT_MODE_FIFO_KHR) {
+        uint32_t presentModeCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(graphics->physicalDevice, graphics->mainWindowSurface, &presentModeCount, NULL);
+        VkPresentModeKHR* presentModes = hxfMalloc(presentModeCount * sizeof(VkPresentModeKHR), HXF_ALLOC_GRAPHICS);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(graphics->physicalDevice, graphics->mainWindowSurface, &presentModeCount, presentModes);
+
+        int isSupported = 0;
+        for (uint32_t i = 0; i != presentModeCount; i++) {
+            if (presentModes[i] == graphics->presentMode) {
+                isSupported = 1;
+                break;
+            }
+        }
+
+        hxfFree(presentModes);
+
+        if (!isSupported) {
+            HXF_MSG_ERROR("The present mode is not supported by the surface, FIFO is used instead");
+            graphics->presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        }
+    }
+
     // Set the swapchain extent of the engine
     graphics->swapchainExtent = surfaceCapabilities.currentExtent;
 
@@ -663,7 +1674,7 @@ static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
     swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     swapchainInfo.preTransform = surfaceCapabilities.currentTransform;
     swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapchainInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR; // Choose FIFO for now as it is always available
+    swapchainInfo.presentMode = graphics->presentMode;
     swapchainInfo.clipped = VK_TRUE;
     swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
 
@@ -671,11 +1682,11 @@ static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
 
     // Get the swapchain images
     vkGetSwapchainImagesKHR(graphics->device, graphics->swapchain, &graphics->swapchainImageCount, NULL);
-    graphics->swapchainImages = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImage));
+    graphics->swapchainImages = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImage), HXF_ALLOC_GRAPHICS);
     vkGetSwapchainImagesKHR(graphics->device, graphics->swapchain, &graphics->swapchainImageCount, graphics->swapchainImages);
 
     // Create the swapchain image views
-    graphics->swapchainImageView = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImageView));
+    graphics->swapchainImageView = hxfMalloc(graphics->swapchainImageCount * sizeof(VkImageView), HXF_ALLOC_GRAPHICS);
 
     VkImageViewCreateInfo imageViewInfo = { 0 };
     imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -697,9 +1708,23 @@ static void createSwapchain(HxfGraphicsHandler* restrict graphics) {
         HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->swapchainImageView[i]));
     }
 }
+#endif
+
+static void createCaptureBuffer(HxfGraphicsHandler* restrict graphics) {
+    // The pixels are tightly packed, 4 bytes each
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = 4 * graphics->swapchainExtent.width * graphics->swapchainExtent.height,
+        .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    HXF_TRY_VK(vkCreateBuffer(graphics->device, &bufferInfo, NULL, &graphics->captureBuffer));
+    HXF_TRY_VK(hxfAllocateBufferMemory(&graphics->memoryAllocator, graphics->captureBuffer, HXF_MEMORY_USAGE_READBACK, HXF_ALLOCATION_STRATEGY_FREE_LIST, &graphics->captureBufferAllocation));
+}
 
 static void createFramebuffers(HxfGraphicsHandler* restrict graphics) {
-    graphics->swapchainFramebuffers = hxfMalloc(graphics->swapchainImageCount * sizeof(VkFramebuffer));
+    graphics->swapchainFramebuffers = hxfMalloc(graphics->swapchainImageCount * sizeof(VkFramebuffer), HXF_ALLOC_GRAPHICS);
 
     VkFramebufferCreateInfo framebufferInfo = { 0 };
     framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -749,17 +1774,43 @@ static void createSyncObjects(HxfGraphicsHandler* restrict graphics) {
 static void createTextureImages(HxfGraphicsHandler* restrict graphics, TextureImageInfo* restrict textureInfo) {
     // Load the textures
 
-    char* texturePath = hxfMalloc(sizeof(char) * (strlen(graphics->appdataDirectory) + 31));
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+
+    char* texturePath = hxfArenaAlloc(scratch, sizeof(char) * (strlen(graphics->appdataDirectory) + 31));
     strcpy(texturePath, graphics->appdataDirectory);
     strcat(texturePath, "/textures/textures.png");
 
     textureInfo->pixels = stbi_load(texturePath, &textureInfo->width, &textureInfo->height, &textureInfo->channels, STBI_rgb_alpha);
 
-    hxfFree(texturePath);
+    hxfArenaReset(scratch, scratchMark);
 
     if (!textureInfo->pixels) {
         HXF_FATAL("Could not load texture files");
     }
+    if (textureInfo->width % HXF_TEXTURE_SIZE != 0 || textureInfo->height % HXF_TEXTURE_SIZE != 0) {
+        HXF_FATAL("The size of textures.png must be a multiple of the texture size");
+    }
+
+    // Each face texture is a layer, so that a mip level never mixes two textures
+
+    graphics->drawingData.textureLayerCount = (textureInfo->width / HXF_TEXTURE_SIZE) * (textureInfo->height / HXF_TEXTURE_SIZE);
+
+    // The mip levels are generated with linear blits, they are only used if the format supports it
+
+    const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(graphics->physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &formatProperties);
+
+    graphics->drawingData.textureMipLevelCount = 1;
+    if ((formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures) {
+        for (uint32_t size = HXF_TEXTURE_SIZE; size != 1; size /= 2) {
+            graphics->drawingData.textureMipLevelCount++;
+        }
+    }
+    else {
+        HXF_MSG_ERROR("The texture format can not be blitted, the textures have no mip levels");
+    }
 
     // Create the images
 
@@ -768,15 +1819,15 @@ static void createTextureImages(HxfGraphicsHandler* restrict graphics, TextureIm
         .imageType = VK_IMAGE_TYPE_2D,
         .format = VK_FORMAT_R8G8B8A8_SRGB,
         .extent = {
-            .width = textureInfo->width,
-            .height = textureInfo->height,
+            .width = HXF_TEXTURE_SIZE,
+            .height = HXF_TEXTURE_SIZE,
             .depth = 1
         },
-        .mipLevels = 1,
-        .arrayLayers = 1,
+        .mipLevels = graphics->drawingData.textureMipLevelCount,
+        .arrayLayers = graphics->drawingData.textureLayerCount,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
-        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 1,
         .pQueueFamilyIndices = &graphics->graphicsQueueFamilyIndex,
@@ -785,75 +1836,12 @@ static void createTextureImages(HxfGraphicsHandler* restrict graphics, TextureIm
     HXF_TRY_VK(vkCreateImage(graphics->device, &imageInfo, NULL, &graphics->drawingData.textureImage));
 }
 
-static uint32_t getMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties* restrict deviceProperties, VkMemoryPropertyFlags memoryProperties) {
-    uint32_t index = -1;
-
-    uint32_t i = 0;
-    while (i != deviceProperties->memoryTypeCount && index == -1) {
-        // If the properties are exactly the same
-        if ((deviceProperties->memoryTypes[i].propertyFlags ^ memoryProperties) == 0) {
-            index = i;
-        }
-        i++;
-    }
-
-    if (index == -1) {
-        HXF_FATAL("Could not find a compatible memory type");
-    }
-
-    return index;
-}
-
-static VkDeviceSize getAlignement(VkDeviceSize alignementRequirement, VkDeviceSize offset) {
-    VkDeviceSize alignement = offset % alignementRequirement;
-    return (alignement == 0)
-        ? 0
-        : alignementRequirement - alignement;
-}
-
-/**
- * @brief Align an object according to its memory requirements.
- *
- * @param memoryRequirements A pointer to the VkMemoryRequirements that describe the needs for the object.
- * @param memoryOffset The offset where the alignement starts. It is then increased with the size of the
- * object (and the alignement).
- * @param objectOffset A pointer to the object memory offset that will be modified.
- * @param objectSize A pointer to the object memory size that will be modified.
- */
-static void alignObject(const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict memoryOffset, VkDeviceSize* restrict objectOffset, VkDeviceSize* restrict objectSize) {
-    *objectOffset = *memoryOffset + getAlignement(memoryRequirements->alignment, *memoryOffset);
-    *objectSize = memoryRequirements->size;
-    *memoryOffset = *objectOffset + *objectSize;
-}
-
-/**
- * @brief Align the buffer in memory according to the memory requirements.
- *
- * It also updates the offsets.
- *
- * @param memoryRequirements The buffer memory requirements.
- * @param bufferOffset The offset in memory of the buffer.
- * @param offsets An array of pointer to the offsets of the objects inside the buffer
- * that will be modified according the memoryRequirements.
- * @param offsetCount The number of elements of offsets.
- */
-static void alignBuffer(const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict bufferOffset, VkDeviceSize** restrict offsets, size_t offsetCount) {
-    VkDeviceSize additionalOffset = getAlignement(memoryRequirements->alignment, *bufferOffset);
-
-    for (int i = 0; i != offsetCount; i++) {
-        *(offsets[i]) += additionalOffset;
-    }
-
-    *bufferOffset += additionalOffset;
-}
-
 static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureImageInfo* restrict textureInfo) {
     HxfDrawingData* const restrict drawingData = &graphics->drawingData; // Reference to the drawing data
-    const VkDeviceSize textureImageSize = textureInfo->width * textureInfo->height * textureInfo->channels;
-    VkDeviceSize deviceBufferSizeRequired;
+    HxfMemoryAllocator* const allocator = &graphics->memoryAllocator;
+    const VkDeviceSize textureImageSize = textureInfo->width * textureInfo->height * STBI_rgb_alpha; // The pixels are always loaded as RGBA
+    VkDeviceSize bufferOffset; ///< The offset of the next object inside the buffer
     VkDeviceSize deviceBufferDataSize;
-    VkDeviceSize hostMemorySize;   ///< The total size of the host memory
-    VkDeviceSize deviceMemorySize; //< The total size of the device memory
 
     VkBufferCreateInfo bufferInfo = {
         // Default value that does not change accross the different buffers
@@ -863,162 +1851,122 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE
     };
 
-    /*
-    COMPUTE THE MEMORY OFFSETS
-    */
+    /**********
+     * IMAGES *
+     **********/
 
-    size_t memoryOffset = 0;
-    VkMemoryRequirements memoryRequirements;
+    HXF_TRY_VK(hxfAllocateImageMemory(allocator, drawingData->depthImage, HXF_MEMORY_USAGE_DEVICE, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->depthImageAllocation));
+    if (graphics->occlusionCulling) {
+        HXF_TRY_VK(hxfAllocateImageMemory(allocator, drawingData->depthPyramidImage, HXF_MEMORY_USAGE_DEVICE, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->depthPyramidImageAllocation));
+    }
+    HXF_TRY_VK(hxfAllocateImageMemory(allocator, drawingData->textureImage, HXF_MEMORY_USAGE_DEVICE, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->textureImageAllocation));
 
     /*****************
-     * DEVICE MEMORY *
+     * DEVICE BUFFER *
      *****************/
 
-    // Depth image
-    vkGetImageMemoryRequirements(graphics->device, graphics->drawingData.depthImage, &memoryRequirements);
-    alignObject(&memoryRequirements, &memoryOffset, &graphics->drawingData.depthImageOffset, &graphics->drawingData.depthImageSize);
-
-    // Texture image
-    vkGetImageMemoryRequirements(graphics->device, drawingData->textureImage, &memoryRequirements);
-    alignObject(&memoryRequirements, &memoryOffset, &drawingData->textureImageOffset, &drawingData->textureImageSize);
-
-// --- Start of the device buffer --- //
-
-    drawingData->deviceBufferOffset = memoryOffset;
+    bufferOffset = 0;
 
     // Cube vertex
-    drawingData->cubesVerticesOffset = memoryOffset;
+    drawingData->cubesVerticesOffset = bufferOffset;
     drawingData->cubesVerticesSize = sizeof(drawingData->cubesVertices);
-    memoryOffset = drawingData->cubesVerticesOffset + drawingData->cubesVerticesSize;
+    bufferOffset = drawingData->cubesVerticesOffset + drawingData->cubesVerticesSize;
 
     // Cube vertex index
-    drawingData->cubesVertexIndicesOffset = memoryOffset;
+    drawingData->cubesVertexIndicesOffset = bufferOffset;
     drawingData->cubesVertexIndicesSize = sizeof(drawingData->cubesVertexIndices);
-    memoryOffset = drawingData->cubesVertexIndicesOffset + drawingData->cubesVertexIndicesSize;
+    bufferOffset = drawingData->cubesVertexIndicesOffset + drawingData->cubesVertexIndicesSize;
 
-    // Cube instance
-    drawingData->cubeInstancesOffset = memoryOffset;
+    // Cube instance (also a storage buffer with the vertex pulling, its offset inside the buffer must be aligned)
+    drawingData->cubeInstancesOffset = bufferOffset + hxfGetAlignement(graphics->physicalDeviceLimits.minStorageBufferOffsetAlignment, bufferOffset);
     drawingData->cubeInstancesSize = HXF_CUBE_INSTANCES_SIZE;
-    memoryOffset = drawingData->cubeInstancesOffset + drawingData->cubeInstancesSize;
-
-    // Pointed cube
-    drawingData->pointedCubeOffset = memoryOffset;
-    drawingData->pointedCubeSize = sizeof(HxfCubeInstanceData);
-    memoryOffset = drawingData->pointedCubeOffset + drawingData->pointedCubeSize;
+    bufferOffset = drawingData->cubeInstancesOffset + drawingData->cubeInstancesSize;
 
     // Icon vertex data
-    drawingData->iconVerticesOffset = memoryOffset;
+    drawingData->iconVerticesOffset = bufferOffset;
     drawingData->iconVerticesSize = sizeof(drawingData->iconVertices);
-    memoryOffset = drawingData->iconVerticesOffset + drawingData->iconVerticesSize;
+    bufferOffset = drawingData->iconVerticesOffset + drawingData->iconVerticesSize;
 
     // Icon vertex index
-    drawingData->iconVertexIndicesOffset = memoryOffset;
+    drawingData->iconVertexIndicesOffset = bufferOffset;
     drawingData->iconVertexIndicesSize = sizeof(drawingData->iconVertexIndices);
-    memoryOffset = drawingData->iconVertexIndicesOffset + drawingData->iconVertexIndicesSize;
+    bufferOffset = drawingData->iconVertexIndicesOffset + drawingData->iconVertexIndicesSize;
 
     // Icon instance data
-    drawingData->iconInstancesOffset = memoryOffset;
+    drawingData->iconInstancesOffset = bufferOffset;
     drawingData->iconInstancesSize = sizeof(drawingData->iconInstances);
-    memoryOffset = drawingData->iconInstancesOffset + drawingData->iconInstancesSize;
+    bufferOffset = drawingData->iconInstancesOffset + drawingData->iconInstancesSize;
+
+    // Pieces data (storage buffer, its offset inside the buffer must be aligned)
+    drawingData->piecesOffset = bufferOffset + hxfGetAlignement(graphics->physicalDeviceLimits.minStorageBufferOffsetAlignment, bufferOffset);
+    drawingData->piecesSize = sizeof(drawingData->pieces);
+    bufferOffset = drawingData->piecesOffset + drawingData->piecesSize;
+
+    // Indirect draw commands (storage buffer)
+    drawingData->drawCommandsOffset = bufferOffset + hxfGetAlignement(graphics->physicalDeviceLimits.minStorageBufferOffsetAlignment, bufferOffset);
+    drawingData->drawCommandsSize = HXF_PIECE_COUNT * HXF_FACE_DIRECTION_COUNT * sizeof(VkDrawIndexedIndirectCommand);
+    bufferOffset = drawingData->drawCommandsOffset + drawingData->drawCommandsSize;
 
     // Buffer creation
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    bufferInfo.size = memoryOffset - drawingData->deviceBufferOffset;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+        | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    bufferInfo.size = bufferOffset;
     HXF_TRY_VK(vkCreateBuffer(graphics->device, &bufferInfo, NULL, &drawingData->deviceBuffer));
-    vkGetBufferMemoryRequirements(graphics->device, drawingData->deviceBuffer, &memoryRequirements);
+    HXF_TRY_VK(hxfAllocateBufferMemory(allocator, drawingData->deviceBuffer, HXF_MEMORY_USAGE_DEVICE, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->deviceBufferAllocation));
     deviceBufferDataSize = bufferInfo.size;
 
-    VkDeviceSize* deviceBufferOffsets[] = {
-        &drawingData->cubesVerticesOffset,
-        &drawingData->cubesVertexIndicesOffset,
-        &drawingData->cubeInstancesOffset,
-        &drawingData->pointedCubeOffset,
-        &drawingData->iconVerticesOffset,
-        &drawingData->iconInstancesOffset
-    };
-    alignBuffer(&memoryRequirements, &drawingData->deviceBufferOffset, deviceBufferOffsets, sizeof(deviceBufferOffsets) / sizeof(VkDeviceSize*));
-    deviceBufferSizeRequired = memoryRequirements.size;
-    memoryOffset = drawingData->deviceBufferOffset + deviceBufferSizeRequired;
-
-// --- End of the device buffer --- //
-
-    deviceMemorySize = memoryOffset;
-
     /***************
-     * HOST MEMORY *
+     * HOST BUFFER *
      ***************/
 
-    memoryOffset = 0;
+    bufferOffset = 0;
 
-// --- Start of host buffer data --- //
+    // Data of each frame (uniform buffer, each one must be aligned)
+    drawingData->frameDataOffset = bufferOffset;
+    drawingData->frameDataSize = sizeof(HxfFrameData) + hxfGetAlignement(graphics->physicalDeviceLimits.minUniformBufferOffsetAlignment, sizeof(HxfFrameData));
+    bufferOffset = drawingData->frameDataOffset + drawingData->frameDataSize * HXF_MAX_RENDERED_FRAMES;
 
-    drawingData->hostBufferOffset = memoryOffset;
-
-    // Mvp
-    drawingData->mvpOffset = memoryOffset;
-    drawingData->mvpSize = sizeof(drawingData->mvp);
-    memoryOffset = drawingData->mvpOffset + drawingData->mvpSize;
+    // Occlusion data of each frame (storage buffer, each one must be aligned)
+    // The cull compute shader always reads it, even when the occlusion culling is disabled
+    if (graphics->gpuCulling) {
+        drawingData->occlusionDataOffset = bufferOffset + hxfGetAlignement(graphics->physicalDeviceLimits.minStorageBufferOffsetAlignment, bufferOffset);
+        drawingData->occlusionDataSize = sizeof(HxfOcclusionData) + hxfGetAlignement(graphics->physicalDeviceLimits.minStorageBufferOffsetAlignment, sizeof(HxfOcclusionData));
+        bufferOffset = drawingData->occlusionDataOffset + drawingData->occlusionDataSize * HXF_MAX_RENDERED_FRAMES;
+    }
 
-    // Host buffer
-    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    bufferInfo.size = memoryOffset - drawingData->hostBufferOffset;
+    // Buffer creation, it stays mapped so the data of each frame is written without any call
+    bufferInfo.usage = graphics->gpuCulling
+        ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        : VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    bufferInfo.size = bufferOffset;
     HXF_TRY_VK(vkCreateBuffer(graphics->device, &bufferInfo, NULL, &drawingData->hostBuffer));
-    vkGetBufferMemoryRequirements(graphics->device, drawingData->hostBuffer, &memoryRequirements);
-
-    VkDeviceSize* hostBufferOffsets[] = {
-        &drawingData->mvpOffset
-    };
-    alignBuffer(&memoryRequirements, &drawingData->hostBufferOffset, hostBufferOffsets, sizeof(hostBufferOffsets) / sizeof(VkDeviceSize*));
-    memoryOffset = drawingData->hostBufferOffset + memoryRequirements.size;
+    HXF_TRY_VK(hxfAllocateBufferMemory(allocator, drawingData->hostBuffer, HXF_MEMORY_USAGE_DYNAMIC, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->hostBufferAllocation));
 
-// --- End of host buffer data --- //
+    /********************
+     * TRANSFER BUFFERS *
+     ********************/
 
-    // Transfer buffer
-    drawingData->transferBufferOffset = memoryOffset;
-
-    bufferInfo.size = max(deviceBufferSizeRequired, textureImageSize); // We need to copy from the device buffer
+    // The transfer buffer is kept to update the device buffer
+    bufferInfo.size = deviceBufferDataSize;
     bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     HXF_TRY_VK(vkCreateBuffer(graphics->device, &bufferInfo, NULL, &drawingData->transferBuffer));
-    vkGetBufferMemoryRequirements(graphics->device, drawingData->transferBuffer, &memoryRequirements);
-    alignBuffer(&memoryRequirements, &drawingData->transferBufferOffset, NULL, 0);
-    memoryOffset = drawingData->transferBufferOffset + memoryRequirements.size;
-
-    hostMemorySize = memoryOffset;
-
-    // Allocate the memories
-
-    VkMemoryAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
-    };
-
-    allocInfo.allocationSize = hostMemorySize;
-    allocInfo.memoryTypeIndex = getMemoryTypeIndex(&graphics->physicalDeviceMemoryProperties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    HXF_TRY_VK(vkAllocateMemory(graphics->device, &allocInfo, NULL, &graphics->hostMemory));
-
-    allocInfo.allocationSize = deviceMemorySize;
-    allocInfo.memoryTypeIndex = getMemoryTypeIndex(&graphics->physicalDeviceMemoryProperties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    HXF_TRY_VK(vkAllocateMemory(graphics->device, &allocInfo, NULL, &graphics->deviceMemory));
-
-    // Memory binding
+    HXF_TRY_VK(hxfAllocateBufferMemory(allocator, drawingData->transferBuffer, HXF_MEMORY_USAGE_UPLOAD, HXF_ALLOCATION_STRATEGY_FREE_LIST, &drawingData->transferBufferAllocation));
 
-    vkBindBufferMemory(graphics->device, drawingData->hostBuffer, graphics->hostMemory, drawingData->hostBufferOffset);
-    vkBindBufferMemory(graphics->device, drawingData->deviceBuffer, graphics->deviceMemory, drawingData->deviceBufferOffset);
-    vkBindBufferMemory(graphics->device, drawingData->transferBuffer, graphics->hostMemory, drawingData->transferBufferOffset);
-    vkBindImageMemory(graphics->device, graphics->drawingData.depthImage, graphics->deviceMemory, graphics->drawingData.depthImageOffset);
-    vkBindImageMemory(graphics->device, drawingData->textureImage, graphics->deviceMemory, drawingData->textureImageOffset);
+    // The texture is only uploaded once, its staging buffer is freed when the image is filled
+    VkBuffer textureStagingBuffer;
+    HxfAllocation textureStagingAllocation;
+    bufferInfo.size = textureImageSize;
+    HXF_TRY_VK(vkCreateBuffer(graphics->device, &bufferInfo, NULL, &textureStagingBuffer));
+    HXF_TRY_VK(hxfAllocateBufferMemory(allocator, textureStagingBuffer, HXF_MEMORY_USAGE_UPLOAD, HXF_ALLOCATION_STRATEGY_LINEAR, &textureStagingAllocation));
 
     // Transfer the device buffers data, from the host to the device memory
 
-    void* data;
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, drawingData->transferBufferOffset, deviceBufferDataSize, 0, &data));
-    data -= drawingData->deviceBufferOffset; // Start from 0 instead of using the device memory offset
+    void* const data = drawingData->transferBufferAllocation.data;
     memcpy(data + drawingData->cubesVerticesOffset, drawingData->cubesVertices, drawingData->cubesVerticesSize);
     memcpy(data + drawingData->cubesVertexIndicesOffset, drawingData->cubesVertexIndices, drawingData->cubesVertexIndicesSize);
-    memcpy(data + drawingData->cubeInstancesOffset, drawingData->cubeInstances, drawingData->cubeInstancesSize);
     memcpy(data + drawingData->iconVerticesOffset, drawingData->iconVertices, drawingData->iconVerticesSize);
     memcpy(data + drawingData->iconVertexIndicesOffset, drawingData->iconVertexIndices, drawingData->iconVertexIndicesSize);
     memcpy(data + drawingData->iconInstancesOffset, drawingData->iconInstances, drawingData->iconInstancesSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
 
     transferBuffers(graphics, drawingData->transferBuffer, drawingData->deviceBuffer, 0, 0, deviceBufferDataSize);
 
@@ -1028,9 +1976,7 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
 
     // Write the texture in memory
 
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, drawingData->transferBufferOffset, textureImageSize, 0, &data));
-    memcpy(data, textureInfo->pixels, textureImageSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
+    memcpy(textureStagingAllocation.data, textureInfo->pixels, textureImageSize);
 
     // Record a command buffer that will transition the image and transfer the texture in an image
 
@@ -1054,9 +2000,9 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
         .subresourceRange = {
             .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
             .baseMipLevel = 0,
-            .levelCount = 1,
+            .levelCount = drawingData->textureMipLevelCount,
             .baseArrayLayer = 0,
-            .layerCount = 1
+            .layerCount = drawingData->textureLayerCount
         }
     };
     vkCmdPipelineBarrier(
@@ -1066,31 +2012,104 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
         0, NULL, 0, NULL, 1, &barrier
     );
 
-    // Copy the texture data from the buffer to the texture image
-
-    VkBufferImageCopy imageCopy = {
-        .bufferOffset = 0,
-        .bufferRowLength = 0,
-        .bufferImageHeight = 0,
-        .imageSubresource = {
-            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .mipLevel = 0,
-            .baseArrayLayer = 0,
-            .layerCount = 1
-        },
-        .imageOffset = {
-            0, 0, 0
-        },
-        .imageExtent = {
-            .width = textureInfo->width,
-            .height = textureInfo->height,
-            .depth = 1
-        }
-    };
-    vkCmdCopyBufferToImage(*graphics->transferCommandBuffer, drawingData->transferBuffer, drawingData->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy);
+    // Copy each face texture of textures.png to its layer
+
+    const uint32_t textureColumnCount = textureInfo->width / HXF_TEXTURE_SIZE;
+    VkBufferImageCopy* imageCopies = hxfMalloc(sizeof(VkBufferImageCopy) * drawingData->textureLayerCount, HXF_ALLOC_GRAPHICS);
+
+    for (uint32_t i = 0; i != drawingData->textureLayerCount; i++) {
+        const uint32_t row = i / textureColumnCount;
+        const uint32_t column = i % textureColumnCount;
+
+        imageCopies[i] = (VkBufferImageCopy) {
+            .bufferOffset = ((row * HXF_TEXTURE_SIZE) * textureInfo->width + column * HXF_TEXTURE_SIZE) * STBI_rgb_alpha,
+            .bufferRowLength = textureInfo->width,
+            .bufferImageHeight = textureInfo->height,
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = i,
+                .layerCount = 1
+            },
+            .imageOffset = {
+                0, 0, 0
+            },
+            .imageExtent = {
+                .width = HXF_TEXTURE_SIZE,
+                .height = HXF_TEXTURE_SIZE,
+                .depth = 1
+            }
+        };
+    }
+    vkCmdCopyBufferToImage(*graphics->transferCommandBuffer, textureStagingBuffer, drawingData->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, drawingData->textureLayerCount, imageCopies);
+
+    hxfFree(imageCopies);
+
+    // Generate each mip level from the previous one, then transition the previous one to a
+    // shader read only layout, to be able to use it in the shaders
+
+    barrier.subresourceRange.levelCount = 1;
+    int32_t levelSize = HXF_TEXTURE_SIZE;
+
+    for (uint32_t level = 1; level != drawingData->textureMipLevelCount; level++) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        vkCmdPipelineBarrier(
+            *graphics->transferCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, NULL, 0, NULL, 1, &barrier
+        );
+
+        VkImageBlit blit = {
+            .srcSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = level - 1,
+                .baseArrayLayer = 0,
+                .layerCount = drawingData->textureLayerCount
+            },
+            .srcOffsets = {
+                { 0, 0, 0 },
+                { levelSize, levelSize, 1 }
+            },
+            .dstSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = level,
+                .baseArrayLayer = 0,
+                .layerCount = drawingData->textureLayerCount
+            },
+            .dstOffsets = {
+                { 0, 0, 0 },
+                { levelSize / 2, levelSize / 2, 1 }
+            }
+        };
+        vkCmdBlitImage(
+            *graphics->transferCommandBuffer,
+            drawingData->textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            drawingData->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit,
+            VK_FILTER_LINEAR
+        );
+        levelSize /= 2;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(
+            *graphics->transferCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            0, NULL, 0, NULL, 1, &barrier
+        );
+    }
 
-    // Transition the image layout to a shader read only layout, to be able to use it in the shaders
+    // The last level is only written
 
+    barrier.subresourceRange.baseMipLevel = drawingData->textureMipLevelCount - 1;
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -1102,6 +2121,34 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
         0, NULL, 0, NULL, 1, &barrier
     );
 
+    // The depth pyramid always stays in the general layout, as it is both written and sampled
+
+    if (graphics->occlusionCulling) {
+        VkImageMemoryBarrier pyramidBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = drawingData->depthPyramidImage,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = drawingData->depthPyramidLevelCount,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        };
+        vkCmdPipelineBarrier(
+            *graphics->transferCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, NULL, 0, NULL, 1, &pyramidBarrier
+        );
+    }
+
     HXF_TRY_VK(vkEndCommandBuffer(*graphics->transferCommandBuffer));
 
     // Execute the command buffer
@@ -1115,11 +2162,15 @@ static void allocateMemory(HxfGraphicsHandler* restrict graphics, const TextureI
     vkWaitForFences(graphics->device, 1, &graphics->fence, VK_TRUE, UINT64_MAX);
     vkResetFences(graphics->device, 1, &graphics->fence);
 
-    // Write the host memory data that is actually needed
+    vkDestroyBuffer(graphics->device, textureStagingBuffer, NULL);
+    hxfFreeMemory(allocator, &textureStagingAllocation);
+
+    // The frame data is written by hxfGraphicsEndFrame before each frame uses it, the camera is
+    // not read here as the world is loaded at the same time on another thread
 
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, 0, drawingData->mvpSize, 0, &data));
-    memcpy(data, &drawingData->mvp, drawingData->mvpSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
+    if (graphics->gpuCulling) {
+        memset(drawingData->hostBufferAllocation.data + drawingData->occlusionDataOffset, 0, drawingData->occlusionDataSize * HXF_MAX_RENDERED_FRAMES);
+    }
 }
 
 static void createDepthImage(HxfGraphicsHandler* restrict graphics) {
@@ -1130,17 +2181,35 @@ static void createDepthImage(HxfGraphicsHandler* restrict graphics) {
         VK_FORMAT_D24_UNORM_S8_UINT,
     };
 
-    int i = 0;
+    // The occlusion culling builds the depth pyramid by sampling the depth image
+    VkFormatFeatureFlags requiredFeatures = graphics->occlusionCulling
+        ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+        : VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+    // The depth prepass also needs a stencil, only the formats after the first one have it
+    const int firstFormat = graphics->depthPrepass ? 1 : 0;
+    graphics->drawingData.depthImageAspects = graphics->depthPrepass
+        ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+        : VK_IMAGE_ASPECT_DEPTH_BIT;
+
+    int i = firstFormat;
     int notFound = 1;
     while (i != 3 && notFound) {
         VkFormatProperties properties;
         vkGetPhysicalDeviceFormatProperties(graphics->physicalDevice, formats[i], &properties);
-        if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) == VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+        if ((properties.optimalTilingFeatures & requiredFeatures) == requiredFeatures) {
             graphics->drawingData.depthImageFormat = formats[i];
             notFound = 0;
         }
 
         i++;
+
+        if (i == 3 && notFound && graphics->occlusionCulling) {
+            HXF_MSG_ERROR("The depth image can not be sampled, the occlusion culling is disabled");
+            graphics->occlusionCulling = 0;
+            requiredFeatures = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            i = firstFormat;
+        }
     }
 
     if (notFound) {
@@ -1156,7 +2225,9 @@ static void createDepthImage(HxfGraphicsHandler* restrict graphics) {
         .arrayLayers = 1,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
-        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        .usage = graphics->occlusionCulling
+            ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+            : VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 1,
         .pQueueFamilyIndices = &graphics->graphicsQueueFamilyIndex,
@@ -1164,6 +2235,25 @@ static void createDepthImage(HxfGraphicsHandler* restrict graphics) {
     };
 
     HXF_TRY_VK(vkCreateImage(graphics->device, &imageInfo, NULL, &graphics->drawingData.depthImage));
+
+    if (graphics->occlusionCulling) {
+        // The depth pyramid has the size of the depth image, then each level is half the previous one
+        HxfDrawingData* const drawingData = &graphics->drawingData;
+        drawingData->depthPyramidExtent.width = graphics->mainWindow->width;
+        drawingData->depthPyramidExtent.height = graphics->mainWindow->height;
+
+        uint32_t largestSide = max(drawingData->depthPyramidExtent.width, drawingData->depthPyramidExtent.height);
+        drawingData->depthPyramidLevelCount = 1;
+        while (largestSide > 1 && drawingData->depthPyramidLevelCount != HXF_DEPTH_PYRAMID_MAX_LEVEL_COUNT) {
+            largestSide /= 2;
+            drawingData->depthPyramidLevelCount++;
+        }
+
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.mipLevels = drawingData->depthPyramidLevelCount;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        HXF_TRY_VK(vkCreateImage(graphics->device, &imageInfo, NULL, &drawingData->depthPyramidImage));
+    }
 }
 
 static void createImageViews(HxfGraphicsHandler* restrict graphics) {
@@ -1176,7 +2266,7 @@ static void createImageViews(HxfGraphicsHandler* restrict graphics) {
         .format = graphics->drawingData.depthImageFormat,
         .components = { 0 },
         .subresourceRange = {
-            .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+            .aspectMask = graphics->drawingData.depthImageAspects,
             .baseMipLevel = 0,
             .levelCount = 1,
             .baseArrayLayer = 0,
@@ -1185,31 +2275,67 @@ static void createImageViews(HxfGraphicsHandler* restrict graphics) {
     };
     HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->drawingData.depthImageView));
 
+    // A sampled view can only have one aspect
+
+    if (graphics->occlusionCulling) {
+        imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->drawingData.depthSampledImageView));
+    }
+
     // texture images view
 
     imageViewInfo.image = graphics->drawingData.textureImage;
+    imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
     imageViewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
     imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageViewInfo.subresourceRange.levelCount = graphics->drawingData.textureMipLevelCount;
+    imageViewInfo.subresourceRange.layerCount = graphics->drawingData.textureLayerCount;
     HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->drawingData.textureImageView));
+
+    imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewInfo.subresourceRange.layerCount = 1;
+
+    // depth pyramid views
+
+    if (graphics->occlusionCulling) {
+        imageViewInfo.image = graphics->drawingData.depthPyramidImage;
+        imageViewInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageViewInfo.subresourceRange.levelCount = graphics->drawingData.depthPyramidLevelCount;
+        HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->drawingData.depthPyramidImageView));
+
+        imageViewInfo.subresourceRange.levelCount = 1;
+        for (uint32_t i = 0; i != graphics->drawingData.depthPyramidLevelCount; i++) {
+            imageViewInfo.subresourceRange.baseMipLevel = i;
+            HXF_TRY_VK(vkCreateImageView(graphics->device, &imageViewInfo, NULL, &graphics->drawingData.depthPyramidLevelViews[i]));
+        }
+    }
 }
 
 static void createTextureSampler(HxfGraphicsHandler* restrict graphics) {
     VkSamplerCreateInfo samplerInfo = {
         .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
         .magFilter = VK_FILTER_NEAREST,
-        .minFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_LINEAR, // The distant faces blend their texels instead of flickering
         .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
-        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, // Each texture is alone in its layer
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
         .anisotropyEnable = VK_FALSE,
         .compareEnable = VK_FALSE,
-        .maxLod = 0,
+        .maxLod = graphics->drawingData.textureMipLevelCount,
         .minLod = 0,
         .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
         .unnormalizedCoordinates = VK_FALSE
     };
     HXF_TRY_VK(vkCreateSampler(graphics->device, &samplerInfo, NULL, &graphics->drawingData.textureSampler));
+
+    // The depth pyramid is only read with texelFetch, it only needs a sampler that covers all its levels
+
+    if (graphics->occlusionCulling) {
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.maxLod = graphics->drawingData.depthPyramidLevelCount;
+        HXF_TRY_VK(vkCreateSampler(graphics->device, &samplerInfo, NULL, &graphics->drawingData.depthPyramidSampler));
+    }
 }
 
 static void createRessources(HxfGraphicsHandler* restrict graphics) {
@@ -1226,66 +2352,317 @@ static void createRessources(HxfGraphicsHandler* restrict graphics) {
     stbi_image_free(textureInfo.pixels);
 }
 
-static void updateMvpBuffer(HxfGraphicsHandler* restrict graphics) {
+static void updateFrameData(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex) {
     // Update the view matrix according to the camera
 
     graphics->drawingData.mvp.view = hxfViewMatrix(&graphics->camera->position, &graphics->camera->direction, &graphics->camera->up);
 
-    void* data;
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, graphics->drawingData.mvpOffset, graphics->drawingData.mvpSize, 0, &data));
-    memcpy(data, &graphics->drawingData.mvp, graphics->drawingData.mvpSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
+    // The matrices are multiplied once here instead of for each vertex
+
+    const HxfMat4 viewModel = hxfMat4MulMat(&graphics->drawingData.mvp.model, &graphics->drawingData.mvp.view);
+    graphics->drawingData.viewProjection = hxfMat4MulMat(&viewModel, &graphics->drawingData.mvp.projection);
+
+    // The frame’s data is not used by the device anymore, it is written in place
+
+    HxfFrameData* const frameData = graphics->drawingData.hostBufferAllocation.data + graphics->drawingData.frameDataOffset + frameIndex * graphics->drawingData.frameDataSize;
+    frameData->viewProjection = graphics->drawingData.viewProjection;
+    frameData->pointedCube.position.x = (float)graphics->camera->nearPointedCube.x;
+    frameData->pointedCube.position.y = (float)graphics->camera->nearPointedCube.y;
+    frameData->pointedCube.position.z = (float)graphics->camera->nearPointedCube.z;
+    frameData->pointedCube.textureIndex = 0;
+    frameData->pointedCube.size = 1;
 }
 
-static void updatePointedCubeBuffer(HxfGraphicsHandler* restrict graphics) {
-    void* data;
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, graphics->drawingData.transferBufferOffset, graphics->drawingData.pointedCubeSize, 0, &data));
-    const HxfCubeInstanceData pointedCube = {
-        {
-            (float)graphics->camera->nearPointedCube.x,
-            (float)graphics->camera->nearPointedCube.y,
-            (float)graphics->camera->nearPointedCube.z
-        },
-        0
+static void updateOcclusionData(HxfGraphicsHandler* restrict graphics, uint32_t frameIndex) {
+    HxfOcclusionData* const occlusionData = graphics->drawingData.hostBufferAllocation.data + graphics->drawingData.occlusionDataOffset + frameIndex * graphics->drawingData.occlusionDataSize;
+
+    graphics->occlusionCulledPieceCount = occlusionData->culledPieceCount;
+    graphics->occlusionCulledFaceCount = occlusionData->culledFaceCount;
+
+    // The depth pyramid the frame will test against is the one built by the last recorded frame
+
+    occlusionData->viewProjection = graphics->previousViewProjection;
+    occlusionData->pyramidSize.x = graphics->drawingData.depthPyramidExtent.width;
+    occlusionData->pyramidSize.y = graphics->drawingData.depthPyramidExtent.height;
+    occlusionData->pyramidLevelCount = graphics->drawingData.depthPyramidLevelCount;
+    occlusionData->isEnabled = graphics->hasDepthPyramid;
+    occlusionData->culledPieceCount = 0;
+    occlusionData->culledFaceCount = 0;
+}
+
+static void updateVisiblePieces(HxfGraphicsHandler* restrict graphics) {
+    HxfDrawingData* const drawingData = &graphics->drawingData;
+    const HxfIvec3 sideDirections[HXF_WORLD_PIECE_SIDE_COUNT] = {
+        { 0, 1, 0 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, 0, 1 }, { 1, 0, 0 }, { -1, 0, 0 }
+    };
+    const int oppositeSides[HXF_WORLD_PIECE_SIDE_COUNT] = { 2, 3, 0, 1, 5, 4 };
+
+    memset(drawingData->isPieceVisible, 0, sizeof(drawingData->isPieceVisible));
+
+    if (drawingData->pieceCount == 0) {
+        return;
+    }
+
+    // The grid starts one piece before the first loaded piece
+
+    HxfIvec3 origin = {
+        (int32_t)drawingData->pieces[0].position.x / HXF_WORLD_PIECE_SIZE,
+        (int32_t)drawingData->pieces[0].position.y / HXF_WORLD_PIECE_SIZE,
+        (int32_t)drawingData->pieces[0].position.z / HXF_WORLD_PIECE_SIZE
+    };
+    for (uint32_t i = 1; i != drawingData->pieceCount; i++) {
+        origin.x = min(origin.x, (int32_t)drawingData->pieces[i].position.x / HXF_WORLD_PIECE_SIZE);
+        origin.y = min(origin.y, (int32_t)drawingData->pieces[i].position.y / HXF_WORLD_PIECE_SIZE);
+        origin.z = min(origin.z, (int32_t)drawingData->pieces[i].position.z / HXF_WORLD_PIECE_SIZE);
+    }
+    origin.x--;
+    origin.y--;
+    origin.z--;
+
+    // The index of the piece of each cell, -1 for the empty cells
+
+    int16_t grid[CAVE_GRID_WIDTH][CAVE_GRID_HEIGHT][CAVE_GRID_WIDTH];
+    memset(grid, -1, sizeof(grid));
+    for (uint32_t i = 0; i != drawingData->pieceCount; i++) {
+        const HxfIvec3 cell = {
+            (int32_t)drawingData->pieces[i].position.x / HXF_WORLD_PIECE_SIZE - origin.x,
+            (int32_t)drawingData->pieces[i].position.y / HXF_WORLD_PIECE_SIZE - origin.y,
+            (int32_t)drawingData->pieces[i].position.z / HXF_WORLD_PIECE_SIZE - origin.z
+        };
+        if (cell.x < CAVE_GRID_WIDTH && cell.y < CAVE_GRID_HEIGHT && cell.z < CAVE_GRID_WIDTH) {
+            grid[cell.x][cell.y][cell.z] = i;
+        }
+    }
+
+    // Start from the camera’s cell, or from the nearest cell if the camera is outside of the grid
+
+    const HxfIvec3 cameraPiece = hxfWorldGetPiecePositionF(&graphics->camera->position);
+    const HxfIvec3 cameraCell = {
+        min(max(cameraPiece.x - origin.x, 0), CAVE_GRID_WIDTH - 1),
+        min(max(cameraPiece.y - origin.y, 0), CAVE_GRID_HEIGHT - 1),
+        min(max(cameraPiece.z - origin.z, 0), CAVE_GRID_WIDTH - 1)
     };
-    memcpy(data, &pointedCube, sizeof(pointedCube));
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
 
-    transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.pointedCubeOffset - graphics->drawingData.deviceBufferOffset, sizeof(pointedCube));
+    // A cell can be entered once from each side, so that a piece entered from a side that is
+    // not connected to the others can still be crossed from another side
+
+    static CaveCullingStep queue[CAVE_GRID_CELL_COUNT * HXF_WORLD_PIECE_SIDE_COUNT + 1];
+    uint8_t enteredSides[CAVE_GRID_WIDTH][CAVE_GRID_HEIGHT][CAVE_GRID_WIDTH] = { 0 };
+    size_t queueStart = 0;
+    size_t queueEnd = 1;
+    queue[0].cell = cameraCell;
+    queue[0].entrySide = -1;
+
+    while (queueStart != queueEnd) {
+        const CaveCullingStep step = queue[queueStart++];
+        const int16_t pieceIndex = grid[step.cell.x][step.cell.y][step.cell.z];
+        const uint16_t connectivity = pieceIndex == -1
+            ? HXF_WORLD_PIECE_FULLY_CONNECTED
+            : drawingData->pieceConnectivities[pieceIndex];
+
+        if (pieceIndex != -1) {
+            drawingData->isPieceVisible[pieceIndex] = 1;
+        }
+
+        for (int side = 0; side != HXF_WORLD_PIECE_SIDE_COUNT; side++) {
+            const HxfIvec3* const direction = &sideDirections[side];
+            const HxfIvec3 neighbor = {
+                step.cell.x + direction->x,
+                step.cell.y + direction->y,
+                step.cell.z + direction->z
+            };
+
+            // Only go away from the camera
+            const int32_t distance = (neighbor.x - cameraCell.x) * direction->x
+                + (neighbor.y - cameraCell.y) * direction->y
+                + (neighbor.z - cameraCell.z) * direction->z;
+
+            if (side == step.entrySide
+                || distance <= 0
+                || neighbor.x < 0 || neighbor.x >= CAVE_GRID_WIDTH
+                || neighbor.y < 0 || neighbor.y >= CAVE_GRID_HEIGHT
+                || neighbor.z < 0 || neighbor.z >= CAVE_GRID_WIDTH
+                || (step.entrySide != -1 && !(connectivity & hxfWorldGetSidesBit(step.entrySide, side)))) {
+                continue;
+            }
+
+            const int entrySide = oppositeSides[side];
+            uint8_t* const neighborEnteredSides = &enteredSides[neighbor.x][neighbor.y][neighbor.z];
+            if (!(*neighborEnteredSides & (1 << entrySide))) {
+                *neighborEnteredSides |= 1 << entrySide;
+                queue[queueEnd].cell = neighbor;
+                queue[queueEnd].entrySide = entrySide;
+                queueEnd++;
+            }
+        }
+    }
+}
+
+uint32_t hxfGetVisibleFaceDirections(const HxfVec3* restrict piecePosition, const HxfVec3* restrict cameraPosition) {
+    // The faces of a direction are on the planes between the first cube border and the last one,
+    // e.g. the right faces are on the planes x = piecePosition->x + 1 to x = piecePosition->x + HXF_WORLD_PIECE_SIZE.
+    // They can be seen only if the camera is beyond the first plane.
+
+    const float first = 1.0f;
+    const float last = HXF_WORLD_PIECE_SIZE - 1.0f;
+    uint32_t directions = 0;
+
+    if (cameraPosition->y > piecePosition->y + first) directions |= 1 << 0; // Top
+    if (cameraPosition->z < piecePosition->z + last) directions |= 1 << 1;  // Back
+    if (cameraPosition->y < piecePosition->y + last) directions |= 1 << 2;  // Bottom
+    if (cameraPosition->z > piecePosition->z + first) directions |= 1 << 3; // Front
+    if (cameraPosition->x > piecePosition->x + first) directions |= 1 << 4; // Right
+    if (cameraPosition->x < piecePosition->x + last) directions |= 1 << 5;  // Left
+
+    return directions;
+}
+
+static void updatePieceDrawOrder(HxfGraphicsHandler* restrict graphics) {
+    HxfDrawingData* const drawingData = &graphics->drawingData;
+    const uint32_t pieceCount = drawingData->pieceCount;
+
+    if (!graphics->sortPieces) {
+        for (uint32_t i = 0; i != pieceCount; i++) {
+            drawingData->pieceDrawOrder[i] = i;
+        }
+        return;
+    }
+
+    // A counting sort on the distance between the camera and the nearest point of each piece,
+    // the pieces of a bucket keep the order of the pieces array
+
+    const HxfVec3* const cameraPosition = &graphics->camera->position;
+    uint8_t pieceBuckets[HXF_PIECE_COUNT];
+    uint32_t bucketOffsets[PIECE_SORT_BUCKET_COUNT] = { 0 };
+
+    for (uint32_t i = 0; i != pieceCount; i++) {
+        const HxfVec3* const position = &drawingData->pieces[i].position;
+
+        // 0 on the axes where the camera is between the sides of the piece
+        const float dx = fmaxf(fmaxf(position->x - cameraPosition->x, cameraPosition->x - (position->x + HXF_WORLD_PIECE_SIZE)), 0.0f);
+        const float dy = fmaxf(fmaxf(position->y - cameraPosition->y, cameraPosition->y - (position->y + HXF_WORLD_PIECE_SIZE)), 0.0f);
+        const float dz = fmaxf(fmaxf(position->z - cameraPosition->z, cameraPosition->z - (position->z + HXF_WORLD_PIECE_SIZE)), 0.0f);
+
+        float bucket = sqrtf(dx * dx + dy * dy + dz * dz) / PIECE_SORT_BUCKET_WIDTH;
+        if (bucket > PIECE_SORT_BUCKET_COUNT - 1) {
+            bucket = PIECE_SORT_BUCKET_COUNT - 1;
+        }
+
+        pieceBuckets[i] = (uint8_t)bucket;
+        bucketOffsets[pieceBuckets[i]]++;
+    }
+
+    // Each bucket starts after the pieces of the nearer buckets
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i != PIECE_SORT_BUCKET_COUNT; i++) {
+        const uint32_t bucketSize = bucketOffsets[i];
+        bucketOffsets[i] = offset;
+        offset += bucketSize;
+    }
+
+    for (uint32_t i = 0; i != pieceCount; i++) {
+        drawingData->pieceDrawOrder[bucketOffsets[pieceBuckets[i]]++] = i;
+    }
 }
 
 void hxfGraphicsUpdateCubeBuffer(HxfGraphicsHandler* restrict graphics) {
-    void* data;
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, graphics->drawingData.transferBufferOffset, graphics->drawingData.cubeInstancesSize, 0, &data));
+    if (graphics->gpuTimings) {
+        graphics->gpuPassDurations[HXF_GPU_PASS_UPLOAD] = 0.0;
+    }
+
+    void* const data = graphics->drawingData.transferBufferAllocation.data;
     memcpy(data, graphics->drawingData.cubeInstances, graphics->drawingData.cubeInstancesSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
 
-    transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.cubeInstancesOffset - graphics->drawingData.deviceBufferOffset, graphics->drawingData.cubeInstancesSize);
+    transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.cubeInstancesOffset, graphics->drawingData.cubeInstancesSize);
+
+    // The pieces are only read by the cull compute shader
+
+    if (graphics->gpuCulling) {
+        memcpy(data, graphics->drawingData.pieces, graphics->drawingData.piecesSize);
+
+        transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.piecesOffset, graphics->drawingData.piecesSize);
+    }
+
+    // The reused command buffers draw the previous faces
+    graphics->cubeVersion++;
 }
 
 void hxfGraphicsUpdateIconBuffer(HxfGraphicsHandler* restrict graphics) {
-    void* data;
-    HXF_TRY_VK(vkMapMemory(graphics->device, graphics->hostMemory, graphics->drawingData.transferBufferOffset, graphics->drawingData.iconInstancesSize, 0, &data));
-    memcpy(data, graphics->drawingData.iconInstances, graphics->drawingData.iconInstancesSize);
-    vkUnmapMemory(graphics->device, graphics->hostMemory);
+    if (graphics->gpuTimings) {
+        graphics->gpuPassDurations[HXF_GPU_PASS_UPLOAD] = 0.0;
+    }
 
-    transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.iconInstancesOffset - graphics->drawingData.deviceBufferOffset, graphics->drawingData.iconInstancesSize);
+    memcpy(graphics->drawingData.transferBufferAllocation.data, graphics->drawingData.iconInstances, graphics->drawingData.iconInstancesSize);
+
+    transferBuffers(graphics, graphics->drawingData.transferBuffer, graphics->drawingData.deviceBuffer, 0, graphics->drawingData.iconInstancesOffset, graphics->drawingData.iconInstancesSize);
+}
+
+static void checkOptions(HxfGraphicsHandler* restrict graphics) {
+    // The cave culling is done while recording the draw calls of each piece
+    if (graphics->caveCulling && graphics->gpuCulling) {
+        HXF_MSG_ERROR("The cave culling is not used with the GPU culling, it is disabled");
+        graphics->caveCulling = 0;
+    }
+
+    // The reused command buffers draw all the faces at once, without culling them on the CPU
+    if (graphics->caveCulling && graphics->commandBufferMode == HXF_COMMAND_BUFFER_REUSE && !graphics->gpuCulling) {
+        HXF_MSG_ERROR("The cave culling is not used with the reused command buffers, it is disabled");
+        graphics->caveCulling = 0;
+    }
+
+    // The draw calls are recorded in parallel per piece group, which the GPU culling does not do
+    if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_PARALLEL && graphics->gpuCulling) {
+        HXF_MSG_ERROR("The parallel recording is not used with the GPU culling, the command buffers are reused instead");
+        graphics->commandBufferMode = HXF_COMMAND_BUFFER_REUSE;
+    }
+
+#if !defined(HXF_HEADLESS)
+    // The swapchain images may not be copied
+    if (graphics->capturePath != NULL) {
+        HXF_MSG_ERROR("The frames can only be captured by the headless build, the capture is disabled");
+        graphics->capturePath = NULL;
+    }
+#endif
 }
 
 void hxfGraphicsInit(HxfGraphicsHandler* restrict graphics) {
+    double phaseStart = hxfGetTime();
+
     createInstance(graphics);
     createDevice(graphics);
     getVulkanLimits(graphics);
+    checkOptions(graphics);
+    hxfMemoryAllocatorInit(&graphics->memoryAllocator, &graphics->physicalDeviceMemoryProperties, graphics->device);
     createSyncObjects(graphics);
     createCommandBuffers(graphics);
 
+    graphics->initDurations[HXF_GRAPHICS_INIT_DEVICE] = hxfGetTime() - phaseStart;
+    phaseStart = hxfGetTime();
+
     // Create the buffers and the images
     createRessources(graphics);
 
+    graphics->initDurations[HXF_GRAPHICS_INIT_RESSOURCES] = hxfGetTime() - phaseStart;
+    phaseStart = hxfGetTime();
+
+#if defined(HXF_HEADLESS)
+    createOffscreenImages(graphics);
+#else
     createSurface(graphics);
     createSwapchain(graphics);
+#endif
+    if (graphics->capturePath != NULL) {
+        createCaptureBuffer(graphics);
+    }
+
+    graphics->initDurations[HXF_GRAPHICS_INIT_SWAPCHAIN] = hxfGetTime() - phaseStart;
+    phaseStart = hxfGetTime();
+
     createPipelines(graphics);
     createFramebuffers(graphics);
+
+    graphics->initDurations[HXF_GRAPHICS_INIT_PIPELINES] = hxfGetTime() - phaseStart;
 }
 
 void hxfGraphicsDestroy(HxfGraphicsHandler* restrict graphics) {
@@ -1297,10 +2674,29 @@ void hxfGraphicsDestroy(HxfGraphicsHandler* restrict graphics) {
     vkDestroyPipeline(graphics->device, graphics->cubePipeline, NULL);
     vkDestroyPipeline(graphics->device, graphics->iconPipeline, NULL);
     vkDestroyPipeline(graphics->device, graphics->pointerPipeline, NULL);
+    if (graphics->depthPrepass) {
+        vkDestroyPipeline(graphics->device, graphics->depthPrepassPipeline, NULL);
+    }
+    if (graphics->vertexPulling) {
+        vkDestroyPipeline(graphics->device, graphics->cubePullingPipeline, NULL);
+    }
     vkDestroyPipelineLayout(graphics->device, graphics->cubePipelineLayout, NULL);
     vkDestroyPipelineLayout(graphics->device, graphics->iconPipelineLayout, NULL);
     vkDestroyPipelineLayout(graphics->device, graphics->pointerPipelineLayout, NULL);
+    if (graphics->gpuCulling) {
+        vkDestroyPipeline(graphics->device, graphics->cullPipeline, NULL);
+        vkDestroyPipelineLayout(graphics->device, graphics->cullPipelineLayout, NULL);
+        vkDestroyDescriptorPool(graphics->device, graphics->cullDescriptorPool, NULL);
+        vkDestroyDescriptorSetLayout(graphics->device, graphics->cullDescriptorSetLayout, NULL);
+    }
+    if (graphics->occlusionCulling) {
+        vkDestroyPipeline(graphics->device, graphics->depthPyramidPipeline, NULL);
+        vkDestroyPipelineLayout(graphics->device, graphics->depthPyramidPipelineLayout, NULL);
+        vkDestroyDescriptorPool(graphics->device, graphics->depthPyramidDescriptorPool, NULL);
+        vkDestroyDescriptorSetLayout(graphics->device, graphics->depthPyramidDescriptorSetLayout, NULL);
+    }
     vkDestroyRenderPass(graphics->device, graphics->renderPass, NULL);
+    savePipelineCache(graphics);
     vkDestroyPipelineCache(graphics->device, graphics->pipelineCache, NULL);
 
     vkDestroyDescriptorPool(graphics->device, graphics->cubeDescriptorPool, NULL);
@@ -1310,23 +2706,67 @@ void hxfGraphicsDestroy(HxfGraphicsHandler* restrict graphics) {
 
     for (int i = graphics->swapchainImageCount - 1; i != -1; i--) {
         vkDestroyImageView(graphics->device, graphics->swapchainImageView[i], NULL);
+#if defined(HXF_HEADLESS)
+        vkDestroyImage(graphics->device, graphics->swapchainImages[i], NULL);
+        hxfFreeMemory(&graphics->memoryAllocator, &graphics->offscreenImageAllocations[i]);
+#endif
     }
     hxfFree(graphics->swapchainImageView);
     hxfFree(graphics->swapchainImages);
+#if !defined(HXF_HEADLESS)
     vkDestroySwapchainKHR(graphics->device, graphics->swapchain, NULL);
     vkDestroySurfaceKHR(graphics->instance, graphics->mainWindowSurface, NULL);
+#endif
+
+    if (graphics->capturePath != NULL) {
+        vkDestroyBuffer(graphics->device, graphics->captureBuffer, NULL);
+        hxfFreeMemory(&graphics->memoryAllocator, &graphics->captureBufferAllocation);
+    }
 
     vkDestroySampler(graphics->device, graphics->drawingData.textureSampler, NULL);
     vkDestroyImage(graphics->device, graphics->drawingData.textureImage, NULL);
     vkDestroyImageView(graphics->device, graphics->drawingData.depthImageView, NULL);
     vkDestroyImage(graphics->device, graphics->drawingData.depthImage, NULL);
+    if (graphics->occlusionCulling) {
+        vkDestroyImageView(graphics->device, graphics->drawingData.depthSampledImageView, NULL);
+        vkDestroySampler(graphics->device, graphics->drawingData.depthPyramidSampler, NULL);
+        for (uint32_t i = 0; i != graphics->drawingData.depthPyramidLevelCount; i++) {
+            vkDestroyImageView(graphics->device, graphics->drawingData.depthPyramidLevelViews[i], NULL);
+        }
+        vkDestroyImageView(graphics->device, graphics->drawingData.depthPyramidImageView, NULL);
+        vkDestroyImage(graphics->device, graphics->drawingData.depthPyramidImage, NULL);
+    }
     vkDestroyImageView(graphics->device, graphics->drawingData.textureImageView, NULL);
 
     vkDestroyBuffer(graphics->device, graphics->drawingData.transferBuffer, NULL);
     vkDestroyBuffer(graphics->device, graphics->drawingData.hostBuffer, NULL);
     vkDestroyBuffer(graphics->device, graphics->drawingData.deviceBuffer, NULL);
-    vkFreeMemory(graphics->device, graphics->deviceMemory, NULL);
-    vkFreeMemory(graphics->device, graphics->hostMemory, NULL);
+    hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.transferBufferAllocation);
+    hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.hostBufferAllocation);
+    hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.deviceBufferAllocation);
+    hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.textureImageAllocation);
+    hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.depthImageAllocation);
+    if (graphics->occlusionCulling) {
+        hxfFreeMemory(&graphics->memoryAllocator, &graphics->drawingData.depthPyramidImageAllocation);
+    }
+    hxfMemoryAllocatorDestroy(&graphics->memoryAllocator);
+
+    if (graphics->commandBufferMode == HXF_COMMAND_BUFFER_PARALLEL) {
+        hxfThreadPoolDestroy(&graphics->recordThreadPool);
+
+        for (int i = HXF_RECORD_THREAD_COUNT - 1; i != -1; i--) {
+            for (int j = HXF_MAX_RENDERED_FRAMES - 1; j != -1; j--) {
+                vkDestroyCommandPool(graphics->device, graphics->recordCommandPools[i][j], NULL);
+            }
+        }
+    }
+
+    if (graphics->pipelineStatistics) {
+        vkDestroyQueryPool(graphics->device, graphics->statisticsQueryPool, NULL);
+    }
+    if (graphics->gpuTimings) {
+        vkDestroyQueryPool(graphics->device, graphics->timestampQueryPool, NULL);
+    }
 
     vkFreeCommandBuffers(graphics->device, graphics->commandPool, 1, graphics->commandBuffers);
     vkDestroyCommandPool(graphics->device, graphics->commandPool, NULL);
@@ -1342,12 +2782,38 @@ void hxfGraphicsDestroy(HxfGraphicsHandler* restrict graphics) {
     vkDestroyInstance(graphics->instance, NULL);
 }
 
-void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics) {
-    vkWaitForFences(graphics->device, 1, &graphics->imageRenderedFences[graphics->currentFrame], VK_TRUE, UINT64_MAX);
+int hxfGraphicsBeginFrame(HxfGraphicsHandler* restrict graphics) {
+    HXF_ZONE("graphics.beginFrame");
+
+    // In the low latency mode, wait for all the frames so that only one is queued
+    if (graphics->lowLatency) {
+        vkWaitForFences(graphics->device, HXF_MAX_RENDERED_FRAMES, graphics->imageRenderedFences, VK_TRUE, UINT64_MAX);
+    }
+    else {
+        vkWaitForFences(graphics->device, 1, &graphics->imageRenderedFences[graphics->currentFrame], VK_TRUE, UINT64_MAX);
+    }
+
+#if defined(HXF_HEADLESS)
+    // The offscreen image of the frame is available once its fence is signaled
+    graphics->imageIndex = graphics->currentFrame;
+#else
+    VkResult result = vkAcquireNextImageKHR(graphics->device, graphics->swapchain, HXF_ACQUIRE_TIMEOUT, graphics->nextImageAvailableSemaphores[graphics->currentFrame], VK_NULL_HANDLE, &graphics->imageIndex);
+
+    // The fence is only reset once an image is acquired, otherwise the next wait would never end
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        return 0;
+    }
+#endif
+
     vkResetFences(graphics->device, 1, &graphics->imageRenderedFences[graphics->currentFrame]);
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(graphics->device, graphics->swapchain, UINT64_MAX, graphics->nextImageAvailableSemaphores[graphics->currentFrame], NULL, &imageIndex);
+    return 1;
+}
+
+void hxfGraphicsEndFrame(HxfGraphicsHandler* restrict graphics) {
+    HXF_ZONE("graphics.endFrame");
+
+    const uint32_t imageIndex = graphics->imageIndex;
 
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
@@ -1360,20 +2826,59 @@ void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics) {
     submitInfo.pCommandBuffers = &graphics->drawCommandBuffers[graphics->currentFrame];
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = &graphics->nextImageSubmitedSemaphores[graphics->currentFrame];
+#if defined(HXF_HEADLESS)
+    // No image is acquired nor presented
+    submitInfo.waitSemaphoreCount = 0;
+    submitInfo.signalSemaphoreCount = 0;
+#endif
 
-    if (graphics->camera->isPointingToCube) {
-        updatePointedCubeBuffer(graphics);
+    updateFrameData(graphics, graphics->currentFrame);
+
+    if (graphics->occlusionCulling) {
+        updateOcclusionData(graphics, graphics->currentFrame);
+    }
+    if (graphics->caveCulling) {
+        updateVisiblePieces(graphics);
+    }
+    if (!graphics->gpuCulling && graphics->commandBufferMode != HXF_COMMAND_BUFFER_REUSE) {
+        updatePieceDrawOrder(graphics);
+    }
+
+    // The frame's previous query is complete, as its fence has been waited for
+    if (graphics->pipelineStatistics && graphics->isStatisticsQueryWritten[graphics->currentFrame]) {
+        uint64_t statistics[3];
+        VkResult result = vkGetQueryPoolResults(
+            graphics->device,
+            graphics->statisticsQueryPool,
+            graphics->currentFrame, 1,
+            sizeof(statistics), statistics, sizeof(statistics),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if (result == VK_SUCCESS) {
+            graphics->vertexInvocationCount = statistics[0];
+            graphics->clippingPrimitiveCount = statistics[1];
+            graphics->fragmentInvocationCount = statistics[2];
+        }
     }
 
-    // The uniforms buffer must be the last buffer to be updated as other functions may overwrite
-    // the memory where the buffer is bound.
-    updateMvpBuffer(graphics);
+    // Same for the timestamps, the frames are read back in the order they were submitted
+    if (graphics->gpuTimings && graphics->isTimestampQueryWritten[graphics->currentFrame]) {
+        readFrameTimings(graphics, graphics->currentFrame);
+    }
 
+    const double recordStart = hxfGetTime();
     vkResetCommandBuffer(graphics->drawCommandBuffers[graphics->currentFrame], 0);
     recordDrawCommandBuffer(graphics, imageIndex, graphics->currentFrame);
+    graphics->recordDuration = hxfGetTime() - recordStart;
+
+    if (graphics->occlusionCulling) {
+        graphics->previousViewProjection = graphics->drawingData.viewProjection;
+        graphics->hasDepthPyramid = 1;
+    }
 
     HXF_TRY_VK(vkQueueSubmit(graphics->graphicsQueue, 1, &submitInfo, graphics->imageRenderedFences[graphics->currentFrame]));
 
+#if !defined(HXF_HEADLESS)
     VkPresentInfoKHR presentInfo = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .waitSemaphoreCount = 1,
@@ -1384,10 +2889,65 @@ void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics) {
     };
 
     vkQueuePresentKHR(graphics->graphicsQueue, &presentInfo);
+#endif
 
+    // The captured frame is written as soon as it is rendered
+    if (graphics->capturePath != NULL && graphics->frameCount == graphics->captureFrame) {
+        vkWaitForFences(graphics->device, 1, &graphics->imageRenderedFences[graphics->currentFrame], VK_TRUE, UINT64_MAX);
+        writeCaptureImage(graphics);
+    }
+
+    graphics->frameCount++;
     graphics->currentFrame = (graphics->currentFrame + 1) % HXF_MAX_RENDERED_FRAMES;
 }
 
+void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics) {
+    HXF_ZONE("graphics.frame");
+
+    if (hxfGraphicsBeginFrame(graphics)) {
+        hxfGraphicsEndFrame(graphics);
+    }
+}
+
 void hxfGraphicsStop(HxfGraphicsHandler* restrict graphics) {
     vkDeviceWaitIdle(graphics->device);
+}
+
+int hxfGraphicsReadRemainingTimings(HxfGraphicsHandler* restrict graphics) {
+    if (!graphics->gpuTimings) {
+        return 0;
+    }
+
+    // The frame that would be recorded next is the oldest one still unread
+    for (uint32_t i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+        const uint32_t frameIndex = (graphics->currentFrame + i) % HXF_MAX_RENDERED_FRAMES;
+        if (graphics->isTimestampQueryWritten[frameIndex]) {
+            readFrameTimings(graphics, frameIndex);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+double hxfGraphicsGetGpuPassTime(const HxfGraphicsHandler* restrict graphics, HxfGpuPass pass) {
+    if (!graphics->gpuTimings || graphics->gpuPassDurations[pass] < 0.0) {
+        return -1.0;
+    }
+
+    return graphics->gpuPassDurations[pass] * 1000.0;
+}
+
+const char* hxfGraphicsGetGpuPassName(HxfGpuPass pass) {
+    static const char* const names[HXF_GPU_PASS_COUNT] = {
+        "frame",
+        "cull",
+        "cubes",
+        "icon",
+        "pointer",
+        "depth_pyramid",
+        "upload"
+    };
+
+    return names[pass];
 }
\ No newline at end of file
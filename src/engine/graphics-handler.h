@@ -6,6 +6,8 @@
 #include "../camera.h"
 #include "../input.h"
 #include "../world.h"
+#include "../thread/thread-pool.h"
+#include "memory-allocator.h"
 
 #include <stdalign.h>
 
@@ -13,6 +15,13 @@
  * @brief The maximum number of frames that can be rendered at the same time.
  */
 #define HXF_MAX_RENDERED_FRAMES 2
+/**
+ * @brief How long (in nanoseconds) hxfGraphicsBeginFrame waits for a swapchain image.
+ *
+ * When no image is available in time, for example while the window is minimized, the frame is
+ * skipped instead of blocking the game loop.
+ */
+#define HXF_ACQUIRE_TIMEOUT 100000000
 
 #define HXF_CUBE_VERTEX_DATA_COUNT 24
 #define HXF_CUBE_VERTEX_INDEX_COUNT 36
@@ -25,7 +34,17 @@
 
 #define HXF_POINTER_VERTEX_COUNT 12
 
-#define HXF_TEXTURE_COUNT 5
+/**
+ * @brief The size (in pixels) of a face’s texture in textures.png.
+ */
+#define HXF_TEXTURE_SIZE 16
+/**
+ * @brief The number of faces’ textures in each row of textures.png, a row is a texture index.
+ *
+ * Each face texture is a layer of the texture image, the layer of a face is
+ * textureIndex * HXF_TEXTURE_FACE_COUNT + its column.
+ */
+#define HXF_TEXTURE_FACE_COUNT 6
 
 #define HXF_FACES_TOP_OFFSET     0 * HXF_CUBE_INSTANCE_COUNT
 #define HXF_FACES_BACK_OFFSET    1 * HXF_CUBE_INSTANCE_COUNT
@@ -34,20 +53,94 @@
 #define HXF_FACES_RIGHT_OFFSET   4 * HXF_CUBE_INSTANCE_COUNT
 #define HXF_FACES_LEFT_OFFSET    5 * HXF_CUBE_INSTANCE_COUNT
 
+/**
+ * @brief The number of faces direction (top, back, bottom, front, right and left).
+ */
+#define HXF_FACE_DIRECTION_COUNT 6
+
+/**
+ * @brief The maximum number of world pieces that can be drawn.
+ */
+#define HXF_PIECE_COUNT HXF_HORIZONTAL_VIEW_DISTANCE * HXF_HORIZONTAL_VIEW_DISTANCE * HXF_VERTICAL_VIEW_DISTANCE
+
+/**
+ * @brief The number of invocations of a workgroup of the cull compute shader.
+ */
+#define HXF_CULL_WORKGROUP_SIZE 64
+
+/**
+ * @brief The width and height of a workgroup of the depth pyramid compute shader.
+ */
+#define HXF_DEPTH_PYRAMID_WORKGROUP_SIZE 8
+
+/**
+ * @brief The number of worker threads that record the pieces’ draw calls in the parallel recording mode.
+ */
+#define HXF_RECORD_THREAD_COUNT 4
+
+/**
+ * @brief The maximum number of mip levels of the depth pyramid (enough for a 32768 pixels wide window).
+ */
+#define HXF_DEPTH_PYRAMID_MAX_LEVEL_COUNT 16
+
+/**
+ * @brief How the draw command buffers are recorded each frame.
+ */
+typedef enum HxfCommandBufferMode {
+    HXF_COMMAND_BUFFER_RECORD, ///< Everything is recorded again in the primary command buffer.
+    /**
+     * @brief The cubes are drawn by secondary command buffers that are recorded again only when
+     * the faces change.
+     *
+     * Without the GPU culling, all the faces of each direction are drawn, the CPU culling is not used.
+     */
+    HXF_COMMAND_BUFFER_REUSE,
+    HXF_COMMAND_BUFFER_PARALLEL ///< The pieces’ draw calls are recorded in secondary command buffers by worker threads.
+} HxfCommandBufferMode;
+
+/**
+ * @brief The phases of hxfGraphicsInit, their durations are measured.
+ */
+typedef enum HxfGraphicsInitPhase {
+    HXF_GRAPHICS_INIT_DEVICE, ///< The instance, the device, the synchronization objects and the command buffers.
+    HXF_GRAPHICS_INIT_RESSOURCES, ///< The images, the texture loading and the memory allocation.
+    HXF_GRAPHICS_INIT_SWAPCHAIN, ///< The surface and the swapchain.
+    HXF_GRAPHICS_INIT_PIPELINES, ///< The render pass, the descriptors, the pipelines and the framebuffers.
+    HXF_GRAPHICS_INIT_PHASE_COUNT
+} HxfGraphicsInitPhase;
+
+/**
+ * @brief The parts of the GPU work that are measured with timestamps when the GPU timings are enabled.
+ *
+ * The passes are measured from the top to the bottom of the pipeline, so the device may overlap
+ * them with the work that comes before or after them.
+ */
+typedef enum HxfGpuPass {
+    HXF_GPU_PASS_FRAME, ///< The whole frame, from its first command to its last one.
+    HXF_GPU_PASS_CULL, ///< The cull compute shader, only with the GPU culling.
+    HXF_GPU_PASS_CUBES, ///< The cubes, with the depth prepass if it is enabled.
+    HXF_GPU_PASS_ICON, ///< The cube selector icon.
+    HXF_GPU_PASS_POINTER, ///< The pointer.
+    HXF_GPU_PASS_DEPTH_PYRAMID, ///< The depth pyramid, only with the occlusion culling.
+    HXF_GPU_PASS_UPLOAD, ///< The transfers of the last hxfGraphicsUpdateCubeBuffer or hxfGraphicsUpdateIconBuffer, outside of the frames.
+    HXF_GPU_PASS_COUNT
+} HxfGpuPass;
+
 typedef struct HxfCubeInstanceData {
     alignas(16) HxfVec3 position;
-    alignas(4)  uint32_t textureIndex;
+    alignas(2)  uint16_t textureIndex;
+    alignas(2)  uint16_t size; ///< The width of the cube (in cubes), larger than 1 for the levels of detail.
 } HxfCubeInstanceData;
 
 typedef struct HxfCubeVertexData {
     alignas(16) HxfVec3 position;
-    alignas(8)  HxfVec2 texelCoordinate;
-    alignas(4)  uint32_t textureIndex;
+    alignas(8)  HxfVec2 texelCoordinate; ///< The coordinate inside the face’s texture, from 0 to 1.
+    alignas(4)  uint32_t textureColumn; ///< The column of the face’s texture in textures.png.
 } HxfCubeVertexData;
 
 typedef struct HxfIconVertexData {
     alignas(8) HxfVec2 position;
-    alignas(8) HxfVec2 texelCoordinate;
+    alignas(8) HxfVec2 texelCoordinate; ///< The coordinate inside the front face’s texture, from 0 to 1.
 } HxfIconVertexData;
 
 typedef struct HxfIconInstanceData {
@@ -64,6 +157,55 @@ typedef struct HxfPointerPushConstantData {
     alignas(4) uint32_t windowHeight;
 } HxfPointerPushConstantData;
 
+/**
+ * @brief Faces of a world piece and its bounds, as read by the cull compute shader.
+ *
+ * The faces of a piece are contiguous inside each direction of the cube instances.
+ * The directions are in the same order as the HXF_FACES_*_OFFSET.
+ */
+typedef struct HxfPieceDrawData {
+    alignas(16) HxfVec3 position; ///< The minimum corner of the piece, in world coordinates.
+    alignas(4)  uint32_t faceOffsets[HXF_FACE_DIRECTION_COUNT]; ///< The index of the first instance of each direction.
+    alignas(4)  uint32_t faceCounts[HXF_FACE_DIRECTION_COUNT]; ///< The number of instances of each direction.
+} HxfPieceDrawData;
+
+typedef struct HxfCullPushConstantData {
+    alignas(16) HxfVec4 frustumPlanes[6]; ///< The planes of the view frustum (left, right, bottom, top, near, far).
+    alignas(16) HxfVec3 cameraPosition; ///< The camera position, used to skip the faces that can not face it.
+    alignas(4)  uint32_t pieceCount; ///< The number of pieces to cull.
+    alignas(4)  uint32_t vertexPulling; ///< 1 if non-indexed draw commands are written for the vertex pulling.
+} HxfCullPushConstantData;
+
+/**
+ * @brief Occlusion culling data of a frame, read and written by the cull compute shader.
+ *
+ * The host writes the data used by the occlusion test and reads back the counters once the
+ * frame has been rendered.
+ */
+typedef struct HxfOcclusionData {
+    alignas(16) HxfMat4 viewProjection; ///< The view projection matrix the depth pyramid was rendered with.
+    alignas(8)  HxfVec2 pyramidSize; ///< The size of the first level of the depth pyramid.
+    alignas(4)  uint32_t pyramidLevelCount; ///< The number of levels of the depth pyramid.
+    alignas(4)  uint32_t isEnabled; ///< 0 if there is no depth pyramid to test against yet.
+    alignas(4)  uint32_t culledPieceCount; ///< The number of pieces culled by the occlusion test.
+    alignas(4)  uint32_t culledFaceCount; ///< The number of faces of the pieces culled by the occlusion test.
+} HxfOcclusionData;
+
+typedef struct HxfDepthPyramidPushConstantData {
+    alignas(8) int32_t inputSize[2]; ///< The size of the level that is read.
+    alignas(8) int32_t outputSize[2]; ///< The size of the level that is written.
+} HxfDepthPyramidPushConstantData;
+
+/**
+ * @brief The data that changes each frame, there is one in the host memory for each rendered frame.
+ *
+ * The matrix is read by cube.vert as a uniform buffer and the pointed cube as an instance.
+ */
+typedef struct HxfFrameData {
+    alignas(16) HxfMat4 viewProjection; ///< The product of the model, view and projection matrices.
+    alignas(16) HxfCubeInstanceData pointedCube; ///< The instance of the cube the camera is pointing to.
+} HxfFrameData;
+
 typedef struct HxfMvpData {
     alignas(16) HxfMat4 model;
     alignas(16) HxfMat4 view;
@@ -81,13 +223,29 @@ typedef struct HxfDrawingData {
     VkBuffer deviceBuffer; ///< Buffer on the host memory.
     VkBuffer transferBuffer; ///< Buffer on the host memory that can transfer data to the device buffer.
 
-    VkImage textureImage;
-    VkImageView textureImageView;
+    VkImage textureImage; ///< An array of the faces’ textures, with their mip levels.
+    VkImageView textureImageView; ///< A 2D array view of all the layers and levels of the texture image.
     VkSampler textureSampler;
+    uint32_t textureLayerCount; ///< The number of faces’ textures in the texture image.
+    uint32_t textureMipLevelCount; ///< The number of mip levels of the texture image.
 
     VkImage depthImage; ///< The depth image
     VkImageView depthImageView; /// The image view of the depth image
     VkFormat depthImageFormat; ///< The format of the depth image
+    VkImageAspectFlags depthImageAspects; ///< The aspects of the depth image, it only has a stencil with the depth prepass.
+    VkImageView depthSampledImageView; ///< A view of the depth aspect alone, sampled to build the depth pyramid with the occlusion culling.
+
+    /**
+     * @brief The depth pyramid, each texel contains the farthest depth of the texels it covers in the depth image.
+     *
+     * It is only created when the occlusion culling is enabled, and stays in the general layout.
+     */
+    VkImage depthPyramidImage;
+    VkImageView depthPyramidImageView; ///< View of all the levels, read by the cull compute shader.
+    VkImageView depthPyramidLevelViews[HXF_DEPTH_PYRAMID_MAX_LEVEL_COUNT]; ///< A view for each level.
+    VkExtent2D depthPyramidExtent; ///< The size of the first level, the same as the depth image.
+    uint32_t depthPyramidLevelCount; ///< The number of levels of the depth pyramid.
+    VkSampler depthPyramidSampler; ///< Sampler of the depth image and the depth pyramid.
 
     HxfCubeVertexData cubesVertices[HXF_CUBE_VERTEX_DATA_COUNT];
     HxfCubeInstanceData* cubeInstances; ///< Data for each cubes faces (6 * HXF_CUBE_INSTANCE_COUNT)
@@ -97,7 +255,14 @@ typedef struct HxfDrawingData {
     HxfIconInstanceData iconInstances[HXF_ICON_INSTANCE_DATA_COUNT];
     uint32_t iconVertexIndices[HXF_ICON_VERTEX_INDEX_COUNT];
 
-    HxfMvpData mvp; ///< The model-view-projection matrices
+    HxfMvpData mvp; ///< The model-view-projection matrices, only used by the host.
+    HxfMat4 viewProjection; ///< The product of the mvp matrices, updated each frame.
+
+    HxfPieceDrawData pieces[HXF_PIECE_COUNT]; ///< The faces and bounds of each piece that is drawn.
+    uint32_t pieceCount; ///< The number of elements of pieces.
+    uint16_t pieceConnectivities[HXF_PIECE_COUNT]; ///< The sides of each piece that see each other (hxfWorldGetPieceConnectivity), only with the cave culling.
+    uint8_t isPieceVisible[HXF_PIECE_COUNT]; ///< Set to 1 if the piece may be seen from the camera’s piece, updated each frame with the cave culling.
+    uint32_t pieceDrawOrder[HXF_PIECE_COUNT]; ///< The indices of the pieces in the order they are drawn, from the nearest to the farthest with the piece sorting.
 
     size_t faceFrontCount;  // Number of front faces to draw 
     size_t faceBackCount;   // Number of back faces to draw 
@@ -106,7 +271,7 @@ typedef struct HxfDrawingData {
     size_t faceRightCount;  // Number of right faces to draw
     size_t faceLeftCount;   // Number of left faces to draw
 
-    // Memory offsets and sizes
+    // Offsets inside their buffer and sizes
 
     VkDeviceSize cubesVerticesOffset;
     VkDeviceSize cubesVerticesSize;
@@ -114,24 +279,29 @@ typedef struct HxfDrawingData {
     VkDeviceSize cubesVertexIndicesSize;
     VkDeviceSize cubeInstancesOffset;
     VkDeviceSize cubeInstancesSize;
-    VkDeviceSize pointedCubeOffset;
-    VkDeviceSize pointedCubeSize;
     VkDeviceSize iconVerticesOffset;
     VkDeviceSize iconVerticesSize;
     VkDeviceSize iconVertexIndicesOffset;
     VkDeviceSize iconVertexIndicesSize;
     VkDeviceSize iconInstancesOffset;
     VkDeviceSize iconInstancesSize;
-    VkDeviceSize mvpOffset;
-    VkDeviceSize mvpSize;
-    VkDeviceSize depthImageOffset; ///< Offset of the depth image inside the memory
-    VkDeviceSize depthImageSize; ///< Size of the depth image inside the memory
-    VkDeviceSize textureImageOffset;
-    VkDeviceSize textureImageSize;
-
-    VkDeviceSize hostBufferOffset;
-    VkDeviceSize deviceBufferOffset;
-    VkDeviceSize transferBufferOffset;
+    VkDeviceSize frameDataOffset; ///< Offset of the HxfFrameData of the first frame, the others follow.
+    VkDeviceSize frameDataSize; ///< The size of the HxfFrameData of a frame, including its alignment.
+    VkDeviceSize occlusionDataOffset; ///< Offset of the HxfOcclusionData of the first frame, the others follow (only with the GPU culling).
+    VkDeviceSize occlusionDataSize; ///< The size of the HxfOcclusionData of a frame, including its alignment.
+    VkDeviceSize piecesOffset;
+    VkDeviceSize piecesSize;
+    VkDeviceSize drawCommandsOffset; ///< Offset of the indirect draw commands written by the cull compute shader.
+    VkDeviceSize drawCommandsSize;
+
+    // Memory of the buffers and the images
+
+    HxfAllocation hostBufferAllocation; ///< The memory of the host buffer, it stays mapped.
+    HxfAllocation deviceBufferAllocation;
+    HxfAllocation transferBufferAllocation; ///< The memory of the transfer buffer, it stays mapped.
+    HxfAllocation depthImageAllocation;
+    HxfAllocation depthPyramidImageAllocation;
+    HxfAllocation textureImageAllocation;
 } HxfDrawingData;
 
 /**
@@ -157,7 +327,7 @@ typedef struct HxfGraphicsHandler {
     VkPhysicalDeviceLimits physicalDeviceLimits; ///< The limits of the physical device.
     VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties; ///< The memory properties of the physical device.
 
-    VkSwapchainKHR swapchain; ///< The swapchain
+    VkSwapchainKHR swapchain; ///< The swapchain, the headless build has offscreen images instead.
     VkImage* swapchainImages; ///< The images of the swapchain
     VkImageView* swapchainImageView; ///< The image views of the swapchain created from the swapchain images.
     VkFramebuffer* swapchainFramebuffers; ///< The framebuffers of the swapchain.
@@ -166,6 +336,7 @@ typedef struct HxfGraphicsHandler {
     VkExtent2D swapchainExtent; ///< The extent of the swapchain’s images.
 
     VkPipelineCache pipelineCache; ///< The cache for the pipelines.
+    int printPipelineTime; ///< If set to 1, the time spent creating the pipelines is printed.
     VkPipeline cubePipeline; ///< The pipeline that draw the cubes.
     VkPipeline iconPipeline; ///< The pipeline that draw the icons.
     VkPipeline pointerPipeline; ///< The pipeline that draw the pointer.
@@ -180,6 +351,166 @@ typedef struct HxfGraphicsHandler {
     VkDescriptorSet cubeDescriptorSets[HXF_MAX_RENDERED_FRAMES]; ///< The cubes’ descriptor sets.
     VkDescriptorSet iconDescriptorSets[HXF_MAX_RENDERED_FRAMES]; ///< The icons’ descriptor sets.
 
+    /**
+     * @brief If set to 1, the cubes are culled by a compute shader that writes indirect draws.
+     *
+     * It is set back to 0 during the initialization if the device does not support
+     * multiDrawIndirect and drawIndirectFirstInstance.
+     */
+    int gpuCulling;
+    VkPipeline cullPipeline; ///< The compute pipeline that culls the pieces.
+    VkPipelineLayout cullPipelineLayout; ///< The pipeline layout of the cull pipeline.
+    VkDescriptorPool cullDescriptorPool; ///< The descriptor pool for the cull descriptor.
+    VkDescriptorSetLayout cullDescriptorSetLayout; ///< The descriptor set layout of the cull descriptor.
+    VkDescriptorSet cullDescriptorSets[HXF_MAX_RENDERED_FRAMES]; ///< The cull descriptor sets.
+
+    /**
+     * @brief If set to 1, the pieces hidden behind the previous frame's depth are also culled.
+     *
+     * It needs the GPU culling, and is set back to 0 if the GPU culling is disabled or if the
+     * depth image can not be sampled.
+     */
+    int occlusionCulling;
+    VkPipeline depthPyramidPipeline; ///< The compute pipeline that builds a level of the depth pyramid.
+    VkPipelineLayout depthPyramidPipelineLayout; ///< The pipeline layout of the depth pyramid pipeline.
+    VkDescriptorPool depthPyramidDescriptorPool; ///< The descriptor pool for the depth pyramid descriptors.
+    VkDescriptorSetLayout depthPyramidDescriptorSetLayout; ///< The descriptor set layout of the depth pyramid descriptors.
+    VkDescriptorSet depthPyramidDescriptorSets[HXF_DEPTH_PYRAMID_MAX_LEVEL_COUNT]; ///< A descriptor set for each level.
+    HxfMat4 previousViewProjection; ///< The view projection matrix of the last recorded frame.
+    int hasDepthPyramid; ///< Set to 1 once a frame has built the depth pyramid.
+    uint32_t occlusionCulledPieceCount; ///< The number of pieces culled by the occlusion test in the last rendered frame.
+    uint32_t occlusionCulledFaceCount; ///< The number of faces culled by the occlusion test in the last rendered frame.
+
+    /**
+     * @brief If set to 1, only the pieces that can be reached through air from the camera’s piece are drawn.
+     *
+     * It only applies when the cubes are culled on the CPU, so it is set back to 0 during the
+     * initialization when the GPU culling is used or when the command buffers are reused.
+     */
+    int caveCulling;
+
+    HxfCommandBufferMode commandBufferMode; ///< How the draw command buffers are recorded.
+    VkCommandBuffer cubeCommandBuffers[HXF_MAX_RENDERED_FRAMES]; ///< Secondary command buffers that draw the cubes, in the reuse mode.
+    uint32_t cubeCommandBufferVersions[HXF_MAX_RENDERED_FRAMES]; ///< The cubeVersion each cube command buffer was recorded with.
+    uint32_t cubeVersion; ///< Incremented each time the cubes are updated, 0 means never recorded.
+    VkCommandBuffer overlayCommandBuffers[HXF_MAX_RENDERED_FRAMES]; ///< Secondary command buffers that draw the pointed cube, the icon and the pointer.
+    HxfThreadPool recordThreadPool; ///< The worker threads of the parallel mode.
+    VkCommandPool recordCommandPools[HXF_RECORD_THREAD_COUNT][HXF_MAX_RENDERED_FRAMES]; ///< A command pool for each worker task and frame.
+    VkCommandBuffer recordCommandBuffers[HXF_RECORD_THREAD_COUNT][HXF_MAX_RENDERED_FRAMES]; ///< The secondary command buffers recorded by the worker tasks.
+    double recordDuration; ///< The CPU time (in seconds) spent recording the last frame’s command buffers.
+    double initDurations[HXF_GRAPHICS_INIT_PHASE_COUNT]; ///< The duration (in seconds) of each phase of hxfGraphicsInit.
+
+    /**
+     * @brief The present mode of the swapchain.
+     *
+     * It is set back to VK_PRESENT_MODE_FIFO_KHR, which is always available, if the surface
+     * does not support it.
+     */
+    VkPresentModeKHR presentMode;
+    /**
+     * @brief If set to 1, a frame only begins once all the previous frames are rendered.
+     *
+     * A single frame is queued at a time, so the input read after hxfGraphicsBeginFrame is
+     * displayed as soon as possible.
+     */
+    int lowLatency;
+    uint32_t imageIndex; ///< The swapchain image acquired by hxfGraphicsBeginFrame.
+
+    /**
+     * @brief If set to 1, the pieces are drawn from the nearest to the farthest from the camera.
+     *
+     * The nearest cubes are drawn first so the depth test discards the fragments they hide
+     * before they are shaded. It only applies when the pieces are drawn one by one, so without
+     * the GPU culling and the reuse mode.
+     */
+    int sortPieces;
+    /**
+     * @brief If set to 1, the depth of the cubes is drawn before the cubes themselves.
+     *
+     * The cubes are then only shaded where they are visible, which helps when the rendering is
+     * limited by the fragment shading, at the cost of drawing the vertices twice. The prepass
+     * marks the pixels it covers in the stencil, and each of them is shaded once, by the first
+     * fragment at the prepass depth, so the frame is the same as without the prepass.
+     */
+    int depthPrepass;
+    VkPipeline depthPrepassPipeline; ///< The pipeline that only writes the depth of the cubes, with the depth prepass.
+    /**
+     * @brief If set to 1, the vertex and fragment shader invocations and the primitives output by
+     * the clipping of each frame are counted with a query.
+     *
+     * It is set back to 0 during the initialization if the device does not support the
+     * pipelineStatisticsQuery feature, or the inheritedQueries feature when the draw calls are
+     * recorded in secondary command buffers.
+     */
+    int pipelineStatistics;
+    VkQueryPool statisticsQueryPool; ///< A pipeline statistics query for each frame.
+    int isStatisticsQueryWritten[HXF_MAX_RENDERED_FRAMES]; ///< Set to 1 once the query of the frame has been submitted.
+    uint64_t vertexInvocationCount; ///< The number of vertex shader invocations of the last rendered frame.
+    uint64_t clippingPrimitiveCount; ///< The number of primitives output by the clipping of the last rendered frame.
+    uint64_t fragmentInvocationCount; ///< The number of fragment shader invocations of the last rendered frame.
+
+    /**
+     * @brief If set to 1, the distant pieces are drawn with larger cubes (hxfWorldDownsamplePiece).
+     *
+     * They have fewer faces, so more pieces can be drawn with the same number of faces.
+     */
+    int levelOfDetail;
+
+    /**
+     * @brief If set to 1, the cubes are drawn without vertex input, with the faces read from a storage buffer.
+     *
+     * Each face is drawn with 6 vertices of a non-indexed draw call instead of an instance, and
+     * the vertex shader derives the corner from gl_VertexIndex. It is set back to 0 if the cube
+     * instances are larger than maxStorageBufferRange.
+     */
+    int vertexPulling;
+    VkPipeline cubePullingPipeline; ///< The pipeline that draws the cubes with the vertex pulling.
+
+    /**
+     * @brief If set to 1, the GPU duration of each frame and of its passes is measured with timestamp queries.
+     *
+     * It is set back to 0 during the initialization if the graphics queue does not support the
+     * timestamps.
+     */
+    int gpuTimings;
+    /**
+     * @brief A timestamp at the beginning and at the end of each HxfGpuPass.
+     *
+     * There is a set of timestamps for each frame, and a last one for the uploads.
+     */
+    VkQueryPool timestampQueryPool;
+    uint32_t timestampValidBits; ///< The number of bits of the graphics queue's timestamps that are written, the others are undefined.
+    int isTimestampQueryWritten[HXF_MAX_RENDERED_FRAMES]; ///< Set to 1 once the queries of the frame have been submitted.
+    /**
+     * @brief The GPU duration (in seconds) of each pass of the frame timedFrameCount - 1, -1 if the pass was not measured.
+     *
+     * The upload is measured when it happens instead.
+     */
+    double gpuPassDurations[HXF_GPU_PASS_COUNT];
+    /**
+     * @brief The number of frames whose GPU durations have been read back.
+     *
+     * The frames are read back in order, a frame later than they are submitted.
+     */
+    uint64_t timedFrameCount;
+
+    /**
+     * @brief The path of the PPM image the frame captureFrame is written to, NULL if no frame is captured.
+     *
+     * Only the offscreen images of the headless build can be copied, it is set back to NULL
+     * otherwise.
+     */
+    const char* capturePath;
+    uint64_t captureFrame; ///< The index of the captured frame, the first frame is 0.
+    VkBuffer captureBuffer; ///< The buffer the captured frame is copied to.
+    HxfAllocation captureBufferAllocation; ///< The memory of the capture buffer, it stays mapped.
+
+#if defined(HXF_HEADLESS)
+    HxfAllocation offscreenImageAllocations[HXF_MAX_RENDERED_FRAMES]; ///< The memory of the images that replace the swapchain.
+#endif
+
+    uint64_t frameCount; ///< The number of frames submitted.
+
     VkCommandPool commandPool; ///< The command pool for the command buffers.
     /**
      * @brief All the command buffers allocated from the commandPool.
@@ -203,14 +534,16 @@ typedef struct HxfGraphicsHandler {
      */
     VkFence fence;
 
-    VkDeviceMemory hostMemory; ///< Memory that is available for the host
-    VkDeviceMemory deviceMemory; ///< Memory that is available for the device only.
+    HxfMemoryAllocator memoryAllocator; ///< Allocates the memory of the buffers and the images.
 
     uint32_t currentFrame; ///< The index of the frame that is currently rendered
 } HxfGraphicsHandler;
 
 /**
  * @brief Initialize the graphics handler.
+ *
+ * It does not read the cubes, so it can run while the world is loaded. They are uploaded
+ * afterwards with hxfGraphicsUpdateCubeBuffer.
  */
 void hxfGraphicsInit(HxfGraphicsHandler* restrict graphics);
 
@@ -219,8 +552,25 @@ void hxfGraphicsInit(HxfGraphicsHandler* restrict graphics);
  */
 void hxfGraphicsDestroy(HxfGraphicsHandler* restrict graphics);
 
+/**
+ * @brief Wait until the current frame can be rendered and acquire a swapchain image.
+ *
+ * @return 1 if an image was acquired, then hxfGraphicsEndFrame must be called. 0 if no image
+ * was available in time, then the frame must be skipped.
+ */
+int hxfGraphicsBeginFrame(HxfGraphicsHandler* restrict graphics);
+
+/**
+ * @brief Record, submit and present the frame begun by hxfGraphicsBeginFrame.
+ *
+ * The camera and the cubes are read here, so they can be updated between the two calls.
+ */
+void hxfGraphicsEndFrame(HxfGraphicsHandler* restrict graphics);
+
 /**
  * @brief Run a single frame of the graphics handler.
+ *
+ * It is the same as hxfGraphicsBeginFrame followed by hxfGraphicsEndFrame.
  */
 void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics);
 
@@ -231,8 +581,51 @@ void hxfGraphicsFrame(HxfGraphicsHandler* restrict graphics);
  */
 void hxfGraphicsStop(HxfGraphicsHandler* restrict graphics);
 
+/**
+ * @brief Read back the GPU durations of the oldest frame that was submitted but not read back yet.
+ *
+ * The last frames are only read back by the next frames, this reads them once the game loop
+ * has ended. It must be called after hxfGraphicsStop, and until it returns 0.
+ *
+ * @return 1 if a frame was read back, its durations are then returned by
+ * hxfGraphicsGetGpuPassTime, or 0 if every frame has been read back.
+ */
+int hxfGraphicsReadRemainingTimings(HxfGraphicsHandler* restrict graphics);
+
+/**
+ * @brief Get the GPU duration of a pass in the last frame that was read back.
+ *
+ * The frames are read back a frame after they are submitted, when their fence has been waited
+ * for, so reading the timestamps never stalls.
+ *
+ * @return The duration in milliseconds, or a negative value if the pass was not measured (the GPU
+ * timings are disabled or the pass did not run in that frame).
+ */
+double hxfGraphicsGetGpuPassTime(const HxfGraphicsHandler* restrict graphics, HxfGpuPass pass);
+
+/**
+ * @brief Get the name of a pass, as it is written in the logs.
+ */
+const char* hxfGraphicsGetGpuPassName(HxfGpuPass pass);
+
+/**
+ * @brief Get the directions of the faces of a piece that can face the camera.
+ *
+ * A face can only be seen from the side it is facing, for example the right faces (+x) of a
+ * piece can not be seen if the camera is on the left of all of them.
+ *
+ * @param piecePosition The minimum corner of the piece, in world coordinates.
+ * @param cameraPosition The position of the camera.
+ *
+ * @return A mask where the bit n is set if the faces of the direction n can be seen. The
+ * directions are in the same order as the HXF_FACES_*_OFFSET.
+ */
+uint32_t hxfGetVisibleFaceDirections(const HxfVec3* restrict piecePosition, const HxfVec3* restrict cameraPosition);
+
 /**
  * @brief Update the buffer that contains the cubes data.
+ *
+ * It also updates the pieces’ data that are read by the cull compute shader.
  */
 void hxfGraphicsUpdateCubeBuffer(HxfGraphicsHandler* restrict graphics);
 
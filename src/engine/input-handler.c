@@ -2,6 +2,7 @@
 #include "game-handler.h"
 #include "../input.h"
 #include "../window.h"
+#include "../profiler.h"
 
 #include <math.h>
 #include <time.h>
@@ -275,6 +276,8 @@ void hxfInputInit(HxfAppData* app) {
 }
 
 void hxfHandleInput(HxfAppData* restrict app) {
+    HXF_ZONE("input.handle");
+
     const float moveSpeed = 5.0f;
     const float repeatTime = 0.2f;
 
@@ -0,0 +1,472 @@
+#include "memory-allocator.h"
+#include "../hxf.h"
+
+#include <string.h>
+
+/**
+ * @brief The memory properties of each HxfMemoryUsage.
+ */
+typedef struct MemoryUsageProperties {
+    VkMemoryPropertyFlags required; ///< The properties the memory type must have.
+    VkMemoryPropertyFlags preferred; ///< The properties the memory type should have.
+    VkMemoryPropertyFlags unwanted; ///< The properties the memory type should not have.
+} MemoryUsageProperties;
+
+static const MemoryUsageProperties memoryUsageProperties[HXF_MEMORY_USAGE_COUNT] = {
+    // The host visible device memory is small, it is kept for the dynamic data
+    [HXF_MEMORY_USAGE_DEVICE] = {
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        0,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    },
+    [HXF_MEMORY_USAGE_UPLOAD] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        0,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    },
+    // The device reads it faster if it is also device local
+    [HXF_MEMORY_USAGE_DYNAMIC] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        0
+    },
+    // The host reads the cached memory faster
+    [HXF_MEMORY_USAGE_READBACK] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        0
+    }
+};
+
+/*
+STATIC FORWARD DECLARATION
+*/
+
+/**
+ * @brief Find the memory type that suits a memory usage the best.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param memoryTypeBits The memory types that can be used, from the VkMemoryRequirements.
+ * @param usage How the memory is accessed.
+ *
+ * @return The index of the memory type.
+ */
+static uint32_t findMemoryType(const HxfMemoryAllocator* restrict allocator, uint32_t memoryTypeBits, HxfMemoryUsage usage);
+
+/**
+ * @brief Align an object according to its memory requirements.
+ *
+ * @param memoryRequirements A pointer to the VkMemoryRequirements that describe the needs for the object.
+ * @param memoryOffset The offset where the alignement starts. It is then increased with the size of the
+ * object (and the alignement).
+ * @param objectOffset A pointer to the object memory offset that will be modified.
+ * @param objectSize A pointer to the object memory size that will be modified.
+ */
+static void alignObject(const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict memoryOffset, VkDeviceSize* restrict objectOffset, VkDeviceSize* restrict objectSize);
+
+/**
+ * @brief Allocate memory from the pool of the memory type, strategy and resource kind.
+ *
+ * A new block is allocated if no block of the pool has enough space.
+ */
+static VkResult allocate(HxfMemoryAllocator* restrict allocator, const VkMemoryRequirements* restrict memoryRequirements, HxfMemoryUsage usage, HxfAllocationStrategy strategy, int isImage, HxfAllocation* restrict allocation);
+
+/**
+ * @brief Allocate a new block at the end of a pool.
+ *
+ * @return VK_SUCCESS, or the error of vkAllocateMemory or vkMapMemory.
+ */
+static VkResult createBlock(HxfMemoryAllocator* restrict allocator, HxfMemoryPool* restrict pool, uint32_t memoryTypeIndex, VkDeviceSize size);
+
+/**
+ * @brief Free a block of a pool and remove it from the pool.
+ */
+static void destroyBlock(HxfMemoryAllocator* restrict allocator, HxfMemoryPool* restrict pool, uint32_t memoryTypeIndex, uint32_t blockIndex);
+
+/**
+ * @brief Place an object in a block.
+ *
+ * @param block The block.
+ * @param strategy The strategy of the block’s pool.
+ * @param memoryRequirements The needs of the object.
+ * @param offset A pointer to the offset that receives the object’s offset in the block.
+ *
+ * @return 1 if the object fits in the block, 0 otherwise.
+ */
+static int allocateFromBlock(HxfMemoryBlock* restrict block, HxfAllocationStrategy strategy, const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict offset);
+
+/**
+ * @brief Give a range back to the free ranges of a block, it is merged with its neighbours.
+ */
+static void freeRange(HxfMemoryBlock* restrict block, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Insert a free range in a block.
+ *
+ * @param block The block.
+ * @param index The index the range is inserted at, so that the ranges stay sorted.
+ * @param offset The offset of the range.
+ * @param size The size of the range.
+ */
+static void insertFreeRange(HxfMemoryBlock* restrict block, uint32_t index, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Remove a free range of a block.
+ */
+static void removeFreeRange(HxfMemoryBlock* restrict block, uint32_t index);
+
+/*
+IMPLEMENTATION
+*/
+
+VkDeviceSize hxfGetAlignement(VkDeviceSize alignementRequirement, VkDeviceSize offset) {
+    VkDeviceSize alignement = offset % alignementRequirement;
+    return (alignement == 0)
+        ? 0
+        : alignementRequirement - alignement;
+}
+
+static void alignObject(const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict memoryOffset, VkDeviceSize* restrict objectOffset, VkDeviceSize* restrict objectSize) {
+    *objectOffset = *memoryOffset + hxfGetAlignement(memoryRequirements->alignment, *memoryOffset);
+    *objectSize = memoryRequirements->size;
+    *memoryOffset = *objectOffset + *objectSize;
+}
+
+static uint32_t findMemoryType(const HxfMemoryAllocator* restrict allocator, uint32_t memoryTypeBits, HxfMemoryUsage usage) {
+    const MemoryUsageProperties* const properties = &memoryUsageProperties[usage];
+    uint32_t index = UINT32_MAX;
+    int lowestCost = INT32_MAX;
+
+    // The cost is the number of preferred properties missing and of unwanted properties present
+
+    for (uint32_t i = 0; i != allocator->memoryProperties.memoryTypeCount; i++) {
+        const VkMemoryPropertyFlags flags = allocator->memoryProperties.memoryTypes[i].propertyFlags;
+
+        if ((memoryTypeBits & (1u << i)) == 0 || (flags & properties->required) != properties->required) {
+            continue;
+        }
+
+        const int cost = __builtin_popcount(properties->preferred & ~flags) + __builtin_popcount(properties->unwanted & flags);
+        if (cost < lowestCost) {
+            index = i;
+            lowestCost = cost;
+        }
+    }
+
+    if (index == UINT32_MAX) {
+        HXF_FATAL("Could not find a compatible memory type");
+    }
+
+    return index;
+}
+
+static void insertFreeRange(HxfMemoryBlock* restrict block, uint32_t index, VkDeviceSize offset, VkDeviceSize size) {
+    if (block->freeRangeCount == block->freeRangeCapacity) {
+        block->freeRangeCapacity *= 2;
+        block->freeRanges = hxfRealloc(block->freeRanges, sizeof(HxfMemoryRange) * block->freeRangeCapacity, HXF_ALLOC_GRAPHICS);
+    }
+
+    memmove(&block->freeRanges[index + 1], &block->freeRanges[index], sizeof(HxfMemoryRange) * (block->freeRangeCount - index));
+    block->freeRanges[index].offset = offset;
+    block->freeRanges[index].size = size;
+    block->freeRangeCount++;
+}
+
+static void removeFreeRange(HxfMemoryBlock* restrict block, uint32_t index) {
+    block->freeRangeCount--;
+    memmove(&block->freeRanges[index], &block->freeRanges[index + 1], sizeof(HxfMemoryRange) * (block->freeRangeCount - index));
+}
+
+static int allocateFromBlock(HxfMemoryBlock* restrict block, HxfAllocationStrategy strategy, const VkMemoryRequirements* restrict memoryRequirements, VkDeviceSize* restrict offset) {
+    VkDeviceSize memoryOffset;
+    VkDeviceSize objectSize;
+
+    if (strategy == HXF_ALLOCATION_STRATEGY_LINEAR) {
+        memoryOffset = block->linearOffset;
+        alignObject(memoryRequirements, &memoryOffset, offset, &objectSize);
+
+        if (memoryOffset > block->size) {
+            return 0;
+        }
+
+        block->linearOffset = memoryOffset;
+        return 1;
+    }
+
+    // Take the first free range that is large enough
+
+    for (uint32_t i = 0; i != block->freeRangeCount; i++) {
+        HxfMemoryRange* const range = &block->freeRanges[i];
+        const VkDeviceSize rangeEnd = range->offset + range->size;
+
+        memoryOffset = range->offset;
+        alignObject(memoryRequirements, &memoryOffset, offset, &objectSize);
+
+        if (memoryOffset > rangeEnd) {
+            continue;
+        }
+
+        // The padding before the object stays free, as well as the end of the range
+
+        if (*offset == range->offset) {
+            if (memoryOffset == rangeEnd) {
+                removeFreeRange(block, i);
+            }
+            else {
+                range->offset = memoryOffset;
+                range->size = rangeEnd - memoryOffset;
+            }
+        }
+        else {
+            range->size = *offset - range->offset;
+            if (memoryOffset != rangeEnd) {
+                insertFreeRange(block, i + 1, memoryOffset, rangeEnd - memoryOffset);
+            }
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static void freeRange(HxfMemoryBlock* restrict block, VkDeviceSize offset, VkDeviceSize size) {
+    // Find the first range after the freed one
+    uint32_t index = 0;
+    while (index != block->freeRangeCount && block->freeRanges[index].offset < offset) {
+        index++;
+    }
+
+    const int mergesPrevious = index != 0
+        && block->freeRanges[index - 1].offset + block->freeRanges[index - 1].size == offset;
+    const int mergesNext = index != block->freeRangeCount
+        && offset + size == block->freeRanges[index].offset;
+
+    if (mergesPrevious && mergesNext) {
+        block->freeRanges[index - 1].size += size + block->freeRanges[index].size;
+        removeFreeRange(block, index);
+    }
+    else if (mergesPrevious) {
+        block->freeRanges[index - 1].size += size;
+    }
+    else if (mergesNext) {
+        block->freeRanges[index].offset = offset;
+        block->freeRanges[index].size += size;
+    }
+    else {
+        insertFreeRange(block, index, offset, size);
+    }
+}
+
+static VkResult createBlock(HxfMemoryAllocator* restrict allocator, HxfMemoryPool* restrict pool, uint32_t memoryTypeIndex, VkDeviceSize size) {
+    const VkMemoryType* const memoryType = &allocator->memoryProperties.memoryTypes[memoryTypeIndex];
+    HxfMemoryBlock block = {
+        .size = size,
+        .data = NULL,
+        .allocationCount = 0,
+        .linearOffset = 0,
+        .freeRangeCount = 1,
+        .freeRangeCapacity = 4
+    };
+
+    VkMemoryAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryTypeIndex
+    };
+    VkResult result = vkAllocateMemory(allocator->device, &allocInfo, NULL, &block.memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    // The host visible blocks stay mapped, so their data is written without any call
+    if (memoryType->propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(allocator->device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.data);
+        if (result != VK_SUCCESS) {
+            vkFreeMemory(allocator->device, block.memory, NULL);
+            return result;
+        }
+    }
+
+    block.freeRanges = hxfMalloc(sizeof(HxfMemoryRange) * block.freeRangeCapacity, HXF_ALLOC_GRAPHICS);
+    block.freeRanges[0].offset = 0;
+    block.freeRanges[0].size = size;
+
+    pool->blocks = hxfRealloc(pool->blocks, sizeof(HxfMemoryBlock) * (pool->blockCount + 1), HXF_ALLOC_GRAPHICS);
+    pool->blocks[pool->blockCount] = block;
+    pool->blockCount++;
+
+    allocator->heapBlockBytes[memoryType->heapIndex] += size;
+
+    return VK_SUCCESS;
+}
+
+static void destroyBlock(HxfMemoryAllocator* restrict allocator, HxfMemoryPool* restrict pool, uint32_t memoryTypeIndex, uint32_t blockIndex) {
+    HxfMemoryBlock* const block = &pool->blocks[blockIndex];
+
+    if (block->data != NULL) {
+        vkUnmapMemory(allocator->device, block->memory);
+    }
+    vkFreeMemory(allocator->device, block->memory, NULL);
+    hxfFree(block->freeRanges);
+
+    allocator->heapBlockBytes[allocator->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] -= block->size;
+
+    pool->blockCount--;
+    memmove(&pool->blocks[blockIndex], &pool->blocks[blockIndex + 1], sizeof(HxfMemoryBlock) * (pool->blockCount - blockIndex));
+}
+
+static VkResult allocate(HxfMemoryAllocator* restrict allocator, const VkMemoryRequirements* restrict memoryRequirements, HxfMemoryUsage usage, HxfAllocationStrategy strategy, int isImage, HxfAllocation* restrict allocation) {
+    const uint32_t memoryTypeIndex = findMemoryType(allocator, memoryRequirements->memoryTypeBits, usage);
+    const uint32_t heapIndex = allocator->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    HxfMemoryPool* const pool = &allocator->pools[memoryTypeIndex][strategy][isImage];
+    VkResult result = VK_SUCCESS;
+
+    pthread_mutex_lock(&allocator->mutex);
+
+    // Try the existing blocks first
+
+    VkDeviceSize offset;
+    uint32_t blockIndex = 0;
+    while (blockIndex != pool->blockCount && !allocateFromBlock(&pool->blocks[blockIndex], strategy, memoryRequirements, &offset)) {
+        blockIndex++;
+    }
+
+    if (blockIndex == pool->blockCount) {
+        // A block of the default size would go over the budget, only allocate what is needed
+        const VkDeviceSize budget = allocator->memoryProperties.memoryHeaps[heapIndex].size / 10 * 8;
+        VkDeviceSize blockSize = memoryRequirements->size > HXF_MEMORY_BLOCK_SIZE
+            ? memoryRequirements->size
+            : HXF_MEMORY_BLOCK_SIZE;
+        if (allocator->heapBlockBytes[heapIndex] + blockSize > budget) {
+            blockSize = memoryRequirements->size;
+        }
+
+        result = createBlock(allocator, pool, memoryTypeIndex, blockSize);
+        if (result == VK_SUCCESS) {
+            allocateFromBlock(&pool->blocks[blockIndex], strategy, memoryRequirements, &offset);
+        }
+    }
+
+    if (result == VK_SUCCESS) {
+        HxfMemoryBlock* const block = &pool->blocks[blockIndex];
+        block->allocationCount++;
+        allocator->heapAllocationBytes[heapIndex] += memoryRequirements->size;
+
+        allocation->memory = block->memory;
+        allocation->offset = offset;
+        allocation->size = memoryRequirements->size;
+        allocation->data = block->data != NULL ? (char*)block->data + offset : NULL;
+        allocation->memoryTypeIndex = memoryTypeIndex;
+        allocation->strategy = strategy;
+        allocation->isImage = isImage;
+    }
+
+    pthread_mutex_unlock(&allocator->mutex);
+
+    return result;
+}
+
+void hxfMemoryAllocatorInit(HxfMemoryAllocator* restrict allocator, const VkPhysicalDeviceMemoryProperties* restrict memoryProperties, VkDevice device) {
+    memset(allocator, 0, sizeof(HxfMemoryAllocator));
+    allocator->device = device;
+    allocator->memoryProperties = *memoryProperties;
+
+    pthread_mutex_init(&allocator->mutex, NULL);
+}
+
+void hxfMemoryAllocatorDestroy(HxfMemoryAllocator* restrict allocator) {
+    for (uint32_t i = 0; i != VK_MAX_MEMORY_TYPES; i++) {
+        for (uint32_t j = 0; j != HXF_ALLOCATION_STRATEGY_COUNT; j++) {
+            for (uint32_t k = 0; k != 2; k++) {
+                HxfMemoryPool* const pool = &allocator->pools[i][j][k];
+
+                while (pool->blockCount != 0) {
+                    if (pool->blocks[0].allocationCount != 0) {
+                        HXF_MSG_ERROR("%u allocations of a memory block were not freed", pool->blocks[0].allocationCount);
+                    }
+                    destroyBlock(allocator, pool, i, 0);
+                }
+                if (pool->blocks != NULL) {
+                    hxfFree(pool->blocks);
+                }
+            }
+        }
+    }
+
+    pthread_mutex_destroy(&allocator->mutex);
+}
+
+VkResult hxfAllocateBufferMemory(HxfMemoryAllocator* restrict allocator, VkBuffer buffer, HxfMemoryUsage usage, HxfAllocationStrategy strategy, HxfAllocation* restrict allocation) {
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(allocator->device, buffer, &memoryRequirements);
+
+    VkResult result = allocate(allocator, &memoryRequirements, usage, strategy, 0, allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    return vkBindBufferMemory(allocator->device, buffer, allocation->memory, allocation->offset);
+}
+
+VkResult hxfAllocateImageMemory(HxfMemoryAllocator* restrict allocator, VkImage image, HxfMemoryUsage usage, HxfAllocationStrategy strategy, HxfAllocation* restrict allocation) {
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(allocator->device, image, &memoryRequirements);
+
+    VkResult result = allocate(allocator, &memoryRequirements, usage, strategy, 1, allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    return vkBindImageMemory(allocator->device, image, allocation->memory, allocation->offset);
+}
+
+void hxfFreeMemory(HxfMemoryAllocator* restrict allocator, const HxfAllocation* restrict allocation) {
+    HxfMemoryPool* const pool = &allocator->pools[allocation->memoryTypeIndex][allocation->strategy][allocation->isImage];
+
+    pthread_mutex_lock(&allocator->mutex);
+
+    uint32_t blockIndex = 0;
+    while (blockIndex != pool->blockCount && pool->blocks[blockIndex].memory != allocation->memory) {
+        blockIndex++;
+    }
+
+    if (blockIndex == pool->blockCount) {
+        HXF_FATAL("The freed allocation is not in the memory allocator");
+    }
+
+    HxfMemoryBlock* const block = &pool->blocks[blockIndex];
+    block->allocationCount--;
+    allocator->heapAllocationBytes[allocator->memoryProperties.memoryTypes[allocation->memoryTypeIndex].heapIndex] -= allocation->size;
+
+    if (allocation->strategy == HXF_ALLOCATION_STRATEGY_LINEAR) {
+        // The whole block is reused once it is empty
+        if (block->allocationCount == 0) {
+            block->linearOffset = 0;
+        }
+    }
+    else {
+        freeRange(block, allocation->offset, allocation->size);
+
+        // An empty block is kept if it is the last one of the pool, so that allocating and
+        // freeing a resource does not allocate and free a block each time
+        if (block->allocationCount == 0 && pool->blockCount != 1) {
+            destroyBlock(allocator, pool, allocation->memoryTypeIndex, blockIndex);
+        }
+    }
+
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+void hxfGetMemoryBudget(HxfMemoryAllocator* restrict allocator, HxfMemoryUsage usage, HxfMemoryBudget* restrict budget) {
+    const uint32_t memoryTypeIndex = findMemoryType(allocator, UINT32_MAX, usage);
+    const uint32_t heapIndex = allocator->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+    pthread_mutex_lock(&allocator->mutex);
+
+    budget->blockBytes = allocator->heapBlockBytes[heapIndex];
+    budget->allocationBytes = allocator->heapAllocationBytes[heapIndex];
+    budget->budget = allocator->memoryProperties.memoryHeaps[heapIndex].size / 10 * 8;
+
+    pthread_mutex_unlock(&allocator->mutex);
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief The size of the blocks of memory, a larger allocation gets a block of its own size.
+ */
+#define HXF_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+
+/**
+ * @brief How the memory is accessed, it selects the memory type.
+ */
+typedef enum HxfMemoryUsage {
+    HXF_MEMORY_USAGE_DEVICE, ///< Only accessed by the device, it is filled with transfers.
+    HXF_MEMORY_USAGE_UPLOAD, ///< Written by the host then copied to the device memory.
+    HXF_MEMORY_USAGE_DYNAMIC, ///< Written by the host and read by the device each frame.
+    HXF_MEMORY_USAGE_READBACK, ///< Written by the device then read by the host.
+    HXF_MEMORY_USAGE_COUNT
+} HxfMemoryUsage;
+
+/**
+ * @brief How the allocations are placed in the blocks of memory.
+ */
+typedef enum HxfAllocationStrategy {
+    HXF_ALLOCATION_STRATEGY_FREE_LIST, ///< The allocations can be freed in any order, the freed ranges are reused.
+    /**
+     * @brief Each allocation follows the previous one.
+     *
+     * The freed ranges are only reused once all the allocations of their block are freed, it
+     * suits the short lived allocations, for example the staging buffers of an upload.
+     */
+    HXF_ALLOCATION_STRATEGY_LINEAR,
+    HXF_ALLOCATION_STRATEGY_COUNT
+} HxfAllocationStrategy;
+
+/**
+ * @brief A range of a block of memory.
+ */
+typedef struct HxfMemoryRange {
+    VkDeviceSize offset; ///< The offset of the range in the block.
+    VkDeviceSize size; ///< The size of the range.
+} HxfMemoryRange;
+
+/**
+ * @brief A VkDeviceMemory that is shared by several allocations.
+ */
+typedef struct HxfMemoryBlock {
+    VkDeviceMemory memory; ///< The memory of the block.
+    VkDeviceSize size; ///< The size of the memory.
+    void* data; ///< The memory mapped for the whole life of the block, NULL if it is not host visible.
+    uint32_t allocationCount; ///< The number of allocations in the block.
+    VkDeviceSize linearOffset; ///< The end of the last allocation, with the linear strategy.
+    HxfMemoryRange* freeRanges; ///< The free ranges sorted by offset, with the free list strategy.
+    uint32_t freeRangeCount; ///< The number of elements of freeRanges.
+    uint32_t freeRangeCapacity; ///< The number of elements freeRanges can hold.
+} HxfMemoryBlock;
+
+/**
+ * @brief The blocks of a memory type that use the same strategy.
+ */
+typedef struct HxfMemoryPool {
+    HxfMemoryBlock* blocks; ///< The blocks of the pool.
+    uint32_t blockCount; ///< The number of elements of blocks.
+} HxfMemoryPool;
+
+/**
+ * @brief A range of memory given by the allocator.
+ */
+typedef struct HxfAllocation {
+    VkDeviceMemory memory; ///< The memory of the block the allocation is in.
+    VkDeviceSize offset; ///< The offset of the allocation in the memory.
+    VkDeviceSize size; ///< The size of the allocation.
+    void* data; ///< The mapped allocation, NULL if the memory is not host visible.
+    uint32_t memoryTypeIndex; ///< The memory type of the block.
+    HxfAllocationStrategy strategy; ///< The strategy of the block.
+    int isImage; ///< Set to 1 if the allocation holds an optimal tiling image.
+} HxfAllocation;
+
+/**
+ * @brief The memory used in a heap.
+ */
+typedef struct HxfMemoryBudget {
+    VkDeviceSize blockBytes; ///< The size of the blocks allocated from the heap.
+    VkDeviceSize allocationBytes; ///< The size of the allocations in these blocks.
+    /**
+     * @brief An estimation of how much memory the application can allocate from the heap.
+     *
+     * It is 80 % of the heap size, as the other applications and the driver also use the heap.
+     */
+    VkDeviceSize budget;
+} HxfMemoryBudget;
+
+/**
+ * @brief Sub-allocates the memory of the buffers and the images from large blocks.
+ *
+ * The buffers and the optimal tiling images are placed in different pools, so the
+ * bufferImageGranularity never has to be taken into account.
+ */
+typedef struct HxfMemoryAllocator {
+    VkDevice device; ///< The device the memory is allocated from.
+    VkPhysicalDeviceMemoryProperties memoryProperties; ///< The memory types and heaps of the physical device.
+    HxfMemoryPool pools[VK_MAX_MEMORY_TYPES][HXF_ALLOCATION_STRATEGY_COUNT][2]; ///< The pools of each memory type, strategy, then for the buffers and for the images.
+    VkDeviceSize heapBlockBytes[VK_MAX_MEMORY_HEAPS]; ///< The size of the blocks allocated from each heap.
+    VkDeviceSize heapAllocationBytes[VK_MAX_MEMORY_HEAPS]; ///< The size of the allocations made from each heap.
+    pthread_mutex_t mutex; ///< Protects the pools, so the memory can be allocated from any thread.
+} HxfMemoryAllocator;
+
+/**
+ * @brief Initialize a memory allocator.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param memoryProperties The memory properties of the physical device.
+ * @param device The device the memory is allocated from.
+ */
+void hxfMemoryAllocatorInit(HxfMemoryAllocator* restrict allocator, const VkPhysicalDeviceMemoryProperties* restrict memoryProperties, VkDevice device);
+
+/**
+ * @brief Free all the blocks of a memory allocator.
+ *
+ * All the allocations should be freed before.
+ */
+void hxfMemoryAllocatorDestroy(HxfMemoryAllocator* restrict allocator);
+
+/**
+ * @brief Allocate the memory of a buffer and bind it.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param buffer The buffer.
+ * @param usage How the memory is accessed.
+ * @param strategy How the allocation is placed.
+ * @param allocation A pointer to the HxfAllocation that receives the allocated range.
+ *
+ * @return VK_SUCCESS, or the error of the allocation of a new block.
+ */
+VkResult hxfAllocateBufferMemory(HxfMemoryAllocator* restrict allocator, VkBuffer buffer, HxfMemoryUsage usage, HxfAllocationStrategy strategy, HxfAllocation* restrict allocation);
+
+/**
+ * @brief Allocate the memory of an optimal tiling image and bind it.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param image The image.
+ * @param usage How the memory is accessed.
+ * @param strategy How the allocation is placed.
+ * @param allocation A pointer to the HxfAllocation that receives the allocated range.
+ *
+ * @return VK_SUCCESS, or the error of the allocation of a new block.
+ */
+VkResult hxfAllocateImageMemory(HxfMemoryAllocator* restrict allocator, VkImage image, HxfMemoryUsage usage, HxfAllocationStrategy strategy, HxfAllocation* restrict allocation);
+
+/**
+ * @brief Free an allocation.
+ *
+ * The device must not use the memory anymore, and the resource bound to it should be
+ * destroyed before.
+ */
+void hxfFreeMemory(HxfMemoryAllocator* restrict allocator, const HxfAllocation* restrict allocation);
+
+/**
+ * @brief Get the memory used in the heap of a memory usage.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param usage The memory usage, the heap is the one of its preferred memory type.
+ * @param budget A pointer to the HxfMemoryBudget that receives the used memory.
+ */
+void hxfGetMemoryBudget(HxfMemoryAllocator* restrict allocator, HxfMemoryUsage usage, HxfMemoryBudget* restrict budget);
+
+/**
+ * @brief Get the padding that aligns an offset.
+ *
+ * @param alignementRequirement The alignement the offset must have.
+ * @param offset The offset to align.
+ *
+ * @return The number of bytes to add to the offset.
+ */
+VkDeviceSize hxfGetAlignement(VkDeviceSize alignementRequirement, VkDeviceSize offset);
\ No newline at end of file
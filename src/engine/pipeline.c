@@ -1,5 +1,7 @@
 #include "pipeline.h"
 
+#include <string.h>
+
 /*
 STATIC FORWARD DECLARATION
 */
@@ -28,10 +30,77 @@ static void createRenderPass(HxfGraphicsHandler* restrict engine);
  */
 static void createDescriptors(HxfGraphicsHandler* restrict engine);
 
+/**
+ * @brief Create the compute pipeline that culls the pieces, with its descriptor.
+ *
+ * @param engine The HxfGraphicsHandler that will own it.
+ */
+static void createCullPipeline(HxfGraphicsHandler* restrict engine);
+
+/**
+ * @brief Create the compute pipeline that builds the depth pyramid, with its descriptors.
+ *
+ * @param engine The HxfGraphicsHandler that will own it.
+ */
+static void createDepthPyramidPipeline(HxfGraphicsHandler* restrict engine);
+
+/**
+ * @brief Get the path of a file of the appdata directory.
+ *
+ * @param engine The HxfGraphicsHandler that own the appdata directory path.
+ * @param scratch The arena the path is allocated in, the caller resets it.
+ * @param filename The name of the file, starting with a '/'.
+ *
+ * @return The path.
+ */
+static char* getAppdataPath(HxfGraphicsHandler* restrict engine, HxfArena* restrict scratch, const char* filename);
+
+/**
+ * @brief Check that pipeline cache data was created by the same driver and device.
+ *
+ * @param engine The HxfGraphicsHandler that own the physical device.
+ * @param data The pipeline cache data.
+ * @param size The size of the data.
+ *
+ * @return 1 if the data can be given to the pipeline cache, 0 otherwise.
+ */
+static int isPipelineCacheValid(HxfGraphicsHandler* restrict engine, const void* data, size_t size);
+
 /*
 IMPLEMENTATION
 */
 
+static char* getAppdataPath(HxfGraphicsHandler* restrict engine, HxfArena* restrict scratch, const char* filename) {
+    char* path = hxfArenaAlloc(scratch, sizeof(char) * (strlen(engine->appdataDirectory) + strlen(filename) + 1));
+    strcpy(path, engine->appdataDirectory);
+    strcat(path, filename);
+
+    return path;
+}
+
+static int isPipelineCacheValid(HxfGraphicsHandler* restrict engine, const void* data, size_t size) {
+    // The header is described by VkPipelineCacheHeaderVersionOne:
+    // header size, header version, vendor ID, device ID and pipeline cache UUID
+
+    const size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (size < headerSize) {
+        return 0;
+    }
+
+    uint32_t header[4];
+    memcpy(header, data, sizeof(header));
+    const uint8_t* uuid = (const uint8_t*)data + sizeof(header);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(engine->physicalDevice, &properties);
+
+    return header[0] >= headerSize && header[0] <= size
+        && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header[2] == properties.vendorID
+        && header[3] == properties.deviceID
+        && memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
 static VkShaderModule createShaderModule(HxfGraphicsHandler* restrict engine, const char* filename) {
     VkShaderModule shaderModule;
     void* code;
@@ -64,14 +133,21 @@ static void createRenderPass(HxfGraphicsHandler* restrict engine) {
             .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+#if defined(HXF_HEADLESS)
+            // Nothing is presented, the image can be copied to capture the frame
+            .finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+#else
             .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+#endif
         },
         {
             .format = engine->drawingData.depthImageFormat,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            // The depth pyramid is built from the depth once the render pass ended
+            .storeOp = engine->occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            // The depth prepass marks the pixels it covers in the stencil
+            .stencilLoadOp = engine->depthPrepass ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
             .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
@@ -103,6 +179,11 @@ static void createRenderPass(HxfGraphicsHandler* restrict engine) {
         .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
     };
 
+    // The depth image must not be cleared while the previous frame builds the depth pyramid from it
+    if (engine->occlusionCulling) {
+        dependency.srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+
     VkRenderPassCreateInfo renderPassInfo = {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
         .attachmentCount = sizeof(attachmentDescriptions) / sizeof(VkAttachmentDescription),
@@ -131,8 +212,15 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
             .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
             .descriptorCount = 1,
             .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT
+        },
+        { // cube instances, only with the vertex pulling
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT
         }
     };
+    const uint32_t cubeLayoutBindingCount = engine->vertexPulling ? 3 : 2;
     VkDescriptorSetLayoutBinding iconLayoutBindings[] = {
         {
             .binding = 0,
@@ -143,7 +231,7 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
     };
     VkDescriptorSetLayoutCreateInfo cubeLayoutInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = sizeof(cubeLayoutBindings) / sizeof(VkDescriptorSetLayoutBinding),
+        .bindingCount = cubeLayoutBindingCount,
         .pBindings = cubeLayoutBindings,
     };
     VkDescriptorSetLayoutCreateInfo iconLayoutInfo = {
@@ -164,6 +252,10 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
         { // texture sampler
             .descriptorCount = HXF_MAX_RENDERED_FRAMES,
             .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        },
+        { // cube instances
+            .descriptorCount = HXF_MAX_RENDERED_FRAMES,
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
         }
     };
     VkDescriptorPoolSize iconDescriptorPoolSizes[] = {
@@ -176,7 +268,7 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
     VkDescriptorPoolCreateInfo cubeDescriptorPoolInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .maxSets = HXF_MAX_RENDERED_FRAMES,
-        .poolSizeCount = sizeof(cubeDescriptorPoolSizes) / sizeof(VkDescriptorPoolSize),
+        .poolSizeCount = cubeLayoutBindingCount,
         .pPoolSizes = cubeDescriptorPoolSizes,
     };
     VkDescriptorPoolCreateInfo iconDescriptorPoolInfo = {
@@ -219,8 +311,8 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
     for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
         VkDescriptorBufferInfo uboBufferInfo = {
             .buffer = engine->drawingData.hostBuffer,
-            .offset = engine->drawingData.mvpOffset,
-            .range = engine->drawingData.mvpSize,
+            .offset = engine->drawingData.frameDataOffset + i * engine->drawingData.frameDataSize,
+            .range = sizeof(HxfMat4),
         };
         VkDescriptorImageInfo textureImageInfo = {
             .sampler = engine->drawingData.textureSampler,
@@ -259,16 +351,378 @@ static void createDescriptors(HxfGraphicsHandler* restrict engine) {
             }
         };
         vkUpdateDescriptorSets(engine->device, sizeof(cubeWriteDescriptorSets) / sizeof(VkWriteDescriptorSet), cubeWriteDescriptorSets, 0, NULL);
+
+        if (engine->vertexPulling) {
+            VkDescriptorBufferInfo instancesBufferInfo = {
+                .buffer = engine->drawingData.deviceBuffer,
+                .offset = engine->drawingData.cubeInstancesOffset,
+                .range = engine->drawingData.cubeInstancesSize,
+            };
+            VkWriteDescriptorSet instancesWriteDescriptorSet = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->cubeDescriptorSets[i],
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &instancesBufferInfo,
+            };
+            vkUpdateDescriptorSets(engine->device, 1, &instancesWriteDescriptorSet, 0, NULL);
+        }
+    }
+}
+
+static void createCullPipeline(HxfGraphicsHandler* restrict engine) {
+    // Descriptor set layout
+
+    VkDescriptorSetLayoutBinding layoutBindings[] = {
+        { // pieces
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        },
+        { // indirect draw commands
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        },
+        { // occlusion data
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        },
+        { // depth pyramid
+            .binding = 3,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        }
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = sizeof(layoutBindings) / sizeof(VkDescriptorSetLayoutBinding),
+        .pBindings = layoutBindings,
+    };
+    HXF_TRY_VK(vkCreateDescriptorSetLayout(engine->device, &layoutInfo, NULL, &engine->cullDescriptorSetLayout));
+
+    // Descriptor pool and sets
+    // A set for each frame as each frame has its own occlusion data
+
+    VkDescriptorPoolSize poolSizes[] = {
+        {
+            .descriptorCount = 3 * HXF_MAX_RENDERED_FRAMES,
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+        },
+        {
+            .descriptorCount = HXF_MAX_RENDERED_FRAMES,
+            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        }
+    };
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = HXF_MAX_RENDERED_FRAMES,
+        .poolSizeCount = sizeof(poolSizes) / sizeof(VkDescriptorPoolSize),
+        .pPoolSizes = poolSizes,
+    };
+    HXF_TRY_VK(vkCreateDescriptorPool(engine->device, &poolInfo, NULL, &engine->cullDescriptorPool));
+
+    VkDescriptorSetLayout setLayouts[HXF_MAX_RENDERED_FRAMES];
+    for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+        setLayouts[i] = engine->cullDescriptorSetLayout;
+    }
+
+    VkDescriptorSetAllocateInfo setInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = engine->cullDescriptorPool,
+        .descriptorSetCount = HXF_MAX_RENDERED_FRAMES,
+        .pSetLayouts = setLayouts,
+    };
+    HXF_TRY_VK(vkAllocateDescriptorSets(engine->device, &setInfo, engine->cullDescriptorSets));
+
+    VkDescriptorBufferInfo piecesBufferInfo = {
+        .buffer = engine->drawingData.deviceBuffer,
+        .offset = engine->drawingData.piecesOffset,
+        .range = engine->drawingData.piecesSize,
+    };
+    VkDescriptorBufferInfo drawCommandsBufferInfo = {
+        .buffer = engine->drawingData.deviceBuffer,
+        .offset = engine->drawingData.drawCommandsOffset,
+        .range = engine->drawingData.drawCommandsSize,
+    };
+
+    // Without the occlusion culling, the depth pyramid is never read but the descriptor must
+    // still be valid, so the texture is used instead (its view type does not matter as it is
+    // never accessed)
+    VkDescriptorImageInfo depthPyramidImageInfo = engine->occlusionCulling
+        ? (VkDescriptorImageInfo) {
+            .sampler = engine->drawingData.depthPyramidSampler,
+            .imageView = engine->drawingData.depthPyramidImageView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+        }
+        : (VkDescriptorImageInfo) {
+            .sampler = engine->drawingData.textureSampler,
+            .imageView = engine->drawingData.textureImageView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+
+    for (int i = 0; i != HXF_MAX_RENDERED_FRAMES; i++) {
+        VkDescriptorBufferInfo occlusionDataBufferInfo = {
+            .buffer = engine->drawingData.hostBuffer,
+            .offset = engine->drawingData.occlusionDataOffset + i * engine->drawingData.occlusionDataSize,
+            .range = sizeof(HxfOcclusionData),
+        };
+        VkWriteDescriptorSet writeDescriptorSets[] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->cullDescriptorSets[i],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &piecesBufferInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->cullDescriptorSets[i],
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &drawCommandsBufferInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->cullDescriptorSets[i],
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &occlusionDataBufferInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->cullDescriptorSets[i],
+                .dstBinding = 3,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &depthPyramidImageInfo,
+            }
+        };
+        vkUpdateDescriptorSets(engine->device, sizeof(writeDescriptorSets) / sizeof(VkWriteDescriptorSet), writeDescriptorSets, 0, NULL);
+    }
+
+    // Pipeline layout
+
+    VkPushConstantRange pushConstantRanges[] = {
+        {
+            .offset = 0,
+            .size = sizeof(HxfCullPushConstantData),
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        }
+    };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &engine->cullDescriptorSetLayout,
+        .pushConstantRangeCount = sizeof(pushConstantRanges) / sizeof(VkPushConstantRange),
+        .pPushConstantRanges = pushConstantRanges
+    };
+    HXF_TRY_VK(vkCreatePipelineLayout(engine->device, &pipelineLayoutInfo, NULL, &engine->cullPipelineLayout));
+
+    // Pipeline
+
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+
+    VkShaderModule cullComputeModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/computeCull.spv"));
+
+    hxfArenaReset(scratch, scratchMark);
+
+    VkComputePipelineCreateInfo pipelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = cullComputeModule,
+            .pName = "main",
+        },
+        .layout = engine->cullPipelineLayout,
+    };
+    HXF_TRY_VK(vkCreateComputePipelines(engine->device, engine->pipelineCache, 1, &pipelineInfo, NULL, &engine->cullPipeline));
+
+    vkDestroyShaderModule(engine->device, cullComputeModule, NULL);
+}
+
+static void createDepthPyramidPipeline(HxfGraphicsHandler* restrict engine) {
+    const HxfDrawingData* const drawingData = &engine->drawingData;
+
+    // Descriptor set layout
+
+    VkDescriptorSetLayoutBinding layoutBindings[] = {
+        { // the level that is read (the depth image for the first level)
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        },
+        { // the level that is written
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        }
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = sizeof(layoutBindings) / sizeof(VkDescriptorSetLayoutBinding),
+        .pBindings = layoutBindings,
+    };
+    HXF_TRY_VK(vkCreateDescriptorSetLayout(engine->device, &layoutInfo, NULL, &engine->depthPyramidDescriptorSetLayout));
+
+    // Descriptor pool and sets
+    // A set for each level, they are the same for every frame as the frames are built one after the other
+
+    VkDescriptorPoolSize poolSizes[] = {
+        {
+            .descriptorCount = drawingData->depthPyramidLevelCount,
+            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        },
+        {
+            .descriptorCount = drawingData->depthPyramidLevelCount,
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+        }
+    };
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = drawingData->depthPyramidLevelCount,
+        .poolSizeCount = sizeof(poolSizes) / sizeof(VkDescriptorPoolSize),
+        .pPoolSizes = poolSizes,
+    };
+    HXF_TRY_VK(vkCreateDescriptorPool(engine->device, &poolInfo, NULL, &engine->depthPyramidDescriptorPool));
+
+    VkDescriptorSetLayout setLayouts[HXF_DEPTH_PYRAMID_MAX_LEVEL_COUNT];
+    for (uint32_t i = 0; i != drawingData->depthPyramidLevelCount; i++) {
+        setLayouts[i] = engine->depthPyramidDescriptorSetLayout;
+    }
+
+    VkDescriptorSetAllocateInfo setInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = engine->depthPyramidDescriptorPool,
+        .descriptorSetCount = drawingData->depthPyramidLevelCount,
+        .pSetLayouts = setLayouts,
+    };
+    HXF_TRY_VK(vkAllocateDescriptorSets(engine->device, &setInfo, engine->depthPyramidDescriptorSets));
+
+    for (uint32_t i = 0; i != drawingData->depthPyramidLevelCount; i++) {
+        VkDescriptorImageInfo inputImageInfo = i == 0
+            ? (VkDescriptorImageInfo) {
+                .sampler = drawingData->depthPyramidSampler,
+                .imageView = drawingData->depthSampledImageView,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            }
+            : (VkDescriptorImageInfo) {
+                .sampler = drawingData->depthPyramidSampler,
+                .imageView = drawingData->depthPyramidLevelViews[i - 1],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+            };
+        VkDescriptorImageInfo outputImageInfo = {
+            .imageView = drawingData->depthPyramidLevelViews[i],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+        };
+        VkWriteDescriptorSet writeDescriptorSets[] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->depthPyramidDescriptorSets[i],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &inputImageInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = engine->depthPyramidDescriptorSets[i],
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &outputImageInfo,
+            }
+        };
+        vkUpdateDescriptorSets(engine->device, sizeof(writeDescriptorSets) / sizeof(VkWriteDescriptorSet), writeDescriptorSets, 0, NULL);
     }
+
+    // Pipeline layout
+
+    VkPushConstantRange pushConstantRanges[] = {
+        {
+            .offset = 0,
+            .size = sizeof(HxfDepthPyramidPushConstantData),
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+        }
+    };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &engine->depthPyramidDescriptorSetLayout,
+        .pushConstantRangeCount = sizeof(pushConstantRanges) / sizeof(VkPushConstantRange),
+        .pPushConstantRanges = pushConstantRanges
+    };
+    HXF_TRY_VK(vkCreatePipelineLayout(engine->device, &pipelineLayoutInfo, NULL, &engine->depthPyramidPipelineLayout));
+
+    // Pipeline
+
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+
+    VkShaderModule depthPyramidComputeModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/computeDepthPyramid.spv"));
+
+    hxfArenaReset(scratch, scratchMark);
+
+    VkComputePipelineCreateInfo pipelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = depthPyramidComputeModule,
+            .pName = "main",
+        },
+        .layout = engine->depthPyramidPipelineLayout,
+    };
+    HXF_TRY_VK(vkCreateComputePipelines(engine->device, engine->pipelineCache, 1, &pipelineInfo, NULL, &engine->depthPyramidPipeline));
+
+    vkDestroyShaderModule(engine->device, depthPyramidComputeModule, NULL);
 }
 
 void createPipelines(HxfGraphicsHandler* restrict engine) {
-    // Create the pipeline cache
+    const double startTime = hxfGetTime();
+
+    // Create the pipeline cache, with the data saved by the last launch if it was made by the
+    // same driver and device, a stale cache is ignored
+
+    // The paths are only needed until the shader modules are created
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+
+    void* cacheData = NULL;
+    size_t cacheSize = 0;
+    char* cachePath = getAppdataPath(engine, scratch, "/pipeline-cache.bin");
+
+    if (hxfReadFile(cachePath, &cacheData, &cacheSize) == HXF_SUCCESS && !isPipelineCacheValid(engine, cacheData, cacheSize)) {
+        HXF_MSG_ERROR("The pipeline cache was made by another driver or device, it is ignored");
+        hxfFree(cacheData);
+        cacheData = NULL;
+        cacheSize = 0;
+    }
 
     VkPipelineCacheCreateInfo pipelineCacheInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-        .initialDataSize = 0,
-        .pInitialData = NULL,
+        .initialDataSize = cacheSize,
+        .pInitialData = cacheData,
     };
     HXF_TRY_VK(vkCreatePipelineCache(engine->device, &pipelineCacheInfo, NULL, &engine->pipelineCache));
 
@@ -277,47 +731,12 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
 
     // Shader modules creation
 
-    const char cubeVertex[] = "/shaders/vertexCube.spv";
-    const char iconVertex[] = "/shaders/vertexIcon.spv";
-    const char pointerVertex[] = "/shaders/vertexPointer.spv";
-    const char cubeFragment[] = "/shaders/fragmentCube.spv";
-    const char iconFragment[] = "/shaders/fragmentIcon.spv";
-    const char pointerFragment[] = "/shaders/fragmentPointer.spv";
-
-    char* cubeVertexPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(cubeVertex)));
-    char* iconVertexPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(iconVertex)));
-    char* pointerVertexPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(pointerVertex)));
-    char* cubeFragmentPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(cubeFragment)));
-    char* iconFragmentPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(iconFragment)));
-    char* pointerFragmentPath = hxfMalloc(sizeof(char) * (strlen(engine->appdataDirectory) + sizeof(pointerFragment)));
-
-    strcpy(cubeVertexPath, engine->appdataDirectory);
-    strcpy(iconVertexPath, engine->appdataDirectory);
-    strcpy(pointerVertexPath, engine->appdataDirectory);
-    strcpy(cubeFragmentPath, engine->appdataDirectory);
-    strcpy(iconFragmentPath, engine->appdataDirectory);
-    strcpy(pointerFragmentPath, engine->appdataDirectory);
-
-    strcat(cubeVertexPath, cubeVertex);
-    strcat(iconVertexPath, iconVertex);
-    strcat(pointerVertexPath, pointerVertex);
-    strcat(cubeFragmentPath, cubeFragment);
-    strcat(iconFragmentPath, iconFragment);
-    strcat(pointerFragmentPath, pointerFragment);
-
-    VkShaderModule cubeVertexModule = createShaderModule(engine, cubeVertexPath);
-    VkShaderModule iconVertexModule = createShaderModule(engine, iconVertexPath);
-    VkShaderModule pointerVertexModule = createShaderModule(engine, pointerVertexPath);
-    VkShaderModule cubeFragmentModule = createShaderModule(engine, cubeFragmentPath);
-    VkShaderModule iconFragmentModule = createShaderModule(engine, iconFragmentPath);
-    VkShaderModule pointerFragmentModule = createShaderModule(engine, pointerFragmentPath);
-
-    hxfFree(cubeVertexPath);
-    hxfFree(iconVertexPath);
-    hxfFree(pointerVertexPath);
-    hxfFree(cubeFragmentPath);
-    hxfFree(iconFragmentPath);
-    hxfFree(pointerFragmentPath);
+    VkShaderModule cubeVertexModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/vertexCube.spv"));
+    VkShaderModule iconVertexModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/vertexIcon.spv"));
+    VkShaderModule pointerVertexModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/vertexPointer.spv"));
+    VkShaderModule cubeFragmentModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/fragmentCube.spv"));
+    VkShaderModule iconFragmentModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/fragmentIcon.spv"));
+    VkShaderModule pointerFragmentModule = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/fragmentPointer.spv"));
 
     VkPipelineShaderStageCreateInfo cubeStages[] = {
         {
@@ -387,6 +806,12 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
             .format = VK_FORMAT_R32G32_SFLOAT,
             .offset = offsetof(HxfCubeVertexData, texelCoordinate),
         },
+        { // Texture column
+            .binding = 0,
+            .location = 4,
+            .format = VK_FORMAT_R32_UINT,
+            .offset = offsetof(HxfCubeVertexData, textureColumn),
+        },
         { // Cube position
             .binding = 1,
             .location = 1,
@@ -396,8 +821,14 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
         { // Texture index
             .binding = 1,
             .location = 3,
-            .format = VK_FORMAT_R32_UINT,
+            .format = VK_FORMAT_R16_UINT,
             .offset = offsetof(HxfCubeInstanceData, textureIndex)
+        },
+        { // Cube size
+            .binding = 1,
+            .location = 5,
+            .format = VK_FORMAT_R16_UINT,
+            .offset = offsetof(HxfCubeInstanceData, size)
         }
     };
     VkVertexInputBindingDescription iconBindingDescriptions[] = {
@@ -512,6 +943,52 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
         .depthCompareOp = VK_COMPARE_OP_LESS,
     };
 
+    // The depth prepass sets the stencil to 1 where a cube passes the depth test. The pixels
+    // where no cube is nearer than the cleared depth stay at 0, as they are not drawn without
+    // the prepass.
+    VkPipelineDepthStencilStateCreateInfo prepassDepthStencilInfo = depthStencilInfo;
+    prepassDepthStencilInfo.stencilTestEnable = VK_TRUE;
+    prepassDepthStencilInfo.front = (VkStencilOpState) {
+        .failOp = VK_STENCIL_OP_KEEP,
+        .passOp = VK_STENCIL_OP_REPLACE,
+        .depthFailOp = VK_STENCIL_OP_KEEP,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .compareMask = 0xff,
+        .writeMask = 0xff,
+        .reference = 1
+    };
+    prepassDepthStencilInfo.back = prepassDepthStencilInfo.front;
+
+    // With the depth prepass, the depth of the cubes is already written, so only the nearest
+    // fragments, with an equal depth, are shaded. Several fragments can have that depth, the
+    // stencil then goes from 1 to 2 with the first one, which is the one the depth test keeps
+    // without the prepass.
+    VkPipelineDepthStencilStateCreateInfo cubeDepthStencilInfo = depthStencilInfo;
+    if (engine->depthPrepass) {
+        cubeDepthStencilInfo.depthWriteEnable = VK_FALSE;
+        cubeDepthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        cubeDepthStencilInfo.stencilTestEnable = VK_TRUE;
+        cubeDepthStencilInfo.front = (VkStencilOpState) {
+            .failOp = VK_STENCIL_OP_KEEP,
+            .passOp = VK_STENCIL_OP_INCREMENT_AND_CLAMP,
+            .depthFailOp = VK_STENCIL_OP_KEEP,
+            .compareOp = VK_COMPARE_OP_EQUAL,
+            .compareMask = 0xff,
+            .writeMask = 0xff,
+            .reference = 1
+        };
+        cubeDepthStencilInfo.back = cubeDepthStencilInfo.front;
+    }
+
+    // The icon and the pointer are drawn over everything, they must not hide the cubes behind
+    // them to the occlusion culling
+    VkPipelineDepthStencilStateCreateInfo overlayDepthStencilInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = VK_FALSE,
+        .depthCompareOp = VK_COMPARE_OP_LESS,
+    };
+
     VkPipelineColorBlendAttachmentState colorBlendAttachments[] = {
         {
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
@@ -584,7 +1061,7 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
             .pViewportState = &viewportInfo,
             .pRasterizationState = &rasterizationInfo,
             .pMultisampleState = &multisampleInfo,
-            .pDepthStencilState = &depthStencilInfo,
+            .pDepthStencilState = &cubeDepthStencilInfo,
             .pColorBlendState = &colorBlendInfo,
             .layout = engine->cubePipelineLayout,
             .renderPass = engine->renderPass,
@@ -597,7 +1074,7 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
             .pInputAssemblyState = &triangleListInputAssemblyInfo,
             .pViewportState = &viewportInfo,
             .pRasterizationState = &rasterizationInfo,
-            .pDepthStencilState = &depthStencilInfo,
+            .pDepthStencilState = &overlayDepthStencilInfo,
             .pMultisampleState = &multisampleInfo,
             .pColorBlendState = &colorBlendInfo,
             .layout = engine->iconPipelineLayout,
@@ -612,7 +1089,7 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
             .pInputAssemblyState = &triangleFanInputAssemblyInfo,
             .pViewportState = &viewportInfo,
             .pRasterizationState = &rasterizationInfo,
-            .pDepthStencilState = &depthStencilInfo,
+            .pDepthStencilState = &overlayDepthStencilInfo,
             .pMultisampleState = &multisampleInfo,
             .pColorBlendState = &colorBlendInfo,
             .layout = engine->pointerPipelineLayout,
@@ -623,10 +1100,91 @@ void createPipelines(HxfGraphicsHandler* restrict engine) {
 
     HXF_TRY_VK(vkCreateGraphicsPipelines(engine->device, engine->pipelineCache, sizeof(pipelineInfos) / sizeof(VkGraphicsPipelineCreateInfo), pipelineInfos, NULL, &engine->cubePipeline));
 
+    // The pipeline the cubes are drawn with, and the depth prepass is based on
+    VkGraphicsPipelineCreateInfo cubePipelineInfo = pipelineInfos[0];
+    VkPipelineShaderStageCreateInfo pulledCubeStages[] = {
+        cubeStages[0],
+        cubeStages[1]
+    };
+
+    if (engine->vertexPulling) {
+        pulledCubeStages[0].module = createShaderModule(engine, getAppdataPath(engine, scratch, "/shaders/vertexCubePulling.spv"));
+
+        // No vertex input, the vertex shader reads the faces from the storage buffer
+        cubePipelineInfo.pStages = pulledCubeStages;
+        cubePipelineInfo.pVertexInputState = &pointerInputInfo;
+
+        HXF_TRY_VK(vkCreateGraphicsPipelines(engine->device, engine->pipelineCache, 1, &cubePipelineInfo, NULL, &engine->cubePullingPipeline));
+    }
+
+    hxfArenaReset(scratch, scratchMark);
+
+    if (engine->depthPrepass) {
+        // The same vertices as the cube pipeline, but only the depth is written
+        VkPipelineColorBlendAttachmentState prepassColorBlendAttachments[] = {
+            {
+                .colorWriteMask = 0,
+            }
+        };
+        VkPipelineColorBlendStateCreateInfo prepassColorBlendInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .attachmentCount = sizeof(prepassColorBlendAttachments) / sizeof(VkPipelineColorBlendAttachmentState),
+            .pAttachments = prepassColorBlendAttachments,
+        };
+
+        VkGraphicsPipelineCreateInfo prepassPipelineInfo = cubePipelineInfo;
+        prepassPipelineInfo.stageCount = 1; // Only the vertex shader
+        prepassPipelineInfo.pDepthStencilState = &prepassDepthStencilInfo;
+        prepassPipelineInfo.pColorBlendState = &prepassColorBlendInfo;
+
+        HXF_TRY_VK(vkCreateGraphicsPipelines(engine->device, engine->pipelineCache, 1, &prepassPipelineInfo, NULL, &engine->depthPrepassPipeline));
+    }
+
     vkDestroyShaderModule(engine->device, cubeFragmentModule, NULL);
     vkDestroyShaderModule(engine->device, iconFragmentModule, NULL);
     vkDestroyShaderModule(engine->device, pointerFragmentModule, NULL);
     vkDestroyShaderModule(engine->device, cubeVertexModule, NULL);
     vkDestroyShaderModule(engine->device, iconVertexModule, NULL);
     vkDestroyShaderModule(engine->device, pointerVertexModule, NULL);
+    if (engine->vertexPulling) {
+        vkDestroyShaderModule(engine->device, pulledCubeStages[0].module, NULL);
+    }
+
+    if (engine->gpuCulling) {
+        createCullPipeline(engine);
+    }
+    if (engine->occlusionCulling) {
+        createDepthPyramidPipeline(engine);
+    }
+
+    if (engine->printPipelineTime) {
+        printf("Pipelines created in %.3f ms with a %s pipeline cache\n", (hxfGetTime() - startTime) * 1000.0, cacheData != NULL ? "warm" : "cold");
+    }
+    if (cacheData != NULL) {
+        hxfFree(cacheData);
+    }
+}
+
+void savePipelineCache(HxfGraphicsHandler* restrict engine) {
+    size_t size;
+    HXF_TRY_VK(vkGetPipelineCacheData(engine->device, engine->pipelineCache, &size, NULL));
+
+    void* data = hxfMalloc(size, HXF_ALLOC_IO);
+    HXF_TRY_VK(vkGetPipelineCacheData(engine->device, engine->pipelineCache, &size, data));
+
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+
+    char* path = getAppdataPath(engine, scratch, "/pipeline-cache.bin");
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL || fwrite(data, size, 1, file) != 1) {
+        HXF_MSG_ERROR("Could not save the pipeline cache");
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    hxfArenaReset(scratch, scratchMark);
+    hxfFree(data);
 }
\ No newline at end of file
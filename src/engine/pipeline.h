@@ -5,6 +5,14 @@
 /**
  * @brief Create the graphics pipelines.
  *
- * It includes the render pass.
+ * It includes the render pass, the cull compute pipeline if the GPU culling is enabled, and the
+ * depth pyramid compute pipeline if the occlusion culling is enabled.
  */
-void createPipelines(HxfGraphicsHandler* restrict engine);
\ No newline at end of file
+void createPipelines(HxfGraphicsHandler* restrict engine);
+
+/**
+ * @brief Write the pipeline cache data to the appdata directory, to be loaded by the next createPipelines.
+ *
+ * A failure is not fatal, the pipelines are then compiled again at the next launch.
+ */
+void savePipelineCache(HxfGraphicsHandler* restrict engine);
\ No newline at end of file
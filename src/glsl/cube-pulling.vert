@@ -0,0 +1,67 @@
+#version 450
+
+// Number of faces textures in each row of textures.png, must be equal to HXF_TEXTURE_FACE_COUNT
+#define TEXTURE_FACE_COUNT 6
+
+// Must be equal to HXF_CUBE_INSTANCE_COUNT, the faces of each direction start at direction * CUBE_INSTANCE_COUNT
+#define CUBE_INSTANCE_COUNT (16 * 16 * 16 * 16 * 16 * 1)
+
+// Same layout as HxfCubeInstanceData
+struct Face {
+    vec3 position;             // Minimum corner of the cube
+    uint textureIndexAndSize;  // The texture index in the 16 low bits, the width of the cube in the 16 high bits
+};
+
+// The data of the frame
+layout(binding = 0) uniform UBO {
+    mat4 viewProjection; // The product of the model, view and projection matrices
+} ubo;
+
+// The faces of all the directions, 6 vertices are drawn for each face
+layout(std430, binding = 2) readonly buffer Faces {
+    Face faces[];
+};
+
+// the texel coordinate and the layer of the texture array that will be used by the fragment shader
+layout(location = 0) out vec3 outTexelCoordinates;
+
+// The depth prepass and the cube pipeline must compute exactly the same depth
+invariant gl_Position;
+
+// The corners of the faces of each direction, same as the cubesVertices
+const vec3 CORNER_POSITIONS[24] = vec3[](
+    vec3(0.0, 1.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 1.0, 1.0), // Top
+    vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0, 1.0, 0.0), // Back
+    vec3(0.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0), // Bottom
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0), vec3(1.0, 1.0, 1.0), vec3(1.0, 0.0, 1.0), // Front
+    vec3(1.0, 0.0, 1.0), vec3(1.0, 1.0, 1.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), // Right
+    vec3(0.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 1.0, 1.0), vec3(0.0, 0.0, 1.0)  // Left
+);
+const vec2 CORNER_TEXEL_COORDINATES[24] = vec2[](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), // Top
+    vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0), // Back
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), // Bottom
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), // Front
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), // Right
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0)  // Left
+);
+// The column of the face texture of each direction in textures.png
+const uint TEXTURE_COLUMNS[6] = uint[](4, 2, 5, 0, 1, 3);
+// The corners of the two triangles of a face, same as the cubesVertexIndices
+const uint TRIANGLE_CORNERS[6] = uint[](0, 1, 2, 2, 3, 0);
+
+// Main
+
+void main() {
+    const uint faceIndex = gl_VertexIndex / 6;
+    const uint direction = faceIndex / CUBE_INSTANCE_COUNT;
+    const uint corner = direction * 4 + TRIANGLE_CORNERS[gl_VertexIndex % 6];
+
+    const Face face = faces[faceIndex];
+    const uint textureIndex = face.textureIndexAndSize & 0xFFFF;
+    const float size = float(face.textureIndexAndSize >> 16);
+
+    gl_Position = ubo.viewProjection * vec4(CORNER_POSITIONS[corner] * size + face.position, 1.0);
+
+    outTexelCoordinates = vec3(CORNER_TEXEL_COORDINATES[corner], float(textureIndex * TEXTURE_FACE_COUNT + TEXTURE_COLUMNS[direction]));
+}
\ No newline at end of file
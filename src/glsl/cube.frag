@@ -1,10 +1,10 @@
 #version 450
 
-// Coordinate for the texture
-layout(location = 0) in vec2 inTexelCoordinates;
+// Coordinate and layer for the texture
+layout(location = 0) in vec3 inTexelCoordinates;
 
-// The textures
-layout(binding = 1) uniform sampler2D texelSampler;
+// The textures, one layer for each face texture
+layout(binding = 1) uniform sampler2DArray texelSampler;
 
 // The color that is rendered
 layout(location = 0) out vec4 outColor;
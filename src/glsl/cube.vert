@@ -1,36 +1,39 @@
 #version 450
 
-// Width of textures.png
-#define TEXTURE_WIDTH 96.0
-// Height of texture.png
-#define TEXTURE_HEIGHT 80.0
+// Number of faces textures in each row of textures.png, must be equal to HXF_TEXTURE_FACE_COUNT
+#define TEXTURE_FACE_COUNT 6
 
 // Position of the vertex
 layout(location = 0) in vec3 inPosition;
 // Offset that is added to the position of the vertex
 layout(location = 1) in vec3 inOffset;
-// texel coordinates for the texture
+// texel coordinates inside the face texture
 layout(location = 2) in vec2 inTexelCoordinates;
 // the texture index
 layout(location = 3) in uint textureIndex;
+// the column of the face texture in textures.png
+layout(location = 4) in uint textureColumn;
+// The width of the cube, larger than 1 for the levels of detail
+layout(location = 5) in uint size;
 
-// The model-view-projection matrices
+// The data of the frame
 layout(binding = 0) uniform UBO {
-    mat4 model;      // Model
-    mat4 view;       // View
-    mat4 projection; // Projection
+    mat4 viewProjection; // The product of the model, view and projection matrices
 } ubo;
 
-// the texel coordinate for the texture that will be used by the fragment shader
-layout(location = 0) out vec2 outTexelCoordinates;
+// the texel coordinate and the layer of the texture array that will be used by the fragment shader
+layout(location = 0) out vec3 outTexelCoordinates;
+
+// The depth prepass and the cube pipeline must compute exactly the same depth
+invariant gl_Position;
 
 // Main
 
 void main() {
     // The vertex position is:
-    // The position + the offset that is then transformed by the MVP matrices to be in clip space
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition + inOffset, 1.0);
+    // The position scaled by the cube size + the offset that is then transformed by the view-projection matrix to be in clip space
+    gl_Position = ubo.viewProjection * vec4(inPosition * float(size) + inOffset, 1.0);
 
-    // Set the texel coordinate that correspond to the texture (via texture index)
-    outTexelCoordinates = vec2(inTexelCoordinates.x, inTexelCoordinates.y + textureIndex * 16.0 / TEXTURE_HEIGHT);
+    // Set the texel coordinate in the layer that correspond to the face of the texture (via texture index)
+    outTexelCoordinates = vec3(inTexelCoordinates, float(textureIndex * TEXTURE_FACE_COUNT + textureColumn));
 }
\ No newline at end of file
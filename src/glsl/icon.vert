@@ -1,9 +1,7 @@
 #version 450
 
-// Width of textures.png
-#define TEXTURE_WIDTH 96.0
-// Height of texture.png
-#define TEXTURE_HEIGHT 80.0
+// Number of faces textures in each row of textures.png, must be equal to HXF_TEXTURE_FACE_COUNT
+#define TEXTURE_FACE_COUNT 6
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inTexelCoordinates;
@@ -14,7 +12,7 @@ layout(push_constant) uniform Push {
     uint windowHeight;
 } push;
 
-layout(location = 0) out vec2 outTexelCoordinates;
+layout(location = 0) out vec3 outTexelCoordinates;
 
 void main() {
     const vec2 pos = vec2(
@@ -23,5 +21,6 @@ void main() {
     );
     gl_Position = vec4(pos, 0.0, 1.0);
 
-    outTexelCoordinates = vec2(inTexelCoordinates.x, inTexelCoordinates.y + inTextureIndex * 16.0 / TEXTURE_HEIGHT);
+    // The icon shows the front face, the first column
+    outTexelCoordinates = vec3(inTexelCoordinates, float(inTextureIndex * TEXTURE_FACE_COUNT));
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "window.h"
+#include "../profiler.h"
+
+HxfResult hxfCreateMainWindow(const HxfWindowParam* restrict param, HxfWindow* window) {
+    window->width = param->width;
+    window->height = param->height;
+    window->shouldDestroyed = 0;
+    window->isFocused = 1;
+
+    return HXF_SUCCESS;
+}
+
+HxfResult hxfDestroyMainWindow(HxfWindow* restrict window) {
+    return HXF_SUCCESS;
+}
+
+void hxfReadWindowMessages(HxfWindow* restrict window) {
+    HXF_ZONE("window.readMessages");
+
+    // There is no input
+}
+
+void hxfCreateWindowSurface(HxfWindow* restrict window, VkInstance instance, VkSurfaceKHR* restrict surface) {
+    // Nothing is presented, the graphics handler renders to offscreen images instead
+    *surface = VK_NULL_HANDLE;
+}
+
+void hxfGetRequiredWindowExtensions(char*** extensions, int* count) {
+    // Allocated anyway, as the caller may add its own extensions and frees the array
+    *extensions = hxfMalloc(sizeof(char*), HXF_ALLOC_GRAPHICS);
+
+    *count = 0;
+}
+
+void hxfSetKeyDownCallback(HxfWindow* window, HxfKeyCode scancode, void (*function)(void*), void* param) {
+    window->keyDownCallback[scancode] = function;
+    window->keyDownCallbackParameter[scancode] = param;
+}
+
+void hxfSetKeyUpCallback(HxfWindow* window, HxfKeyCode scancode, void (*function)(void*), void* param) {
+    window->keyUpCallback[scancode] = function;
+    window->keyUpCallbackParameter[scancode] = param;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "../hxf.h"
+#include "../window.h"
+
+struct HxfWindowParam {
+    int width;
+    int height;
+};
+
+/**
+ * @brief A window that is never displayed, the frames are rendered to offscreen images.
+ *
+ * It has no input, so the callbacks are never called.
+ */
+struct HxfWindow {
+    int width;
+    int height;
+    /**
+     * @brief An array of callback function that are called when a key is pressed.
+     *
+     * The index corresponds to the scancode.
+     */
+    void (*keyDownCallback[HXF_WINDOW_KEY_CALLBACK_COUNT])(void*);
+    void* keyDownCallbackParameter[HXF_WINDOW_KEY_CALLBACK_COUNT];
+    /**
+     * @brief An array of callback function that are called when a key is released.
+     *
+     * The index corresponds to the scancode.
+     */
+    void (*keyUpCallback[HXF_WINDOW_KEY_CALLBACK_COUNT])(void*);
+    void* keyUpCallbackParameter[HXF_WINDOW_KEY_CALLBACK_COUNT];
+
+    int shouldDestroyed; ///< Indicates that the window should be destroyed
+    int isFocused; ///< Always 1, so the frame rate is never lowered
+};
\ No newline at end of file
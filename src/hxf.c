@@ -1,45 +1,175 @@
 #include "hxf.h"
 #include <string.h>
+#include <stddef.h>
+
+#ifdef HXF_WIN32
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#endif
 
-// Used to find some errors with the allocations.
-// For example, to verify hxfFree was called each time it was needed, you can verify at the end
-// of the program (end of main.c) that allocCount is equal to 0. If that is not the case you can
-// look at every HxfAlloc::ptr of allocsInfo and verify if they are equals to 0.
-//
-// You can also look how much memory is currently allocated each time hxfFree, hxfMalloc,
-// hxfRealloc is called.
 #if defined(HXF_DEBUG_ALLOC)
-typedef struct HxfAlloc {
+#include <pthread.h>
+#include <stdint.h>
+
+// Tracks the allocations to find the leaks and to know how much memory each part of the game
+// uses. The live allocations are in a hash table indexed by their pointer, so each call stays in
+// constant time, and nothing is printed until hxfReportAllocations is called.
+
+/**
+ * @brief A live allocation, or an empty slot of the table if ptr is NULL.
+ */
+typedef struct TrackedAllocation {
     void* ptr;
     size_t size;
-} HxfAlloc;
+    HxfAllocTag tag;
+} TrackedAllocation;
 
 /**
- * @brief Number of byte allocated at a given time
+ * @brief The initial number of slots of the table, it must be a power of 2.
  */
-static size_t byteAllocated = 0;
+#define ALLOCATION_TABLE_INITIAL_CAPACITY 4096
 
 /**
- * @brief Index of the next HxfAlloc of allocsInfo that will be set.
+ * @brief The live allocations, with open addressing and linear probing.
  *
- * For now, it is never decremented and so the HxfAlloc that is freed will never be
- * redefined at a later time.
- * TODO fix this.
+ * It is allocated with malloc so that it does not track itself, and doubles when it is more than
+ * half full.
+ */
+static TrackedAllocation* allocationTable = NULL;
+static size_t allocationTableCapacity = 0; ///< The number of slots of the table.
+static size_t allocationTableCount = 0; ///< The number of live allocations in the table.
+
+static HxfAllocStats allocStats[HXF_ALLOC_TAG_COUNT]; ///< The counters of each tag.
+
+/**
+ * @brief Protects the table and the counters, as the startup allocates from several threads.
+ */
+static pthread_mutex_t allocMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const allocTagNames[HXF_ALLOC_TAG_COUNT] = {
+    "world",
+    "mesh",
+    "graphics",
+    "io",
+    "other"
+};
+
+/**
+ * @brief Get the first slot where a pointer can be in the table.
  */
-static size_t allocIndex = 0;
+static size_t getAllocationSlot(const void* ptr);
 
 /**
- * @brief The number of allocation made at a given time.
+ * @brief Add an allocation to the table and to the counters of its tag.
+ *
+ * The mutex must be locked.
  */
-static size_t allocCount = 0;
+static void trackAllocation(void* ptr, size_t size, HxfAllocTag tag);
 
 /**
- * @brief Information on each allocation made.
+ * @brief Remove an allocation from the table and from the counters of its tag.
+ *
+ * The mutex must be locked.
+ *
+ * @return 0 if the pointer is not in the table, 1 otherwise.
  */
-static HxfAlloc allocsInfo[1024] = { 0 };
+static int untrackAllocation(void* ptr);
+
+static size_t getAllocationSlot(const void* ptr) {
+    // The low bits are always 0 because of the alignment, the multiplication mixes the others
+    const uint64_t hash = ((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ull;
+
+    return (size_t)(hash >> 32) & (allocationTableCapacity - 1);
+}
+
+static void trackAllocation(void* ptr, size_t size, HxfAllocTag tag) {
+    if (2 * (allocationTableCount + 1) > allocationTableCapacity) {
+        // Insert all the live allocations again in a larger table
+        TrackedAllocation* const oldTable = allocationTable;
+        const size_t oldCapacity = allocationTableCapacity;
+
+        allocationTableCapacity = oldCapacity == 0 ? ALLOCATION_TABLE_INITIAL_CAPACITY : 2 * oldCapacity;
+        allocationTable = calloc(allocationTableCapacity, sizeof(TrackedAllocation));
+        if (allocationTable == NULL) {
+            HXF_FATAL("Could not allocate the allocation table");
+        }
+
+        for (size_t i = 0; i != oldCapacity; i++) {
+            if (oldTable[i].ptr != NULL) {
+                size_t slot = getAllocationSlot(oldTable[i].ptr);
+                while (allocationTable[slot].ptr != NULL) {
+                    slot = (slot + 1) & (allocationTableCapacity - 1);
+                }
+                allocationTable[slot] = oldTable[i];
+            }
+        }
+        free(oldTable);
+    }
+
+    size_t slot = getAllocationSlot(ptr);
+    while (allocationTable[slot].ptr != NULL) {
+        slot = (slot + 1) & (allocationTableCapacity - 1);
+    }
+    allocationTable[slot].ptr = ptr;
+    allocationTable[slot].size = size;
+    allocationTable[slot].tag = tag;
+    allocationTableCount++;
+
+    HxfAllocStats* const stats = &allocStats[tag];
+    stats->currentBytes += size;
+    stats->currentCount++;
+    stats->totalCount++;
+    if (stats->currentBytes > stats->peakBytes) {
+        stats->peakBytes = stats->currentBytes;
+    }
+}
+
+static int untrackAllocation(void* ptr) {
+    if (allocationTableCapacity == 0) {
+        return 0;
+    }
+
+    size_t slot = getAllocationSlot(ptr);
+    while (allocationTable[slot].ptr != ptr) {
+        if (allocationTable[slot].ptr == NULL) {
+            return 0;
+        }
+        slot = (slot + 1) & (allocationTableCapacity - 1);
+    }
+
+    HxfAllocStats* const stats = &allocStats[allocationTable[slot].tag];
+    stats->currentBytes -= allocationTable[slot].size;
+    stats->currentCount--;
+    allocationTableCount--;
+
+    // Move back the next allocations of the probe sequence into the hole, so that the lookups
+    // never stop before finding them
+    size_t hole = slot;
+    size_t next = (hole + 1) & (allocationTableCapacity - 1);
+    while (allocationTable[next].ptr != NULL) {
+        const size_t nextSlot = getAllocationSlot(allocationTable[next].ptr);
+
+        // It can move if its first slot is not between the hole (excluded) and itself (included)
+        const int canMove = hole <= next
+            ? nextSlot <= hole || nextSlot > next
+            : nextSlot <= hole && nextSlot > next;
+        if (canMove) {
+            allocationTable[hole] = allocationTable[next];
+            hole = next;
+        }
+        next = (next + 1) & (allocationTableCapacity - 1);
+    }
+    allocationTable[hole].ptr = NULL;
+
+    return 1;
+}
 #endif
 
-void* hxfMalloc(size_t size) {
+void* hxfMalloc(size_t size, HxfAllocTag tag) {
     void* data = malloc(size);
 
     if (data == NULL) {
@@ -48,20 +178,15 @@ void* hxfMalloc(size_t size) {
     }
 
 #if defined(HXF_DEBUG_ALLOC)
-    // Set a new HxfAlloc
-    allocsInfo[allocIndex].ptr = data;
-    allocsInfo[allocIndex].size = size;
-
-    byteAllocated += size; // Update the value
-    allocIndex++;
-    allocCount++;
-    printf("malloc: new size %lluB, malloc count = %llu\n", byteAllocated, allocCount);
+    pthread_mutex_lock(&allocMutex);
+    trackAllocation(data, size, tag);
+    pthread_mutex_unlock(&allocMutex);
 #endif
 
     return data;
 }
 
-void* hxfCalloc(size_t num, size_t size) {
+void* hxfCalloc(size_t num, size_t size, HxfAllocTag tag) {
     void* data = calloc(num, size);
 
     if (data == NULL) {
@@ -70,20 +195,24 @@ void* hxfCalloc(size_t num, size_t size) {
     }
 
 #if defined(HXF_DEBUG_ALLOC)
-    // Set a new HxfAlloc
-    allocsInfo[allocIndex].ptr = data;
-    allocsInfo[allocIndex].size = num * size;
-
-    byteAllocated += size; // Update the value
-    allocIndex++;
-    allocCount++;
-    printf("malloc: new size %lluB, malloc count = %llu\n", byteAllocated, allocCount);
+    pthread_mutex_lock(&allocMutex);
+    trackAllocation(data, num * size, tag);
+    pthread_mutex_unlock(&allocMutex);
 #endif
 
     return data;
 }
 
-void* hxfRealloc(void* ptr, size_t size) {
+void* hxfRealloc(void* ptr, size_t size, HxfAllocTag tag) {
+#if defined(HXF_DEBUG_ALLOC)
+    // The old block is removed first, and the table stays locked until the new one is added so
+    // that another thread can not be given the old block in between
+    pthread_mutex_lock(&allocMutex);
+    if (ptr != NULL) {
+        untrackAllocation(ptr);
+    }
+#endif
+
     void* data = realloc(ptr, size);
 
     if (data == NULL) {
@@ -92,38 +221,114 @@ void* hxfRealloc(void* ptr, size_t size) {
     }
 
 #if defined(HXF_DEBUG_ALLOC)
-    for (int i = allocIndex - 1; i != -1; i--) {
-        if (allocsInfo[i].ptr == ptr) {
-            // Redefine the HxfAlloc
-            allocsInfo[i].ptr = data;
-            byteAllocated = byteAllocated - allocsInfo[i].size + size; // Update
-            allocsInfo[i].size = size;
-
-            printf("realloc: new size %lluB, malloc count = %llu\n", byteAllocated, allocCount);
-            break;
-        }
-    }
+    trackAllocation(data, size, tag);
+    pthread_mutex_unlock(&allocMutex);
 #endif
 
     return data;
 }
 
 void hxfFree(void* ptr) {
+#if defined(HXF_DEBUG_ALLOC)
+    if (ptr != NULL) {
+        pthread_mutex_lock(&allocMutex);
+        if (!untrackAllocation(ptr)) {
+            HXF_MSG_ERROR("Freeing %p that was not allocated by hxfMalloc", ptr);
+        }
+        free(ptr);
+        pthread_mutex_unlock(&allocMutex);
+    }
+#else
     free(ptr);
+#endif
+}
+
+void hxfArenaInit(HxfArena* restrict arena, void* buffer, size_t capacity) {
+    arena->data = buffer;
+    arena->capacity = capacity;
+    arena->offset = 0;
+    arena->peak = 0;
+}
+
+void* hxfArenaAlloc(HxfArena* restrict arena, size_t size) {
+    // Aligned like malloc, for any type
+    const size_t alignment = _Alignof(max_align_t);
+    const size_t offset = (arena->offset + alignment - 1) & ~(alignment - 1);
+
+    if (offset + size > arena->capacity) {
+        HXF_FATAL("The arena is full, %zu B are used and %zu B more are asked", arena->offset, size);
+    }
+
+    arena->offset = offset + size;
+    if (arena->offset > arena->peak) {
+        arena->peak = arena->offset;
+    }
+
+    return arena->data + offset;
+}
+
+void hxfArenaReset(HxfArena* restrict arena, size_t mark) {
+    arena->offset = mark;
+}
+
+size_t hxfArenaEndFrame(HxfArena* restrict arena) {
+    const size_t peak = arena->peak;
+    arena->offset = 0;
+    arena->peak = 0;
+
+    return peak;
+}
+
+HxfArena* hxfGetScratchArena(void) {
+    // Each thread has its own buffer, so the arena is never shared
+    static _Thread_local _Alignas(max_align_t) unsigned char buffer[HXF_SCRATCH_ARENA_SIZE];
+    static _Thread_local HxfArena arena = { 0 };
+
+    if (arena.data == NULL) {
+        hxfArenaInit(&arena, buffer, sizeof(buffer));
+    }
+
+    return &arena;
+}
 
 #if defined(HXF_DEBUG_ALLOC)
-    for (int i = allocIndex - 1; i != -1; i--) {
-        if (allocsInfo[i].ptr == ptr) {
-            byteAllocated -= allocsInfo[i].size; // Update
+void hxfGetAllocStats(HxfAllocTag tag, HxfAllocStats* restrict stats) {
+    pthread_mutex_lock(&allocMutex);
+    *stats = allocStats[tag];
+    pthread_mutex_unlock(&allocMutex);
+}
+
+void hxfReportAllocations(void) {
+    pthread_mutex_lock(&allocMutex);
 
-            allocsInfo[i].ptr = NULL; // Clear the ptr value
-            break;
+    printf("Allocations:\n");
+    for (int i = 0; i != HXF_ALLOC_TAG_COUNT; i++) {
+        const HxfAllocStats* const stats = &allocStats[i];
+        printf(
+            "    %s: %zu B in %zu blocks, peak of %zu B, %zu allocations\n",
+            allocTagNames[i], stats->currentBytes, stats->currentCount, stats->peakBytes, stats->totalCount
+        );
+    }
+
+    // The live allocations are the leaks when the game stops
+    if (allocationTableCount != 0) {
+        printf("%zu allocations were not freed:\n", allocationTableCount);
+
+        size_t printedCount = 0;
+        for (size_t i = 0; i != allocationTableCapacity && printedCount != 32; i++) {
+            if (allocationTable[i].ptr != NULL) {
+                printf("    %p: %zu B (%s)\n", allocationTable[i].ptr, allocationTable[i].size, allocTagNames[allocationTable[i].tag]);
+                printedCount++;
+            }
+        }
+        if (printedCount != allocationTableCount) {
+            printf("    ...\n");
         }
     }
-    allocCount--;
-    printf("free: new size %lluB, malloc count = %llu\n", byteAllocated, allocCount);
-#endif
+
+    pthread_mutex_unlock(&allocMutex);
 }
+#endif
 
 HxfResult hxfReadFile(const char* filename, void** data, size_t* size) {
     FILE* file = fopen(filename, "rb");
@@ -137,8 +342,66 @@ HxfResult hxfReadFile(const char* filename, void** data, size_t* size) {
     fseek(file, 0, SEEK_SET);
 
     // Allocate and read the file
-    *data = hxfMalloc(*size);
+    *data = hxfMalloc(*size, HXF_ALLOC_IO);
     fread(*data, *size, 1, file);
+    fclose(file);
 
     return HXF_SUCCESS;
+}
+
+double hxfGetTime(void) {
+#ifdef HXF_WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + (double)time.tv_nsec / 1000000000.0;
+#endif
+}
+
+void hxfSleepTimerCreate(HxfSleepTimer* restrict timer) {
+#ifdef HXF_WIN32
+    // Sleep has the resolution of the system timer, about 15.6 ms, a high resolution timer ends
+    // within the spin margin of the frame limiter. It is not supported before Windows 10 1803.
+    timer->handle = CreateWaitableTimerExW(
+        NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS
+    );
+#else
+    timer->handle = NULL;
+#endif
+}
+
+void hxfSleepTimerDestroy(HxfSleepTimer* restrict timer) {
+#ifdef HXF_WIN32
+    if (timer->handle != NULL) {
+        CloseHandle(timer->handle);
+    }
+#endif
+    timer->handle = NULL;
+}
+
+void hxfSleep(const HxfSleepTimer* restrict timer, double duration) {
+#ifdef HXF_WIN32
+    if (timer->handle == NULL) {
+        Sleep((DWORD)(duration * 1000.0));
+        return;
+    }
+
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(LONGLONG)(duration * 10000000.0); // Relative, in 100 ns units
+    if (SetWaitableTimer(timer->handle, &dueTime, 0, NULL, NULL, FALSE)) {
+        WaitForSingleObject(timer->handle, INFINITE);
+    }
+#else
+    struct timespec time;
+    time.tv_sec = (time_t)duration;
+    time.tv_nsec = (long)((duration - (double)time.tv_sec) * 1000000000.0);
+    nanosleep(&time, NULL);
+#endif
 }
\ No newline at end of file
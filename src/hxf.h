@@ -15,6 +15,12 @@
  */
 #define HXF_FATAL(msg, ...) fprintf(stderr, "fatal error: "msg"\n",##__VA_ARGS__); exit(EXIT_FAILURE);
 
+#if !defined(HXF_WIN32)
+// windows.h defines them on Windows
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
 #define HXF_TRY_VK(funcCall) if (funcCall != VK_SUCCESS) { fprintf(stderr, "runtime error in file %s at line %i", __FILE__, __LINE__); exit(EXIT_FAILURE); }
 
  /**
@@ -24,26 +30,69 @@
 typedef enum HxfResult {
   HXF_SUCCESS, ///< No error
   HXF_ERROR, ///< General purpose error
-  HXF_WINDOW_CREATION_ERROR ///< Error when creating a window
+  HXF_WINDOW_CREATION_ERROR, ///< Error when creating a window
+  HXF_MISSING_FILE_ERROR ///< Error when a file that another file refers to does not exist
 } HxfResult;
 
+/**
+ * @brief The part of the game an allocation belongs to, the allocations are counted for each tag
+ * with HXF_DEBUG_ALLOC.
+ */
+typedef enum HxfAllocTag {
+    HXF_ALLOC_WORLD, ///< The world pieces and the map that holds them.
+    HXF_ALLOC_MESH, ///< The faces built from the cubes.
+    HXF_ALLOC_GRAPHICS, ///< The Vulkan objects’ information and the memory blocks.
+    HXF_ALLOC_IO, ///< The files that are read or written and their paths.
+    HXF_ALLOC_OTHER, ///< Everything else.
+    HXF_ALLOC_TAG_COUNT
+} HxfAllocTag;
+
+/**
+ * @brief The counters of the allocations of a tag.
+ */
+typedef struct HxfAllocStats {
+    size_t currentBytes; ///< The number of bytes that are allocated.
+    size_t peakBytes; ///< The largest number of bytes that were allocated at the same time.
+    size_t currentCount; ///< The number of blocks that are allocated.
+    size_t totalCount; ///< The number of blocks allocated since the start, including the reallocations.
+} HxfAllocStats;
+
+/**
+ * @brief The size (in bytes) of the scratch arena of each thread.
+ */
+#define HXF_SCRATCH_ARENA_SIZE 65536
+
+/**
+ * @brief A linear allocator for short-lived allocations.
+ *
+ * The allocations are taken one after the other from a buffer, and they are all freed at once by
+ * moving the offset back.
+ */
+typedef struct HxfArena {
+    unsigned char* data; ///< The buffer the allocations are taken from, it is not owned by the arena.
+    size_t capacity; ///< The size of the buffer.
+    size_t offset; ///< The size used by the allocations, the next one begins here.
+    size_t peak; ///< The largest offset since the last hxfArenaEndFrame.
+} HxfArena;
+
 /**
  * \brief Allocate size bytes of memory.
  * \param size The size of the block of memory to allocate.
+ * \param tag The part of the game the block belongs to.
  * \return A pointer to the data allocated.
  *
  * If the allocation fails, then it exits the program.
  */
-void* hxfMalloc(size_t size);
+void* hxfMalloc(size_t size, HxfAllocTag tag);
 
-void* hxfCalloc(size_t num, size_t size);
+void* hxfCalloc(size_t num, size_t size, HxfAllocTag tag);
 
 /**
  * @brief Reallocate ptr with its new size.
  *
- * If it fails, it exits the program.
+ * The block then belongs to tag. If it fails, it exits the program.
  */
-void* hxfRealloc(void* ptr, size_t size);
+void* hxfRealloc(void* ptr, size_t size, HxfAllocTag tag);
 
 /**
  * @brief Free the memory.
@@ -52,6 +101,55 @@ void* hxfRealloc(void* ptr, size_t size);
  */
 void hxfFree(void* ptr);
 
+/**
+ * @brief Initialize an arena that allocates from a buffer.
+ */
+void hxfArenaInit(HxfArena* restrict arena, void* buffer, size_t capacity);
+
+/**
+ * @brief Allocate size bytes from an arena, aligned for any type.
+ *
+ * If the arena is full, it exits the program.
+ */
+void* hxfArenaAlloc(HxfArena* restrict arena, size_t size);
+
+/**
+ * @brief Free all the allocations made since the offset was equal to mark.
+ *
+ * A scope saves the offset of the arena before allocating, then resets the arena to it.
+ */
+void hxfArenaReset(HxfArena* restrict arena, size_t mark);
+
+/**
+ * @brief Free all the allocations of an arena at the end of a frame.
+ *
+ * @return The largest size used during the frame.
+ */
+size_t hxfArenaEndFrame(HxfArena* restrict arena);
+
+/**
+ * @brief Get the scratch arena of the calling thread.
+ *
+ * Its allocations must be freed before the end of the scope that made them with hxfArenaReset,
+ * except on the thread that runs the game loop: the arena of that thread is the frame arena, its
+ * allocations last until the end of the frame.
+ */
+HxfArena* hxfGetScratchArena(void);
+
+#if defined(HXF_DEBUG_ALLOC)
+/**
+ * @brief Get the counters of the allocations of a tag.
+ */
+void hxfGetAllocStats(HxfAllocTag tag, HxfAllocStats* restrict stats);
+
+/**
+ * @brief Print the counters of each tag and the blocks that are still allocated.
+ *
+ * Once the game has stopped, the blocks that are still allocated are leaks.
+ */
+void hxfReportAllocations(void);
+#endif
+
 /**
  * \brief Read a file.
  *
@@ -67,3 +165,40 @@ void hxfFree(void* ptr);
  * \return HXF_ERROR if the file could not be open, HXF_SUCCESS otherwise.
  */
 HxfResult hxfReadFile(const char* filename, void** data, size_t* size);
+
+/**
+ * @brief Get the time with a high resolution, to measure durations.
+ *
+ * @return The time in seconds since an arbitrary point.
+ */
+double hxfGetTime(void);
+
+/**
+ * @brief The timer a thread sleeps on, created once and reused by each hxfSleep.
+ */
+typedef struct HxfSleepTimer {
+    void* handle; ///< The high resolution waitable timer on Windows, NULL if it is not supported or on the other systems.
+} HxfSleepTimer;
+
+/**
+ * @brief Create a sleep timer.
+ *
+ * On Windows it is a high resolution waitable timer, Sleep is used instead if the system does
+ * not support it.
+ */
+void hxfSleepTimerCreate(HxfSleepTimer* restrict timer);
+
+/**
+ * @brief Destroy a sleep timer.
+ */
+void hxfSleepTimerDestroy(HxfSleepTimer* restrict timer);
+
+/**
+ * @brief Suspend the calling thread.
+ *
+ * The thread may sleep longer than asked, by up to the resolution of the system timer.
+ *
+ * @param timer The timer to sleep on, it must only be used by one thread at a time.
+ * @param duration The duration of the sleep in seconds.
+ */
+void hxfSleep(const HxfSleepTimer* restrict timer, double duration);
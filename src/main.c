@@ -4,8 +4,30 @@
 #endif
 
 #include <windows.h>
+#endif
+
+#include <string.h>
+#include <time.h>
 #include "app.h"
 
+/**
+ * @brief Make the seed of a new world when none is given, from the current time.
+ *
+ * @return The seed.
+ */
+static uint32_t makeRandomSeed(void) {
+    uint64_t seed = (uint64_t)time(NULL) ^ (uint64_t)(hxfGetTime() * 1000000000.0);
+
+    // Mix the bits (the finalizer of splitmix64) so that close times give unrelated seeds
+    seed ^= seed >> 30;
+    seed *= 0xbf58476d1ce4e5b9ULL;
+    seed ^= seed >> 27;
+    seed *= 0x94d049bb133111ebULL;
+    seed ^= seed >> 31;
+
+    return (uint32_t)(seed ^ (seed >> 32));
+}
+
 /**
  * @brief Handle the parameters given to the command line to convert them to HxfAppParam.
  *
@@ -58,6 +80,177 @@ void handleParamaters(HxfAppParam* restrict appParam, int argc, char** argv) {
                 appParam->appDataDirectory = *currentArgument;
             }
         }
+        else if (strcmp(*currentArgument, "--gpu-culling") == 0) {
+            appParam->gpuCulling = 1;
+        }
+        else if (strcmp(*currentArgument, "--occlusion-culling") == 0) {
+            appParam->gpuCulling = 1;
+            appParam->occlusionCulling = 1;
+        }
+        else if (strcmp(*currentArgument, "--cave-culling") == 0) {
+            appParam->caveCulling = 1;
+        }
+        else if (strcmp(*currentArgument, "--command-buffers") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for command-buffers\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                if (strcmp(*currentArgument, "record") == 0) {
+                    appParam->commandBufferMode = HXF_COMMAND_BUFFER_RECORD;
+                }
+                else if (strcmp(*currentArgument, "reuse") == 0) {
+                    appParam->commandBufferMode = HXF_COMMAND_BUFFER_REUSE;
+                }
+                else if (strcmp(*currentArgument, "parallel") == 0) {
+                    appParam->commandBufferMode = HXF_COMMAND_BUFFER_PARALLEL;
+                }
+                else {
+                    fprintf(stderr, "Wrong command buffers mode given\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else if (strcmp(*currentArgument, "--record-time") == 0) {
+            appParam->printRecordTime = 1;
+        }
+        else if (strcmp(*currentArgument, "--present-mode") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for present-mode\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                if (strcmp(*currentArgument, "fifo") == 0) {
+                    appParam->presentMode = VK_PRESENT_MODE_FIFO_KHR;
+                }
+                else if (strcmp(*currentArgument, "mailbox") == 0) {
+                    appParam->presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+                }
+                else if (strcmp(*currentArgument, "immediate") == 0) {
+                    appParam->presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+                }
+                else {
+                    fprintf(stderr, "Wrong present mode given\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else if (strcmp(*currentArgument, "--max-fps") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for max-fps\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->maxFrameRate = strtoul(*currentArgument, NULL, 10);
+            }
+        }
+        else if (strcmp(*currentArgument, "--low-latency") == 0) {
+            appParam->lowLatency = 1;
+        }
+        else if (strcmp(*currentArgument, "--no-piece-sorting") == 0) {
+            appParam->sortPieces = 0;
+        }
+        else if (strcmp(*currentArgument, "--depth-prepass") == 0) {
+            appParam->depthPrepass = 1;
+        }
+        else if (strcmp(*currentArgument, "--pipeline-statistics") == 0) {
+            appParam->pipelineStatistics = 1;
+        }
+        else if (strcmp(*currentArgument, "--lod") == 0) {
+            appParam->levelOfDetail = 1;
+        }
+        else if (strcmp(*currentArgument, "--vertex-pulling") == 0) {
+            appParam->vertexPulling = 1;
+        }
+        else if (strcmp(*currentArgument, "--camera-path") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for camera-path\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->cameraPathFile = *currentArgument;
+            }
+        }
+        else if (strcmp(*currentArgument, "--frames") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for frames\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->frameLimit = strtoul(*currentArgument, NULL, 10);
+            }
+        }
+        else if (strcmp(*currentArgument, "--timings") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for timings\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->timingsFile = *currentArgument;
+            }
+        }
+        else if (strcmp(*currentArgument, "--capture") == 0) {
+            if (i >= argc - 2) {
+                fprintf(stderr, "No frame or file specified for capture\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->captureFrame = strtoul(*currentArgument, NULL, 10);
+                currentArgument++;
+                i++;
+                appParam->captureFile = *currentArgument;
+            }
+        }
+        else if (strcmp(*currentArgument, "--gpu-timings") == 0) {
+            appParam->printGpuTimings = 1;
+        }
+        else if (strcmp(*currentArgument, "--trace") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for trace\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->traceFile = *currentArgument;
+            }
+        }
+        else if (strcmp(*currentArgument, "--hitch") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for hitch\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->hitchThreshold = strtof(*currentArgument, NULL);
+            }
+        }
+        else if (strcmp(*currentArgument, "--seed") == 0) {
+            if (i == argc - 1) {
+                fprintf(stderr, "No argument specified for seed\n");
+                exit(EXIT_FAILURE);
+            }
+            else {
+                currentArgument++;
+                i++;
+                appParam->seed = strtoul(*currentArgument, NULL, 10);
+            }
+        }
         currentArgument++;
         i++;
     }
@@ -65,14 +258,22 @@ void handleParamaters(HxfAppParam* restrict appParam, int argc, char** argv) {
 
 int main(int argc, char** argv) {
     HxfAppParam param = {
-        GetModuleHandle(NULL), SW_NORMAL, 800, 600, "appdata"
+#if defined(HXF_WIN32)
+        GetModuleHandle(NULL), SW_NORMAL,
+#endif
+        800, 600, "appdata", 0, 0, 0, HXF_COMMAND_BUFFER_RECORD, 0,
+        VK_PRESENT_MODE_FIFO_KHR, 0, 0, 1, 0, 0, 0, 0,
+        NULL, 0, NULL, 0, NULL, 0, NULL, 0.0f, makeRandomSeed()
     };
 
     handleParamaters(&param, argc, argv);
 
     hxfAppStart(&param);
 
-    return 0;
-}
+#if defined(HXF_DEBUG_ALLOC)
+    // Everything is freed at this point, what is left leaked
+    hxfReportAllocations();
+#endif
 
-#endif
\ No newline at end of file
+    return 0;
+}
\ No newline at end of file
@@ -211,4 +211,19 @@ HxfMat4 hxfViewMatrix(const HxfVec3* restrict position, const HxfVec3* restrict
     } };
 
     return viewMatrix;
-}
\ No newline at end of file
+}
+
+void hxfFrustumPlanes(const HxfMat4* restrict viewProjection, HxfVec4* restrict planes) {
+    // The matrix is stored by columns so the row i is (mat[0][i], mat[1][i], mat[2][i], mat[3][i])
+    const float (*const m)[4] = viewProjection->mat;
+
+    // Left and right
+    planes[0] = (HxfVec4){ m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0] };
+    planes[1] = (HxfVec4){ m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0] };
+    // Bottom and top
+    planes[2] = (HxfVec4){ m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1] };
+    planes[3] = (HxfVec4){ m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1] };
+    // Near and far (the depth range is [0, 1] so the near plane is only the third row)
+    planes[4] = (HxfVec4){ m[0][2], m[1][2], m[2][2], m[3][2] };
+    planes[5] = (HxfVec4){ m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2] };
+}
@@ -198,4 +198,16 @@ HxfMat4 hxfPerspectiveProjectionMatrix(float near, float far, float fov, float a
  *
  * @return The view matrix.
  */
-HxfMat4 hxfViewMatrix(const HxfVec3* restrict position, const HxfVec3* restrict forwardDirection, const HxfVec3* restrict upDirection);
\ No newline at end of file
+HxfMat4 hxfViewMatrix(const HxfVec3* restrict position, const HxfVec3* restrict forwardDirection, const HxfVec3* restrict upDirection);
+
+/**
+ * @brief Extract the planes of the view frustum from a view-projection matrix.
+ *
+ * Each plane is (a, b, c, d) so that a point p is inside the plane when
+ * a * p.x + b * p.y + c * p.z + d >= 0. The planes are not normalized.
+ *
+ * @param viewProjection The view-projection matrix (projection × view).
+ * @param planes An array of 6 HxfVec4 that will receive the left, right, bottom, top,
+ * near and far planes.
+ */
+void hxfFrustumPlanes(const HxfMat4* restrict viewProjection, HxfVec4* restrict planes);
\ No newline at end of file
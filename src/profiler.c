@@ -0,0 +1,208 @@
+#include "profiler.h"
+
+#if defined(HXF_PROFILER)
+
+#include <stdatomic.h>
+
+/**
+ * @brief A zone that ended.
+ */
+typedef struct ProfilerEvent {
+    const char* name; ///< The name of the zone.
+    double start; ///< The time (from hxfGetTime) when the zone began.
+    double end; ///< The time (from hxfGetTime) when the zone ended.
+} ProfilerEvent;
+
+/**
+ * @brief The zones of a thread, in a ring buffer that only this thread writes.
+ */
+typedef struct ProfilerThread {
+    ProfilerEvent events[HXF_PROFILER_ZONE_COUNT];
+    /**
+     * @brief The number of zones written since the thread started, the next one is at this index
+     * modulo HXF_PROFILER_ZONE_COUNT.
+     *
+     * It is incremented once the zone is written, so the exporting thread only reads complete
+     * zones. The oldest zones may still be overwritten while they are exported.
+     */
+    atomic_uint_fast64_t writeCount;
+} ProfilerThread;
+
+static ProfilerThread profilerThreads[HXF_PROFILER_THREAD_COUNT];
+
+/**
+ * @brief The number of threads that recorded a zone, it can be larger than HXF_PROFILER_THREAD_COUNT.
+ */
+static atomic_uint profilerThreadCount = 0;
+
+/**
+ * @brief The zones of the calling thread, NULL until its first zone ends.
+ */
+static _Thread_local ProfilerThread* currentThread = NULL;
+
+/**
+ * @brief Set to 1 if the calling thread came after the first HXF_PROFILER_THREAD_COUNT threads.
+ */
+static _Thread_local int isThreadIgnored = 0;
+
+static const char* profilerTracePath = NULL; ///< The file the trace is written to when the profiler is destroyed.
+static double profilerStartTime; ///< The time when the profiler started, the trace begins there.
+static double hitchThreshold; ///< The duration (in seconds) above which a frame is a hitch, 0 if they are ignored.
+
+/**
+ * @brief The time when the last HXF_PROFILER_HITCH_FRAME_COUNT frames began.
+ */
+static double frameStartTimes[HXF_PROFILER_HITCH_FRAME_COUNT];
+static uint64_t frameCount = 0; ///< The number of frames that ended.
+static uint64_t lastHitchFrame = 0; ///< The frame of the last hitch that was written, the next one is written after all its frames.
+
+/**
+ * @brief Get the zones of the calling thread, it is given a ring buffer the first time.
+ *
+ * @return The zones, or NULL if there are too many threads.
+ */
+static ProfilerThread* getCurrentThread(void);
+
+static ProfilerThread* getCurrentThread(void) {
+    if (currentThread == NULL && !isThreadIgnored) {
+        const unsigned int index = atomic_fetch_add(&profilerThreadCount, 1);
+
+        if (index < HXF_PROFILER_THREAD_COUNT) {
+            currentThread = &profilerThreads[index];
+        }
+        else {
+            isThreadIgnored = 1;
+        }
+    }
+
+    return currentThread;
+}
+
+void hxfProfilerInit(const char* tracePath, double threshold) {
+    profilerTracePath = tracePath;
+    hitchThreshold = threshold;
+    profilerStartTime = hxfGetTime();
+    frameStartTimes[0] = profilerStartTime;
+
+    // The calling thread runs the game loop, it is the first one of the trace
+    getCurrentThread();
+}
+
+void hxfProfilerDestroy(void) {
+    if (profilerTracePath != NULL) {
+        if (hxfProfilerExport(profilerTracePath, profilerStartTime) == HXF_SUCCESS) {
+            printf("Profiler trace written to %s\n", profilerTracePath);
+        }
+        else {
+            HXF_MSG_ERROR("Could not write the profiler trace to %s", profilerTracePath);
+        }
+    }
+}
+
+void hxfProfilerFrame(void) {
+    const HxfProfilerZone frameZone = {
+        .name = "frame",
+        .start = frameStartTimes[frameCount % HXF_PROFILER_HITCH_FRAME_COUNT]
+    };
+    hxfProfilerEndZone(&frameZone);
+
+    const double now = hxfGetTime();
+    const double frameDuration = now - frameZone.start;
+    frameCount++;
+
+    // The first frame includes the loading, so it is not a hitch. A hitch is only written once the
+    // frames of the previous one have been replaced, so that a slow sequence of frames does not
+    // write a file each frame
+    if (hitchThreshold > 0.0 && frameDuration > hitchThreshold && frameCount > 1
+        && (lastHitchFrame == 0 || frameCount - lastHitchFrame >= HXF_PROFILER_HITCH_FRAME_COUNT)) {
+        // The oldest frame that is kept, it is overwritten below
+        const double hitchStartTime = frameCount < HXF_PROFILER_HITCH_FRAME_COUNT
+            ? profilerStartTime
+            : frameStartTimes[frameCount % HXF_PROFILER_HITCH_FRAME_COUNT];
+
+        char filename[64];
+        snprintf(filename, sizeof(filename), "hitch-%llu.json", (unsigned long long)(frameCount - 1));
+
+        if (hxfProfilerExport(filename, hitchStartTime) == HXF_SUCCESS) {
+            printf("Hitch of %.3f ms at frame %llu, written to %s\n", frameDuration * 1000.0, (unsigned long long)(frameCount - 1), filename);
+        }
+        else {
+            HXF_MSG_ERROR("Could not write the hitch to %s", filename);
+        }
+        lastHitchFrame = frameCount;
+    }
+
+    // The time spent writing the hitch is part of the next frame
+    frameStartTimes[frameCount % HXF_PROFILER_HITCH_FRAME_COUNT] = now;
+}
+
+HxfProfilerZone hxfProfilerBeginZone(const char* name) {
+    HxfProfilerZone zone = {
+        .name = name,
+        .start = hxfGetTime()
+    };
+
+    return zone;
+}
+
+void hxfProfilerEndZone(const HxfProfilerZone* restrict zone) {
+    const double end = hxfGetTime();
+    ProfilerThread* const thread = getCurrentThread();
+
+    if (thread == NULL) {
+        return;
+    }
+
+    // Only this thread writes the count
+    const uint_fast64_t writeCount = atomic_load_explicit(&thread->writeCount, memory_order_relaxed);
+    ProfilerEvent* const event = &thread->events[writeCount & (HXF_PROFILER_ZONE_COUNT - 1)];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+    atomic_store_explicit(&thread->writeCount, writeCount + 1, memory_order_release);
+}
+
+HxfResult hxfProfilerExport(const char* filename, double startTime) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        return HXF_ERROR;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"hexaface\"}}");
+
+    unsigned int threadCount = atomic_load(&profilerThreadCount);
+    if (threadCount > HXF_PROFILER_THREAD_COUNT) {
+        threadCount = HXF_PROFILER_THREAD_COUNT;
+    }
+
+    for (unsigned int i = 0; i != threadCount; i++) {
+        const ProfilerThread* const thread = &profilerThreads[i];
+        const uint_fast64_t writeCount = atomic_load_explicit(&thread->writeCount, memory_order_acquire);
+        const uint_fast64_t firstEvent = writeCount > HXF_PROFILER_ZONE_COUNT ? writeCount - HXF_PROFILER_ZONE_COUNT : 0;
+
+        // The threads are numbered in the order of their first zone, the game loop is the first one
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", i, i);
+
+        for (uint_fast64_t j = firstEvent; j != writeCount; j++) {
+            const ProfilerEvent* const event = &thread->events[j & (HXF_PROFILER_ZONE_COUNT - 1)];
+
+            if (event->start >= startTime) {
+                // Complete events, the times are in microseconds
+                fprintf(
+                    file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event->name, i,
+                    (event->start - profilerStartTime) * 1000000.0,
+                    (event->end - event->start) * 1000000.0
+                );
+            }
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return HXF_SUCCESS;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+/**
+ * \file profiler.h
+ * @brief A CPU profiler that records the duration of zones of code and exports them as a Chrome trace.
+ *
+ * It is only compiled when HXF_PROFILER is defined (the PROFILER CMake variable), otherwise
+ * HXF_ZONE does nothing.
+ */
+#pragma once
+
+#if defined(HXF_PROFILER)
+
+#include "hxf.h"
+
+#include <stdint.h>
+
+/**
+ * @brief The maximum number of threads that can record zones, the zones of the other threads are ignored.
+ */
+#define HXF_PROFILER_THREAD_COUNT 16
+
+/**
+ * @brief The number of zones each thread keeps, the oldest ones are overwritten. It must be a power of 2.
+ */
+#define HXF_PROFILER_ZONE_COUNT 16384
+
+/**
+ * @brief The number of frames written when a frame is longer than the hitch threshold.
+ */
+#define HXF_PROFILER_HITCH_FRAME_COUNT 120
+
+#define HXF_PROFILER_CONCAT_INNER(a, b) a##b
+#define HXF_PROFILER_CONCAT(a, b) HXF_PROFILER_CONCAT_INNER(a, b)
+
+/**
+ * @brief Measure the zone from this line to the end of the enclosing block.
+ *
+ * The zone ends when the block is left, whichever way it is left, with the cleanup attribute of
+ * GCC and Clang.
+ *
+ * @param name The name of the zone, it must be a string literal or live until the profiler is destroyed.
+ */
+#define HXF_ZONE(name) \
+    HxfProfilerZone HXF_PROFILER_CONCAT(hxfZone, __LINE__) __attribute__((cleanup(hxfProfilerEndZone))) = hxfProfilerBeginZone(name)
+
+/**
+ * @brief Mark the end of a frame (hxfProfilerFrame).
+ */
+#define HXF_PROFILER_FRAME() hxfProfilerFrame()
+
+/**
+ * @brief A zone that is being measured.
+ */
+typedef struct HxfProfilerZone {
+    const char* name; ///< The name of the zone.
+    double start; ///< The time (from hxfGetTime) when the zone began.
+} HxfProfilerZone;
+
+/**
+ * @brief Start the profiler, before any zone is measured.
+ *
+ * @param tracePath The Chrome trace file all the zones still kept are written to when the
+ * profiler is destroyed, NULL to not write it.
+ * @param hitchThreshold The duration (in seconds) above which a frame is a hitch. The last
+ * HXF_PROFILER_HITCH_FRAME_COUNT frames are then written to hitch-<frame>.json. 0 to not look
+ * for the hitches.
+ */
+void hxfProfilerInit(const char* tracePath, double hitchThreshold);
+
+/**
+ * @brief Write the trace file if there is one, once no zone is measured anymore.
+ */
+void hxfProfilerDestroy(void);
+
+/**
+ * @brief Mark the end of a frame, it must be called by the thread that runs the game loop.
+ *
+ * The frame is recorded as a zone, and the last frames are written if it is a hitch.
+ */
+void hxfProfilerFrame(void);
+
+/**
+ * @brief Begin a zone, HXF_ZONE is used instead.
+ */
+HxfProfilerZone hxfProfilerBeginZone(const char* name);
+
+/**
+ * @brief End a zone and add it to the zones of the calling thread, HXF_ZONE is used instead.
+ *
+ * It does not lock, each thread only writes its own zones.
+ */
+void hxfProfilerEndZone(const HxfProfilerZone* restrict zone);
+
+/**
+ * @brief Write the zones that ended since a time to a Chrome trace file (chrome://tracing or Perfetto).
+ *
+ * @param filename The path of the JSON file.
+ * @param startTime The time (from hxfGetTime) of the oldest zone that is written.
+ *
+ * @return HXF_ERROR if the file could not be opened, HXF_SUCCESS otherwise.
+ */
+HxfResult hxfProfilerExport(const char* filename, double startTime);
+
+#else
+
+#define HXF_ZONE(name)
+#define HXF_PROFILER_FRAME()
+
+#endif
\ No newline at end of file
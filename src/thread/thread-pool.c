@@ -0,0 +1,100 @@
+#include "thread-pool.h"
+#include "../hxf.h"
+
+/**
+ * @brief The function run by each thread of a pool.
+ *
+ * @param arg A pointer to the HxfThreadPool.
+ */
+static void* threadMain(void* arg) {
+    HxfThreadPool* const pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (!pool->shouldStop) {
+        if (pool->nextTask == pool->taskCount) {
+            pthread_cond_wait(&pool->taskCondition, &pool->mutex);
+            continue;
+        }
+
+        // Take the next task and run it without holding the lock
+
+        const uint32_t taskIndex = pool->nextTask++;
+        const HxfThreadPoolTask task = pool->task;
+        void* const userData = pool->userData;
+
+        pthread_mutex_unlock(&pool->mutex);
+        task(userData, taskIndex);
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->doneCount++;
+        if (pool->doneCount == pool->taskCount) {
+            pthread_cond_signal(&pool->doneCondition);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+void hxfThreadPoolCreate(HxfThreadPool* restrict pool, uint32_t threadCount) {
+    pool->threadCount = threadCount;
+    pool->task = NULL;
+    pool->userData = NULL;
+    pool->taskCount = 0;
+    pool->nextTask = 0;
+    pool->doneCount = 0;
+    pool->shouldStop = 0;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->taskCondition, NULL);
+    pthread_cond_init(&pool->doneCondition, NULL);
+
+    pool->threads = hxfMalloc(sizeof(pthread_t) * threadCount, HXF_ALLOC_OTHER);
+    for (uint32_t i = 0; i != threadCount; i++) {
+        if (pthread_create(&pool->threads[i], NULL, threadMain, pool) != 0) {
+            HXF_FATAL("Could not create a thread");
+        }
+    }
+}
+
+void hxfThreadPoolDestroy(HxfThreadPool* restrict pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->shouldStop = 1;
+    pthread_cond_broadcast(&pool->taskCondition);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (uint32_t i = 0; i != pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    hxfFree(pool->threads);
+
+    pthread_cond_destroy(&pool->doneCondition);
+    pthread_cond_destroy(&pool->taskCondition);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+void hxfThreadPoolRun(HxfThreadPool* restrict pool, HxfThreadPoolTask task, void* userData, uint32_t taskCount) {
+    if (taskCount == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->task = task;
+    pool->userData = userData;
+    pool->taskCount = taskCount;
+    pool->nextTask = 0;
+    pool->doneCount = 0;
+    pthread_cond_broadcast(&pool->taskCondition);
+
+    while (pool->doneCount != pool->taskCount) {
+        pthread_cond_wait(&pool->doneCondition, &pool->mutex);
+    }
+
+    pool->taskCount = 0;
+    pool->nextTask = 0;
+
+    pthread_mutex_unlock(&pool->mutex);
+}
\ No newline at end of file
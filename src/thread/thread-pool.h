@@ -0,0 +1,58 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief A task run by the threads of a thread pool.
+ *
+ * @param userData The data given to hxfThreadPoolRun.
+ * @param taskIndex The index of the task, from 0 to the task count - 1. Each index is run once.
+ */
+typedef void (*HxfThreadPoolTask)(void* userData, uint32_t taskIndex);
+
+/**
+ * @brief Threads that wait for tasks to run.
+ */
+typedef struct HxfThreadPool {
+    pthread_t* threads; ///< The threads of the pool.
+    uint32_t threadCount; ///< The number of threads.
+
+    pthread_mutex_t mutex; ///< Protects all the fields below.
+    pthread_cond_t taskCondition; ///< Signaled when tasks are available or when the pool stops.
+    pthread_cond_t doneCondition; ///< Signaled when the last task is done.
+
+    HxfThreadPoolTask task; ///< The function that is run.
+    void* userData; ///< The data given to the task.
+    uint32_t taskCount; ///< The number of tasks of the current run.
+    uint32_t nextTask; ///< The index of the next task that will be run.
+    uint32_t doneCount; ///< The number of tasks of the current run that are done.
+    int shouldStop; ///< Set to 1 when the threads must end.
+} HxfThreadPool;
+
+/**
+ * @brief Create a thread pool and start its threads.
+ *
+ * @param pool A pointer to the pool.
+ * @param threadCount The number of threads, at least 1.
+ */
+void hxfThreadPoolCreate(HxfThreadPool* restrict pool, uint32_t threadCount);
+
+/**
+ * @brief Stop the threads of a thread pool and destroy it.
+ *
+ * It must not be running tasks.
+ *
+ * @param pool A pointer to the pool.
+ */
+void hxfThreadPoolDestroy(HxfThreadPool* restrict pool);
+
+/**
+ * @brief Run tasks on the threads of the pool and wait for all of them to be done.
+ *
+ * @param pool A pointer to the pool.
+ * @param task The function that is called for each task.
+ * @param userData The data given to each call of task.
+ * @param taskCount The number of tasks.
+ */
+void hxfThreadPoolRun(HxfThreadPool* restrict pool, HxfThreadPoolTask task, void* userData, uint32_t taskCount);
\ No newline at end of file
@@ -0,0 +1,503 @@
+/**
+ * \file world-tool.c
+ * @brief A command line tool that generates and maintains the world pieces without the game.
+ *
+ * It only uses the world and needs neither Vulkan nor a window.
+ */
+#include "../world.h"
+#include "../hxf.h"
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * @brief The longest path of a file of the world.
+ */
+#define WORLD_TOOL_PATH_SIZE 4096
+
+/**
+ * @brief The size of a piece file that has its cubes, and of a block file.
+ */
+#define PIECE_FILE_SIZE (HXF_WORLD_PIECE_CUBE_COUNT * sizeof(uint32_t))
+
+/**
+ * @brief A file of the world directory.
+ */
+typedef struct WorldFile {
+    const char* name; ///< The name of the file.
+    const char* path; ///< The path of the file.
+    int isPiece; ///< Set to 1 if the name is the position of a piece.
+    HxfIvec3 position; ///< The position of the piece if it is one.
+    int isBlock; ///< Set to 1 if the name is the one of a block file.
+    uint64_t hash; ///< The hash of the block if it is one.
+    long long size; ///< The size of the file (in bytes).
+} WorldFile;
+
+/**
+ * @brief A function called for each file of the world directory.
+ *
+ * @param world The world.
+ * @param file The file.
+ * @param userData The data given to forEachWorldFile.
+ */
+typedef void (*WorldFileCallback)(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief The statistics of the pieces of a world.
+ */
+typedef struct PieceStatistics {
+    uint32_t pieceCount; ///< The number of piece files.
+    uint32_t referenceCount; ///< The number of piece files that refer to a block file.
+    uint32_t blockCount; ///< The number of block files.
+    long long diskSize; ///< The size of the piece files and of the block files (in bytes).
+    uint64_t textureCounts[HXF_TEXTURE_COUNT]; ///< The number of cubes of each texture, air included.
+    uint64_t invalidCubeCount; ///< The number of cubes whose texture does not exist.
+    uint32_t uniformPieceCount; ///< The number of pieces made of a single texture.
+    HxfIvec3 min; ///< The position of the piece with the lowest coordinates.
+    HxfIvec3 max; ///< The position of the piece with the highest coordinates.
+} PieceStatistics;
+
+/**
+ * @brief The counters of the commands that change the piece files.
+ */
+typedef struct PieceChanges {
+    uint32_t pieceCount; ///< The number of pieces changed.
+    long long diskSize; ///< The size of the files removed (in bytes).
+    uint32_t problemCount; ///< The number of problems verify found.
+    uint32_t blockCount; ///< The number of block files removed.
+    uint64_t* blockHashes; ///< The hashes of the block files that the pieces refer to.
+    uint32_t blockHashCount; ///< The number of hashes in blockHashes.
+    uint32_t blockHashCapacity; ///< The number of hashes blockHashes can hold.
+} PieceChanges;
+
+/**
+ * @brief Print how to use the tool.
+ */
+static void printUsage(void);
+
+/**
+ * @brief Call a function for each file of the world directory, except the directories.
+ *
+ * @param world The world.
+ * @param callback The function.
+ * @param userData The data given to each call.
+ */
+static void forEachWorldFile(HxfWorld* restrict world, WorldFileCallback callback, void* userData);
+
+/**
+ * @brief Add a piece file to the PieceStatistics.
+ */
+static void addPieceStatistics(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief Check that a file is a piece file of the right size with existing textures, and count
+ * the problems in the PieceChanges.
+ */
+static void verifyPiece(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief Remove a piece file that has the same cubes as the piece that would be generated, as
+ * it is generated again when it is needed.
+ */
+static void compactPiece(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief Add the block file a piece file refers to to the hashes of the PieceChanges.
+ */
+static void addBlockReference(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief Remove a block file that no piece file of the PieceChanges refers to.
+ */
+static void removeUnusedBlock(HxfWorld* world, const WorldFile* file, void* userData);
+
+/**
+ * @brief Read a piece file and write it again in the current format.
+ */
+static void rewritePiece(HxfWorld* world, const WorldFile* file, void* userData);
+
+/*
+IMPLEMENTATION
+*/
+
+static void printUsage(void) {
+    fprintf(
+        stderr,
+        "Usage: hexaface-worldtool <world directory> <command> [--seed number]\n"
+        "Commands:\n"
+        "    generate minX minZ maxX maxZ   generate the pieces of a region that were never saved\n"
+        "    stats                          print the disk usage and the cubes of the pieces\n"
+        "    verify                         check the piece files\n"
+        "    compact                        remove the piece files that are the same as their generated piece,\n"
+        "                                   and the block files no piece refers to\n"
+        "    rewrite                        read and write again every piece file\n"
+    );
+}
+
+static void forEachWorldFile(HxfWorld* restrict world, WorldFileCallback callback, void* userData) {
+    DIR* const directory = opendir(world->directoryPath);
+    if (directory == NULL) {
+        HXF_FATAL("Could not open the world directory %s", world->directoryPath);
+    }
+
+    char path[WORLD_TOOL_PATH_SIZE];
+    struct dirent* entry;
+
+    while ((entry = readdir(directory)) != NULL) {
+        snprintf(path, sizeof(path), "%s/%s", world->directoryPath, entry->d_name);
+
+        struct stat fileStatus;
+        if (stat(path, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode)) {
+            continue;
+        }
+
+        WorldFile file = {
+            .name = entry->d_name,
+            .path = path,
+            .size = fileStatus.st_size,
+        };
+
+        // The name of a piece file is its position, x_y_z
+        int nameLength = 0;
+        file.isPiece = sscanf(entry->d_name, "%d_%d_%d%n", &file.position.x, &file.position.y, &file.position.z, &nameLength) == 3
+            && entry->d_name[nameLength] == '\0';
+
+        // The name of a block file is the hash of its cubes
+        unsigned long long hash = 0;
+        nameLength = 0;
+        file.isBlock = sscanf(entry->d_name, HXF_WORLD_BLOCK_FILE_PREFIX "%16llx%n", &hash, &nameLength) == 1
+            && entry->d_name[nameLength] == '\0';
+        file.hash = hash;
+
+        callback(world, &file, userData);
+    }
+
+    closedir(directory);
+}
+
+static void addPieceStatistics(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceStatistics* const statistics = userData;
+
+    if (file->isBlock) {
+        statistics->blockCount++;
+        statistics->diskSize += file->size;
+    }
+    if (!file->isPiece) {
+        return;
+    }
+
+    HxfWorldBlock block = { 0 };
+    HxfWorldPiece piece = { .position = file->position, .block = &block };
+    hxfWorldReadPiece(world, &piece);
+
+    uint64_t hash;
+    if (hxfWorldGetPieceBlockHash(world, &file->position, &hash) == HXF_SUCCESS) {
+        statistics->referenceCount++;
+    }
+
+    const uint32_t* const cubes = &block.cubes[0][0][0];
+    int isUniform = 1;
+
+    for (uint32_t i = 0; i != HXF_WORLD_PIECE_CUBE_COUNT; i++) {
+        if (cubes[i] < HXF_TEXTURE_COUNT) {
+            statistics->textureCounts[cubes[i]]++;
+        }
+        else {
+            statistics->invalidCubeCount++;
+        }
+        if (cubes[i] != cubes[0]) {
+            isUniform = 0;
+        }
+    }
+
+    if (statistics->pieceCount == 0) {
+        statistics->min = file->position;
+        statistics->max = file->position;
+    }
+    else {
+        if (file->position.x < statistics->min.x) statistics->min.x = file->position.x;
+        if (file->position.y < statistics->min.y) statistics->min.y = file->position.y;
+        if (file->position.z < statistics->min.z) statistics->min.z = file->position.z;
+        if (file->position.x > statistics->max.x) statistics->max.x = file->position.x;
+        if (file->position.y > statistics->max.y) statistics->max.y = file->position.y;
+        if (file->position.z > statistics->max.z) statistics->max.z = file->position.z;
+    }
+
+    statistics->pieceCount++;
+    statistics->diskSize += file->size;
+    statistics->uniformPieceCount += isUniform;
+}
+
+static void verifyPiece(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceChanges* const changes = userData;
+
+    if (file->isBlock) {
+        if (file->size != (long long)PIECE_FILE_SIZE) {
+            printf("%s: %lld bytes instead of %zu\n", file->name, file->size, PIECE_FILE_SIZE);
+            changes->problemCount++;
+        }
+        return;
+    }
+    if (!file->isPiece) {
+        if (strcmp(file->name, "info") != 0) {
+            printf("%s: not a piece file\n", file->name);
+            changes->problemCount++;
+        }
+        return;
+    }
+
+    changes->pieceCount++;
+
+    // A piece file that refers to a block file and the file of a uniform piece are shorter
+    uint64_t hash;
+    uint32_t uniformCube;
+    if (hxfWorldGetPieceBlockHash(world, &file->position, &hash) == HXF_ERROR
+        && hxfWorldGetPieceUniformCube(world, &file->position, &uniformCube) == HXF_ERROR
+        && file->size != (long long)PIECE_FILE_SIZE) {
+        printf("%s: %lld bytes instead of %zu\n", file->name, file->size, PIECE_FILE_SIZE);
+        changes->problemCount++;
+    }
+
+    HxfWorldBlock block = { 0 };
+    HxfWorldPiece piece = { .position = file->position, .block = &block };
+    if (hxfWorldReadPiece(world, &piece) == HXF_MISSING_FILE_ERROR) {
+        // Only a piece that refers to a block file can miss it
+        hxfWorldGetPieceBlockHash(world, &file->position, &hash);
+        printf("%s: its block file %s%016llx is missing\n", file->name, HXF_WORLD_BLOCK_FILE_PREFIX, (unsigned long long)hash);
+        changes->problemCount++;
+        return;
+    }
+
+    const uint32_t* const cubes = &block.cubes[0][0][0];
+    uint32_t invalidCubeCount = 0;
+    for (uint32_t i = 0; i != HXF_WORLD_PIECE_CUBE_COUNT; i++) {
+        if (cubes[i] >= HXF_TEXTURE_COUNT) {
+            invalidCubeCount++;
+        }
+    }
+
+    if (invalidCubeCount != 0) {
+        printf("%s: %u cubes with a texture that does not exist\n", file->name, invalidCubeCount);
+        changes->problemCount++;
+    }
+}
+
+static void compactPiece(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceChanges* const changes = userData;
+
+    if (!file->isPiece) {
+        return;
+    }
+
+    HxfWorldBlock block = { 0 };
+    HxfWorldBlock generatedBlock = { 0 };
+    HxfWorldPiece piece = { .position = file->position, .block = &block };
+    HxfWorldPiece generatedPiece = { .position = file->position, .block = &generatedBlock };
+
+    if (hxfWorldReadPiece(world, &piece) != HXF_SUCCESS) {
+        return;
+    }
+    hxfWorldGeneratePiece(world, &generatedPiece);
+
+    if (memcmp(block.cubes, generatedBlock.cubes, sizeof(block.cubes)) == 0) {
+        if (remove(file->path) == 0) {
+            changes->pieceCount++;
+            changes->diskSize += file->size;
+        }
+        else {
+            HXF_MSG_ERROR("Could not remove %s", file->path);
+        }
+    }
+}
+
+static void addBlockReference(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceChanges* const changes = userData;
+    uint64_t hash;
+
+    if (!file->isPiece || hxfWorldGetPieceBlockHash(world, &file->position, &hash) == HXF_ERROR) {
+        return;
+    }
+
+    if (changes->blockHashCount == changes->blockHashCapacity) {
+        changes->blockHashCapacity = changes->blockHashCapacity == 0 ? 64 : changes->blockHashCapacity * 2;
+        changes->blockHashes = hxfRealloc(changes->blockHashes, sizeof(uint64_t) * changes->blockHashCapacity, HXF_ALLOC_OTHER);
+    }
+    changes->blockHashes[changes->blockHashCount] = hash;
+    changes->blockHashCount++;
+}
+
+static void removeUnusedBlock(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceChanges* const changes = userData;
+
+    if (!file->isBlock) {
+        return;
+    }
+
+    for (uint32_t i = 0; i != changes->blockHashCount; i++) {
+        if (changes->blockHashes[i] == file->hash) {
+            return;
+        }
+    }
+
+    if (remove(file->path) == 0) {
+        changes->blockCount++;
+        changes->diskSize += file->size;
+    }
+    else {
+        HXF_MSG_ERROR("Could not remove %s", file->path);
+    }
+}
+
+static void rewritePiece(HxfWorld* world, const WorldFile* file, void* userData) {
+    PieceChanges* const changes = userData;
+
+    if (!file->isPiece) {
+        return;
+    }
+
+    // A piece that refers to a block file still refers to it
+    HxfWorldBlock block = { 0 };
+    HxfWorldPiece piece = { .position = file->position, .block = &block };
+    if (hxfWorldReadPiece(world, &piece) != HXF_SUCCESS) {
+        HXF_MSG_ERROR("Could not read %s", file->path);
+        return;
+    }
+
+    // A uniform piece saved with all its cubes only keeps its texture
+    const uint32_t* const cubes = &block.cubes[0][0][0];
+    uint32_t i = 1;
+    while (i != HXF_WORLD_PIECE_CUBE_COUNT && cubes[i] == cubes[0]) {
+        i++;
+    }
+    if (i == HXF_WORLD_PIECE_CUBE_COUNT) {
+        piece.block = NULL;
+        piece.uniformCube = cubes[0];
+    }
+
+    hxfWorldWritePiece(world, &piece);
+
+    changes->pieceCount++;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    HxfWorld world = {
+        .directoryPath = argv[1],
+    };
+    const char* const command = argv[2];
+    int argumentCount = argc - 3; // The arguments of the command
+
+    if (argumentCount >= 2 && strcmp(argv[argc - 2], "--seed") == 0) {
+        world.seed = strtoul(argv[argc - 1], NULL, 10);
+        argumentCount -= 2;
+    }
+
+    // The camera of the info file is written back as it was
+    HxfVec3 cameraPosition;
+    float cameraYaw;
+    float cameraPitch;
+    HxfWorldSaveData data = {
+        .world = &world,
+        .cameraPosition = &cameraPosition,
+        .cameraYaw = &cameraYaw,
+        .cameraPitch = &cameraPitch
+    };
+
+    hxfWorldOpen(&data);
+
+    if (world.isFlat) {
+        printf("World %s: made before the terrain generator, its pieces are flat\n", world.directoryPath);
+    }
+    else {
+        printf("World %s: seed %u\n", world.directoryPath, world.seed);
+    }
+
+    int result = EXIT_SUCCESS;
+
+    if (strcmp(command, "generate") == 0 && argumentCount == 4) {
+        const HxfIvec3 min = { strtol(argv[3], NULL, 10), 0, strtol(argv[4], NULL, 10) };
+        const HxfIvec3 max = { strtol(argv[5], NULL, 10), 0, strtol(argv[6], NULL, 10) };
+
+        const double startTime = hxfGetTime();
+        const uint32_t generatedPieceCount = hxfWorldGenerateRegion(&world, &min, &max);
+        const double duration = hxfGetTime() - startTime;
+
+        printf(
+            "%u pieces generated in %.3f ms: %.0f pieces per second, %.0f pieces per second per thread\n",
+            generatedPieceCount, duration * 1000.0,
+            generatedPieceCount / duration,
+            world.generationDuration > 0.0 ? generatedPieceCount / world.generationDuration : 0.0
+        );
+        hxfWorldSave(&data);
+    }
+    else if (strcmp(command, "stats") == 0 && argumentCount == 0) {
+        PieceStatistics statistics = { 0 };
+        forEachWorldFile(&world, addPieceStatistics, &statistics);
+
+        const double cubeCount = (double)statistics.pieceCount * HXF_WORLD_PIECE_CUBE_COUNT;
+
+        printf("%u pieces, %.1f KiB on the disk\n", statistics.pieceCount, statistics.diskSize / 1024.0);
+        printf("%u pieces refer to %u block files\n", statistics.referenceCount, statistics.blockCount);
+        if (statistics.pieceCount != 0) {
+            printf(
+                "Pieces from (%d, %d, %d) to (%d, %d, %d)\n",
+                statistics.min.x, statistics.min.y, statistics.min.z,
+                statistics.max.x, statistics.max.y, statistics.max.z
+            );
+            printf("%u pieces made of a single texture\n", statistics.uniformPieceCount);
+            for (int i = 0; i != HXF_TEXTURE_COUNT; i++) {
+                printf("    texture %d%s: %.2f %% of the cubes\n", i, i == 0 ? " (air)" : "", statistics.textureCounts[i] * 100.0 / cubeCount);
+            }
+            if (statistics.invalidCubeCount != 0) {
+                printf("    other textures: %llu cubes\n", (unsigned long long)statistics.invalidCubeCount);
+            }
+        }
+        hxfWorldClose(&world);
+    }
+    else if (strcmp(command, "verify") == 0 && argumentCount == 0) {
+        PieceChanges changes = { 0 };
+        forEachWorldFile(&world, verifyPiece, &changes);
+
+        printf("%u pieces verified, %u problems found\n", changes.pieceCount, changes.problemCount);
+        if (changes.problemCount != 0) {
+            result = EXIT_FAILURE;
+        }
+        hxfWorldClose(&world);
+    }
+    else if (strcmp(command, "compact") == 0 && argumentCount == 0) {
+        PieceChanges changes = { 0 };
+        forEachWorldFile(&world, compactPiece, &changes);
+        forEachWorldFile(&world, addBlockReference, &changes);
+        forEachWorldFile(&world, removeUnusedBlock, &changes);
+        hxfFree(changes.blockHashes);
+
+        printf(
+            "%u pieces removed as they are generated the same, %u unused block files removed, %.1f KiB freed\n",
+            changes.pieceCount, changes.blockCount, changes.diskSize / 1024.0
+        );
+        hxfWorldSave(&data);
+    }
+    else if (strcmp(command, "rewrite") == 0 && argumentCount == 0) {
+        PieceChanges changes = { 0 };
+        forEachWorldFile(&world, rewritePiece, &changes);
+
+        printf("%u pieces rewritten\n", changes.pieceCount);
+        hxfWorldSave(&data);
+    }
+    else {
+        printUsage();
+        hxfWorldClose(&world);
+        result = EXIT_FAILURE;
+    }
+
+#if defined(HXF_DEBUG_ALLOC)
+    hxfReportAllocations();
+#endif
+
+    return result;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "window.h"
+#include "../profiler.h"
 
 /**
  * @brief The window procedure of the main window.
@@ -46,6 +47,7 @@ HxfResult hxfCreateMainWindow(const HxfWindowParam* restrict param, HxfWindow* w
     }
 
     ShowWindow(window->hwnd, param->nCmdShow);
+    window->isFocused = 1;
 
     return HXF_SUCCESS;
 }
@@ -60,6 +62,8 @@ HxfResult hxfDestroyMainWindow(HxfWindow* restrict window) {
 }
 
 void hxfReadWindowMessages(HxfWindow* restrict window) {
+    HXF_ZONE("window.readMessages");
+
     MSG msg = { 0 };
     while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
         // Make the window procedure handle the message
@@ -86,6 +90,8 @@ void hxfReadWindowMessages(HxfWindow* restrict window) {
             break;
         }
     }
+
+    window->isFocused = GetForegroundWindow() == window->hwnd && !IsIconic(window->hwnd);
 }
 
 void hxfCreateWindowSurface(HxfWindow* restrict window, VkInstance instance, VkSurfaceKHR* restrict surface) {
@@ -101,7 +107,7 @@ void hxfCreateWindowSurface(HxfWindow* restrict window, VkInstance instance, VkS
 }
 
 void hxfGetRequiredWindowExtensions(char*** extensions, int* count) {
-    *extensions = hxfMalloc(2 * sizeof(char*));
+    *extensions = hxfMalloc(2 * sizeof(char*), HXF_ALLOC_GRAPHICS);
     (*extensions)[0] = "VK_KHR_surface";
     (*extensions)[1] = "VK_KHR_win32_surface";
 
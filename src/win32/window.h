@@ -39,4 +39,5 @@ struct HxfWindow {
     void* keyUpCallbackParameter[HXF_WINDOW_KEY_CALLBACK_COUNT];
     
     int shouldDestroyed; ///< Indicates that the window should be destroyed
+    int isFocused; ///< Indicates that the window is the foreground window and is not minimized
 };
\ No newline at end of file
@@ -102,4 +102,6 @@ void hxfSetKeyUpCallback(HxfWindow* window, HxfKeyCode scancode, void (*function
 // The declaration is needed first, before including the rest
 #if defined(HXF_WIN32)
 #include "win32/window.h"
+#elif defined(HXF_HEADLESS)
+#include "headless/window.h"
 #endif
\ No newline at end of file
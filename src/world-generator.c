@@ -0,0 +1,224 @@
+#include "world-generator.h"
+
+/**
+ * @brief The number of cubes whose noise is evaluated at once, the width of the vector registers.
+ */
+#if defined(__AVX__)
+#define NOISE_LANE_COUNT 8
+#else
+#define NOISE_LANE_COUNT 4
+#endif
+
+#define GROUND_OCTAVE_COUNT 4 ///< The number of octaves of the ground height.
+#define GROUND_FREQUENCY (1.0f / 64.0f) ///< The frequency (in cubes) of the first octave of the ground.
+#define GROUND_MIN_HEIGHT 4 ///< The lowest height of the ground (in cubes).
+#define GROUND_MAX_HEIGHT 15 ///< The highest height of the ground (in cubes), the top of the pieces.
+#define GROUND_CONTRAST 2.5f ///< Stretches the noise, which is rarely near -1 or 1, the heights beyond the limits are clamped.
+#define DIRT_DEPTH 3 ///< The number of dirt cubes under the grass.
+#define CAVE_FREQUENCY (1.0f / 12.0f) ///< The horizontal frequency (in cubes) of the caves.
+#define CAVE_VERTICAL_FREQUENCY (1.0f / 6.0f) ///< The vertical frequency (in cubes) of the caves, they are flatter than wide.
+#define CAVE_THRESHOLD 0.3f ///< The noise above which a cube is in a cave.
+
+typedef float FloatLanes __attribute__((vector_size(NOISE_LANE_COUNT * sizeof(float))));
+typedef int32_t IntLanes __attribute__((vector_size(NOISE_LANE_COUNT * sizeof(int32_t))));
+typedef uint32_t UintLanes __attribute__((vector_size(NOISE_LANE_COUNT * sizeof(uint32_t))));
+
+/**
+ * @brief The index of each lane, to give consecutive cubes to the lanes.
+ */
+#if NOISE_LANE_COUNT == 8
+static const FloatLanes LANE_INDICES = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+#else
+static const FloatLanes LANE_INDICES = { 0.0f, 1.0f, 2.0f, 3.0f };
+#endif
+
+/**
+ * @brief Round the lanes down to integers.
+ */
+static inline IntLanes floorLanes(FloatLanes x) {
+    const IntLanes truncated = __builtin_convertvector(x, IntLanes);
+
+    // A comparison gives -1 in the lanes where it is true, so the negative values are lowered by one
+    return truncated + (IntLanes)(x < __builtin_convertvector(truncated, FloatLanes));
+}
+
+/**
+ * @brief Hash the corners of the cells of the noise, each bit of the result is random.
+ */
+static inline UintLanes hashLanes(IntLanes x, IntLanes y, IntLanes z, uint32_t seed) {
+    UintLanes hash = (UintLanes)x * 0x8DA6B343u ^ (UintLanes)y * 0xD8163841u ^ (UintLanes)z * 0xCB1AB31Fu ^ seed;
+    hash ^= hash >> 13;
+    hash *= 0x5BD1E995u;
+    hash ^= hash >> 15;
+
+    return hash;
+}
+
+/**
+ * @brief Give to each lane the sign of a bit of the hash.
+ *
+ * @param value The values.
+ * @param hash The hash of the corner.
+ * @param bit The bit of the hash, the value is negated where it is set.
+ */
+static inline FloatLanes applySign(FloatLanes value, UintLanes hash, int bit) {
+    return (FloatLanes)((UintLanes)value ^ ((hash << (31 - bit)) & 0x80000000u));
+}
+
+/**
+ * @brief The quintic curve that smooths the interpolation between the corners.
+ */
+static inline FloatLanes fade(FloatLanes t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline FloatLanes lerp(FloatLanes a, FloatLanes b, FloatLanes t) {
+    return a + t * (b - a);
+}
+
+/**
+ * @brief 2D gradient noise, the gradients of the corners are diagonals.
+ *
+ * @return The noise of each lane, between about -1 and 1.
+ */
+static FloatLanes noise2D(FloatLanes x, FloatLanes y, uint32_t seed) {
+    const IntLanes cellX = floorLanes(x);
+    const IntLanes cellY = floorLanes(y);
+    const IntLanes zero = { 0 };
+    const FloatLanes dx = x - __builtin_convertvector(cellX, FloatLanes);
+    const FloatLanes dy = y - __builtin_convertvector(cellY, FloatLanes);
+
+    const UintLanes hash00 = hashLanes(cellX, cellY, zero, seed);
+    const UintLanes hash10 = hashLanes(cellX + 1, cellY, zero, seed);
+    const UintLanes hash01 = hashLanes(cellX, cellY + 1, zero, seed);
+    const UintLanes hash11 = hashLanes(cellX + 1, cellY + 1, zero, seed);
+
+    const FloatLanes dot00 = applySign(dx, hash00, 0) + applySign(dy, hash00, 1);
+    const FloatLanes dot10 = applySign(dx - 1.0f, hash10, 0) + applySign(dy, hash10, 1);
+    const FloatLanes dot01 = applySign(dx, hash01, 0) + applySign(dy - 1.0f, hash01, 1);
+    const FloatLanes dot11 = applySign(dx - 1.0f, hash11, 0) + applySign(dy - 1.0f, hash11, 1);
+
+    const FloatLanes u = fade(dx);
+    const FloatLanes v = fade(dy);
+
+    return lerp(lerp(dot00, dot10, u), lerp(dot01, dot11, u), v);
+}
+
+/**
+ * @brief 3D gradient noise, the gradients of the corners are diagonals.
+ *
+ * @return The noise of each lane, between about -1 and 1.
+ */
+static FloatLanes noise3D(FloatLanes x, FloatLanes y, FloatLanes z, uint32_t seed) {
+    const IntLanes cellX = floorLanes(x);
+    const IntLanes cellY = floorLanes(y);
+    const IntLanes cellZ = floorLanes(z);
+    const FloatLanes dx = x - __builtin_convertvector(cellX, FloatLanes);
+    const FloatLanes dy = y - __builtin_convertvector(cellY, FloatLanes);
+    const FloatLanes dz = z - __builtin_convertvector(cellZ, FloatLanes);
+
+    FloatLanes dots[8];
+    for (int corner = 0; corner != 8; corner++) {
+        const int offsetX = corner & 1;
+        const int offsetY = (corner >> 1) & 1;
+        const int offsetZ = (corner >> 2) & 1;
+        const UintLanes hash = hashLanes(cellX + offsetX, cellY + offsetY, cellZ + offsetZ, seed);
+
+        dots[corner] = applySign(dx - (float)offsetX, hash, 0)
+            + applySign(dy - (float)offsetY, hash, 1)
+            + applySign(dz - (float)offsetZ, hash, 2);
+    }
+
+    const FloatLanes u = fade(dx);
+    const FloatLanes v = fade(dy);
+    const FloatLanes w = fade(dz);
+
+    const FloatLanes bottom = lerp(lerp(dots[0], dots[1], u), lerp(dots[2], dots[3], u), v);
+    const FloatLanes top = lerp(lerp(dots[4], dots[5], u), lerp(dots[6], dots[7], u), v);
+
+    // The diagonal gradients reach 1.5 at most
+    return lerp(bottom, top, w) * (2.0f / 3.0f);
+}
+
+/**
+ * @brief Compute the height of the ground of each column of a world piece.
+ *
+ * @param piece The world piece.
+ * @param seed The seed of the world.
+ * @param heights Receives the number of solid cubes of each column.
+ */
+static void generateHeights(const HxfWorldPiece* restrict piece, uint32_t seed, int32_t heights[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE]) {
+    const FloatLanes zero = { 0 };
+
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        const FloatLanes worldX = zero + (float)(piece->position.x * HXF_WORLD_PIECE_SIZE + x);
+
+        // The lanes are consecutive cubes along z
+        for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z += NOISE_LANE_COUNT) {
+            const FloatLanes worldZ = LANE_INDICES + (float)(piece->position.z * HXF_WORLD_PIECE_SIZE + z);
+
+            FloatLanes sum = zero;
+            float frequency = GROUND_FREQUENCY;
+            float amplitude = 1.0f;
+            float amplitudeSum = 0.0f;
+
+            for (int octave = 0; octave != GROUND_OCTAVE_COUNT; octave++) {
+                sum += noise2D(worldX * frequency, worldZ * frequency, seed + octave) * amplitude;
+                amplitudeSum += amplitude;
+                frequency *= 2.0f;
+                amplitude *= 0.5f;
+            }
+
+            // From [-1, 1] to the heights of the ground
+            const FloatLanes height = (sum * (GROUND_CONTRAST / amplitudeSum) * 0.5f + 0.5f) * (float)(GROUND_MAX_HEIGHT - GROUND_MIN_HEIGHT) + (float)GROUND_MIN_HEIGHT;
+            const IntLanes cubeCount = __builtin_convertvector(height, IntLanes);
+
+            for (int i = 0; i != NOISE_LANE_COUNT; i++) {
+                const int32_t count = cubeCount[i];
+                heights[x][z + i] = count < GROUND_MIN_HEIGHT ? GROUND_MIN_HEIGHT : count > GROUND_MAX_HEIGHT ? GROUND_MAX_HEIGHT : count;
+            }
+        }
+    }
+}
+
+void hxfGenerateWorldPiece(HxfWorldPiece* restrict piece, uint32_t seed) {
+    int32_t heights[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE];
+    generateHeights(piece, seed, heights);
+
+    // Grass on top of a few dirt cubes, then stone
+
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
+            const int32_t height = heights[x][z];
+
+            for (int32_t y = 0; y != height - 1; y++) {
+                piece->block->cubes[x][y][z] = y < height - 1 - DIRT_DEPTH ? HXF_GENERATOR_STONE : 2;
+            }
+            piece->block->cubes[x][height - 1][z] = 1;
+        }
+    }
+
+    // The caves, the lowest cubes and the surface are kept so the caves neither go through the
+    // world nor leave holes in the ground
+
+    const FloatLanes zero = { 0 };
+
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        const FloatLanes worldX = zero + (float)(piece->position.x * HXF_WORLD_PIECE_SIZE + x) * CAVE_FREQUENCY;
+
+        for (int y = 1; y != HXF_WORLD_PIECE_SIZE; y++) {
+            const FloatLanes worldY = zero + (float)(piece->position.y * HXF_WORLD_PIECE_SIZE + y) * CAVE_VERTICAL_FREQUENCY;
+
+            for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z += NOISE_LANE_COUNT) {
+                const FloatLanes worldZ = (LANE_INDICES + (float)(piece->position.z * HXF_WORLD_PIECE_SIZE + z)) * CAVE_FREQUENCY;
+                const IntLanes isCave = noise3D(worldX, worldY, worldZ, ~seed) > CAVE_THRESHOLD;
+
+                for (int i = 0; i != NOISE_LANE_COUNT; i++) {
+                    if (isCave[i] && y < heights[x][z + i] - 2) {
+                        piece->block->cubes[x][y][z + i] = 0;
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+/**
+ * \file world-generator.h
+ * @brief The procedural terrain of the world pieces, made from the seed of the world.
+ */
+#pragma once
+
+#include "world.h"
+
+/**
+ * @brief The texture index of the cubes under the dirt.
+ */
+#define HXF_GENERATOR_STONE 3
+
+/**
+ * @brief Generate the cubes of a world piece from its position and the seed of the world.
+ *
+ * The height of the ground comes from several octaves of 2D gradient noise, and the caves from
+ * 3D gradient noise. The noise is evaluated for several cubes at once with the vector
+ * extensions of GCC and Clang, so it uses SSE, or AVX when the build enables it. The same seed
+ * and position always give the same cubes, and it can be called from several threads.
+ *
+ * @param piece The world piece, its position and its block must be set and its cubes must be air.
+ * @param seed The seed of the world.
+ */
+void hxfGenerateWorldPiece(HxfWorldPiece* restrict piece, uint32_t seed);
\ No newline at end of file
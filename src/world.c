@@ -1,5 +1,7 @@
 #include "world.h"
+#include "world-generator.h"
 #include "hxf.h"
+#include "profiler.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -8,6 +10,22 @@
 
 #define WORLD_PIECE_FILE_SIZE HXF_WORLD_PIECE_CUBE_COUNT * sizeof(uint32_t)
 
+/**
+ * @brief The start of a piece file that refers to a block file, it is followed by the hash of
+ * the block.
+ */
+#define WORLD_BLOCK_REFERENCE_MAGIC "HXFB"
+#define WORLD_BLOCK_REFERENCE_MAGIC_SIZE 4
+#define WORLD_BLOCK_REFERENCE_FILE_SIZE WORLD_BLOCK_REFERENCE_MAGIC_SIZE + sizeof(uint64_t)
+
+/**
+ * @brief The start of the file of a piece whose cubes all have the same texture, it is followed
+ * by the texture index.
+ */
+#define WORLD_UNIFORM_PIECE_MAGIC "HXFU"
+#define WORLD_UNIFORM_PIECE_MAGIC_SIZE 4
+#define WORLD_UNIFORM_PIECE_FILE_SIZE WORLD_UNIFORM_PIECE_MAGIC_SIZE + sizeof(uint32_t)
+
 #define WORLD_INFO_YAW_SIZE sizeof(float)
 #define WORLD_INFO_YAW_OFFSET 0
 
@@ -17,7 +35,24 @@
 #define WORLD_INFO_POSITON_SIZE sizeof(HxfVec3)
 #define WORLD_INFO_POSITION_OFFSET WORLD_INFO_PITCH_OFFSET + WORLD_INFO_PITCH_SIZE
 
-#define WORLD_INFO_FILE_SIZE WORLD_INFO_POSITION_OFFSET + WORLD_INFO_POSITON_SIZE
+#define WORLD_INFO_SEED_SIZE sizeof(uint32_t)
+#define WORLD_INFO_SEED_OFFSET WORLD_INFO_POSITION_OFFSET + WORLD_INFO_POSITON_SIZE
+
+/**
+ * @brief The size of the info files made before the terrain generator, they have no seed.
+ */
+#define WORLD_INFO_FLAT_FILE_SIZE WORLD_INFO_SEED_OFFSET
+#define WORLD_INFO_FILE_SIZE WORLD_INFO_SEED_OFFSET + WORLD_INFO_SEED_SIZE
+
+/**
+ * @brief The pieces loaded by the threads of a world.
+ */
+typedef struct PieceLoading {
+    const HxfWorld* world; ///< The world the pieces belong to.
+    const HxfIvec3* positions; ///< The position of each piece.
+    HxfWorldPiece** pieces; ///< Receives each piece.
+    double* generationDurations; ///< Receives the time spent generating each piece, a negative value if it was read from its file.
+} PieceLoading;
 
 /**
  * @brief Compare two HxfIvec3 and return true if they have the same values.
@@ -35,109 +70,474 @@ static int worldPieceMapCompareKey(const void* a, const void* b) {
 }
 
 /**
- * @brief Generate a single world piece.
+ * @brief Compare two block hashes and return true if they are the same.
+ *
+ * @param a uint64_t*
+ * @param b uint64_t*
+ *
+ * @return 1 if true, 0 otherwise.
+ */
+static int blockMapCompareKey(const void* a, const void* b) {
+    return *(const uint64_t*)a == *(const uint64_t*)b;
+}
+
+/**
+ * @brief Hash the cubes of a block, with FNV-1a on each cube rather than on each byte.
+ */
+static uint64_t hashBlock(const HxfWorldBlock* restrict block) {
+    const uint32_t* const cubes = &block->cubes[0][0][0];
+    uint64_t hash = 0xCBF29CE484222325u;
+
+    for (uint32_t i = 0; i != HXF_WORLD_PIECE_CUBE_COUNT; i++) {
+        hash = (hash ^ cubes[i]) * 0x100000001B3u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Make a loaded piece use the shared block that has the same cubes, or share its block
+ * if there is none yet.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece, its block is only used by it and its hash is up to date.
+ */
+static void shareBlock(HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    HxfWorldBlock* const block = piece->block;
+    HxfMapElement* const element = hxfMapGet(&world->blocks, &block->hash);
+
+    if (element == NULL) {
+        block->isShared = 1;
+        hxfMapSet(&world->blocks, &block->hash, block);
+    }
+    else {
+        HxfWorldBlock* const sharedBlock = element->value;
+
+        // Two different blocks can have the same hash, the block of the piece then stays its own
+        if (memcmp(sharedBlock->cubes, block->cubes, sizeof(block->cubes)) == 0) {
+            sharedBlock->refCount++;
+            sharedBlock->isFileSaved |= block->isFileSaved;
+            piece->block = sharedBlock;
+
+            hxfFree(block);
+            world->blockCount--;
+        }
+    }
+}
+
+/**
+ * @brief Stop using the block of a world piece, it is freed when no other piece uses it.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece, it must have a block.
+ */
+static void releaseBlock(HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    HxfWorldBlock* const block = piece->block;
+    block->refCount--;
+
+    if (block->refCount == 0) {
+        if (block->isShared) {
+            hxfMapRemove(&world->blocks, &block->hash);
+        }
+        hxfFree(block);
+        world->blockCount--;
+    }
+
+    piece->block = NULL;
+}
+
+/**
+ * @brief Make all the cubes of a loaded world piece the same, without a block.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece.
+ * @param textureIndex The texture index of the cubes.
+ */
+static void setPieceUniform(HxfWorld* restrict world, HxfWorldPiece* restrict piece, uint32_t textureIndex) {
+    if (piece->block != NULL) {
+        releaseBlock(world, piece);
+        world->uniformPieceCount++;
+    }
+    piece->uniformCube = textureIndex;
+}
+
+/**
+ * @brief Replace the block of a world piece by its texture if all its cubes are the same.
+ *
+ * @param piece The world piece, its block is only used by it.
+ */
+static void makePieceUniform(HxfWorldPiece* restrict piece) {
+    const uint32_t* const cubes = &piece->block->cubes[0][0][0];
+
+    for (uint32_t i = 1; i != HXF_WORLD_PIECE_CUBE_COUNT; i++) {
+        if (cubes[i] != cubes[0]) {
+            return;
+        }
+    }
+
+    piece->uniformCube = cubes[0];
+    hxfFree(piece->block);
+    piece->block = NULL;
+}
+
+/**
+ * @brief Remove a world piece from the world and free it, its block is freed when no other
+ * piece uses it.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece.
+ */
+static void freeWorldPiece(HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    hxfMapRemove(&world->pieces, &piece->position);
+
+    if (piece->block != NULL) {
+        releaseBlock(world, piece);
+    }
+    else {
+        world->uniformPieceCount--;
+    }
+
+    hxfFree(piece);
+    world->pieceCount--;
+}
+
+/**
+ * @brief Generate a single flat world piece, for the worlds made before the terrain generator.
  *
  * @param worldPiece A pointer to a world piece.
  */
-static void generateWorldPiece(HxfWorldPiece* restrict worldPiece) {
+static void generateFlatWorldPiece(HxfWorldPiece* restrict worldPiece) {
     for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
         for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
             for (int y = 0; y != 2; y++) {
-                worldPiece->cubes[x][y][z] = 2; // Dirt
+                worldPiece->block->cubes[x][y][z] = 2; // Dirt
             }
-            worldPiece->cubes[x][2][z] = 1; // Grass
+            worldPiece->block->cubes[x][2][z] = 1; // Grass
         }
     }
 }
 
 /**
- * @brief Load a world piece from file, from its position.
+ * @brief Write the path of the file of a world piece in the scratch arena.
  *
+ * @param worldDirectory The directory of the world.
  * @param position The position of the world piece inside the world.
+ * @param scratch The arena the path is allocated in, the caller resets it.
  *
- * @return A pointer to the world piece that is loaded.
+ * @return The path.
  */
-static HxfWorldPiece* loadWorldPiece(const char* restrict worldDirectory, const HxfIvec3* position) {
-    // Create a new world piece filled with air and with the given position
-
-    HxfWorldPiece* worldPiece = hxfCalloc(1, sizeof(HxfWorldPiece));
-    worldPiece->position = *position;
-
-    // Get the filename
-
+static char* getWorldPieceFilename(const char* restrict worldDirectory, const HxfIvec3* restrict position, HxfArena* restrict scratch) {
     int size = strlen(worldDirectory);
-    char* filename = hxfMalloc(sizeof(char) * (size + 31)); // 10 characters for each world coordinates
+    char* filename = hxfArenaAlloc(scratch, sizeof(char) * (size + 31)); // 10 characters for each world coordinates
     memcpy(filename, worldDirectory, size);
     sprintf(filename + size, "/%i_%i_%i", position->x, position->y, position->z);
 
-    // Open the file for reading
+    return filename;
+}
 
-    char filecontent[WORLD_PIECE_FILE_SIZE] = { 0 };
-    FILE* file = fopen(filename, "rb");
+/**
+ * @brief Write the path of a block file in the scratch arena.
+ *
+ * @param worldDirectory The directory of the world.
+ * @param hash The hash of the cubes of the block.
+ * @param scratch The arena the path is allocated in, the caller resets it.
+ *
+ * @return The path.
+ */
+static char* getBlockFilename(const char* restrict worldDirectory, uint64_t hash, HxfArena* restrict scratch) {
+    int size = strlen(worldDirectory);
+    char* filename = hxfArenaAlloc(scratch, sizeof(char) * (size + sizeof(HXF_WORLD_BLOCK_FILE_PREFIX) + 17)); // 16 hexadecimal digits
+    memcpy(filename, worldDirectory, size);
+    sprintf(filename + size, "/" HXF_WORLD_BLOCK_FILE_PREFIX "%016llx", (unsigned long long)hash);
 
-    // If the file exist load it
+    return filename;
+}
 
-    if (file) {
-        fread(filecontent, sizeof(char), WORLD_PIECE_FILE_SIZE, file);
-        fclose(file);
+/**
+ * @brief Copy the cubes of the content of a piece file or of a block file.
+ *
+ * @param filecontent The content of the file.
+ * @param block The block that receives the cubes.
+ */
+static void readCubes(const char* restrict filecontent, HxfWorldBlock* restrict block) {
+    const uint32_t* cubes = (const uint32_t*)filecontent;
+
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
+            for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
+                block->cubes[x][y][z] = cubes[x * HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE + y * HXF_WORLD_PIECE_SIZE + z];
+            }
+        }
+    }
+}
 
-        uint32_t* cubes = (uint32_t*)filecontent;
+/**
+ * @brief Write the cubes of a piece file or of a block file.
+ *
+ * @param file The file.
+ * @param block The block that has the cubes.
+ */
+static void writeCubes(FILE* restrict file, const HxfWorldBlock* restrict block) {
+    char filecontent[WORLD_PIECE_FILE_SIZE] = { 0 };
+    uint32_t* cubes = (uint32_t*)filecontent;
 
-        for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
-            for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
-                for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
-                    worldPiece->cubes[x][y][z] = cubes[x * HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE + y * HXF_WORLD_PIECE_SIZE + z];
-                }
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
+            for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
+                cubes[x * HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE + y * HXF_WORLD_PIECE_SIZE + z] = block->cubes[x][y][z];
             }
         }
     }
+
+    fwrite(filecontent, sizeof(char), sizeof(filecontent), file);
+}
+
+/**
+ * @brief Set a row of cubes to a texture index.
+ *
+ * @param cubes The first cube of the row.
+ * @param count The number of cubes.
+ * @param textureIndex The texture index to set.
+ */
+static void fillCubes(uint32_t* restrict cubes, int32_t count, uint32_t textureIndex) {
+    if (textureIndex == 0) {
+        memset(cubes, 0, sizeof(uint32_t) * count);
+    }
+    else {
+        for (int32_t i = 0; i != count; i++) {
+            cubes[i] = textureIndex;
+        }
+    }
+}
+
+/**
+ * @brief Load a world piece from file, from its position, or generate it if it was never saved.
+ *
+ * @param world The world the piece belongs to.
+ * @param position The position of the world piece inside the world.
+ * @param generationDuration Receives the time spent generating the piece, a negative value if it was read from its file.
+ *
+ * @return A pointer to the world piece that is loaded.
+ */
+static HxfWorldPiece* loadWorldPiece(const HxfWorld* restrict world, const HxfIvec3* position, double* generationDuration) {
+    // Create a new world piece filled with air and with the given position
+
+    HxfWorldPiece* worldPiece = hxfCalloc(1, sizeof(HxfWorldPiece), HXF_ALLOC_WORLD);
+    worldPiece->position = *position;
+    worldPiece->block = hxfCalloc(1, sizeof(HxfWorldBlock), HXF_ALLOC_WORLD);
+    worldPiece->block->refCount = 1;
+
+    const HxfResult result = hxfWorldReadPiece(world, worldPiece);
+    if (result == HXF_SUCCESS) {
+        *generationDuration = -1.0;
+    }
+    // Generating the piece again would lose its changes when it is saved
+    else if (result == HXF_MISSING_FILE_ERROR) {
+        HXF_FATAL("The block file of the world piece %i_%i_%i is missing", position->x, position->y, position->z);
+    }
     // Else generate the world piece
     else {
-        generateWorldPiece(worldPiece);
+        const double startTime = hxfGetTime();
+        hxfWorldGeneratePiece(world, worldPiece);
+        *generationDuration = hxfGetTime() - startTime;
     }
 
-    hxfFree(filename);
+    makePieceUniform(worldPiece);
+
+    // The hash of a block read from its block file is already computed
+    if (worldPiece->block != NULL && !worldPiece->block->isFileSaved) {
+        worldPiece->block->hash = hashBlock(worldPiece->block);
+    }
 
     return worldPiece;
 }
 
+/**
+ * @brief Generate a world piece and save it if it was never saved, it is run by the threads of
+ * the world for hxfWorldGenerateRegion.
+ *
+ * @param userData A pointer to the PieceLoading, only its world, positions and generationDurations are used.
+ * @param taskIndex The index of the piece.
+ */
+static void generateWorldPieceTask(void* userData, uint32_t taskIndex) {
+    PieceLoading* const loading = userData;
+    const HxfWorld* const world = loading->world;
+
+    HxfWorldPiece* const piece = hxfCalloc(1, sizeof(HxfWorldPiece), HXF_ALLOC_WORLD);
+    piece->position = loading->positions[taskIndex];
+    piece->block = hxfCalloc(1, sizeof(HxfWorldBlock), HXF_ALLOC_WORLD);
+    piece->block->refCount = 1;
+
+    // Only the existence of the file is checked, its cubes are not read
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    FILE* const file = fopen(getWorldPieceFilename(world->directoryPath, &piece->position, scratch), "rb");
+    hxfArenaReset(scratch, scratchMark);
+
+    if (file != NULL) {
+        fclose(file);
+        loading->generationDurations[taskIndex] = -1.0;
+    }
+    else {
+        const double startTime = hxfGetTime();
+        hxfWorldGeneratePiece(world, piece);
+        loading->generationDurations[taskIndex] = hxfGetTime() - startTime;
+
+        makePieceUniform(piece);
+        hxfWorldWritePiece(world, piece);
+    }
+
+    hxfFree(piece->block);
+    hxfFree(piece);
+}
+
+/**
+ * @brief Load a world piece, it is run by the threads of the world.
+ *
+ * @param userData A pointer to the PieceLoading.
+ * @param taskIndex The index of the piece.
+ */
+static void loadWorldPieceTask(void* userData, uint32_t taskIndex) {
+    HXF_ZONE("world.loadPiece");
+
+    PieceLoading* const loading = userData;
+    loading->pieces[taskIndex] = loadWorldPiece(loading->world, &loading->positions[taskIndex], &loading->generationDurations[taskIndex]);
+}
+
+/**
+ * @brief Load several world pieces with the threads of the world and add them to it.
+ *
+ * @param world The world.
+ * @param positions The position of each piece, they must not be loaded yet.
+ * @param count The number of pieces.
+ */
+static void loadWorldPieces(HxfWorld* restrict world, const HxfIvec3* positions, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    PieceLoading loading = {
+        .world = world,
+        .positions = positions,
+        .pieces = hxfArenaAlloc(scratch, sizeof(HxfWorldPiece*) * count),
+        .generationDurations = hxfArenaAlloc(scratch, sizeof(double) * count),
+    };
+
+    hxfThreadPoolRun(&world->threadPool, loadWorldPieceTask, &loading, count);
+
+    // The maps are only changed by the calling thread
+    for (uint32_t i = 0; i != count; i++) {
+        hxfMapSet(&world->pieces, &loading.pieces[i]->position, loading.pieces[i]);
+        world->pieceCount++;
+
+        if (loading.pieces[i]->block != NULL) {
+            world->blockCount++;
+            shareBlock(world, loading.pieces[i]);
+        }
+        else {
+            world->uniformPieceCount++;
+        }
+
+        if (loading.generationDurations[i] >= 0.0) {
+            world->generatedPieceCount++;
+            world->generationDuration += loading.generationDurations[i];
+        }
+    }
+
+    hxfArenaReset(scratch, scratchMark);
+}
+
+/**
+ * @brief Write the block file of a block, unless a block file with the same name already exists.
+ *
+ * The hash names the block file, so an existing block file may have other cubes. The block is
+ * then not marked as saved, and its pieces keep their cubes in their own file.
+ *
+ * @param block The block.
+ * @param worldDirectory The path to the directory of the world.
+ */
+static void saveBlockFile(HxfWorldBlock* restrict block, const char* restrict worldDirectory) {
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    const char* const filename = getBlockFilename(worldDirectory, block->hash, scratch);
+
+    FILE* blockFile = fopen(filename, "rb");
+    if (blockFile != NULL) {
+        char filecontent[WORLD_PIECE_FILE_SIZE] = { 0 };
+        fread(filecontent, sizeof(char), WORLD_PIECE_FILE_SIZE, blockFile);
+        fclose(blockFile);
+
+        HxfWorldBlock savedBlock;
+        readCubes(filecontent, &savedBlock);
+        block->isFileSaved = memcmp(savedBlock.cubes, block->cubes, sizeof(block->cubes)) == 0;
+    }
+    else {
+        blockFile = fopen(filename, "wb");
+        if (blockFile == NULL) { HXF_FATAL("Could not save the world"); }
+
+        writeCubes(blockFile, block);
+        fclose(blockFile);
+        block->isFileSaved = 1;
+    }
+
+    hxfArenaReset(scratch, scratchMark);
+}
+
 static void saveWorldPiece(const HxfWorldPiece* restrict worldPiece, const char* restrict worldDirectory) {
     // Get the filename
 
-    int size = strlen(worldDirectory);
-    char* filename = hxfMalloc(sizeof(char) * (size + 31)); // 10 characters for each world coordinates
-    memcpy(filename, worldDirectory, size);
-    sprintf(filename + size, "/%i_%i_%i", worldPiece->position.x, worldPiece->position.y, worldPiece->position.z);
-
-    // Write the world piece to the buffer
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    char* filename = getWorldPieceFilename(worldDirectory, &worldPiece->position, scratch);
 
-    char filecontent[WORLD_PIECE_FILE_SIZE] = { 0 };
     FILE* file = fopen(filename, "wb");
     if (file == NULL) { HXF_FATAL("Could not save the world"); }
 
-    uint32_t* cubes = (uint32_t*)filecontent;
+    // A uniform piece only has its texture
 
-    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
-        for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
-            for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
-                cubes[x * HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE + y * HXF_WORLD_PIECE_SIZE + z] = worldPiece->cubes[x][y][z];
-            }
-        }
+    HxfWorldBlock* const block = worldPiece->block;
+    if (block == NULL) {
+        char filecontent[WORLD_UNIFORM_PIECE_FILE_SIZE];
+        memcpy(filecontent, WORLD_UNIFORM_PIECE_MAGIC, WORLD_UNIFORM_PIECE_MAGIC_SIZE);
+        memcpy(filecontent + WORLD_UNIFORM_PIECE_MAGIC_SIZE, &worldPiece->uniformCube, sizeof(uint32_t));
+
+        fwrite(filecontent, sizeof(char), sizeof(filecontent), file);
+        fclose(file);
+        hxfArenaReset(scratch, scratchMark);
+        return;
     }
 
-    // Write the buffer to the file
+    // The cubes of a block used by several pieces are written once in a block file, that the
+    // file of each piece refers to
 
-    fwrite(filecontent, sizeof(char), sizeof(filecontent), file);
+    if (block->isShared && block->refCount > 1 && !block->isFileSaved) {
+        saveBlockFile(block, worldDirectory);
+    }
+
+    if (block->isFileSaved) {
+        char filecontent[WORLD_BLOCK_REFERENCE_FILE_SIZE];
+        memcpy(filecontent, WORLD_BLOCK_REFERENCE_MAGIC, WORLD_BLOCK_REFERENCE_MAGIC_SIZE);
+        memcpy(filecontent + WORLD_BLOCK_REFERENCE_MAGIC_SIZE, &block->hash, sizeof(uint64_t));
+
+        fwrite(filecontent, sizeof(char), sizeof(filecontent), file);
+    }
+    else {
+        writeCubes(file, block);
+    }
 
     fclose(file);
-    hxfFree(filename);
+    hxfArenaReset(scratch, scratchMark);
 }
 
 static void loadWorldInfo(HxfWorldSaveData* restrict data) {
     // Get the filename
 
     int size = strlen(data->world->directoryPath);
-    char* filename = hxfMalloc(sizeof(char) * (size + 31)); // 10 characters for each world coordinates
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    char* filename = hxfArenaAlloc(scratch, sizeof(char) * (size + 31)); // 10 characters for each world coordinates
     memcpy(filename, data->world->directoryPath, size);
     memcpy(filename + size, "/info", 6);
 
@@ -145,9 +545,17 @@ static void loadWorldInfo(HxfWorldSaveData* restrict data) {
 
     FILE* file = fopen(filename, "rb");
     if (file) { // If the file exists load it
-        fread(filecontent, sizeof(char), WORLD_INFO_FILE_SIZE, file);
+        const size_t readSize = fread(filecontent, sizeof(char), WORLD_INFO_FILE_SIZE, file);
         fclose(file);
 
+        // The worlds made before the terrain generator have no seed, they stay flat
+        if (readSize < WORLD_INFO_FILE_SIZE) {
+            data->world->isFlat = 1;
+        }
+        else {
+            data->world->seed = *(uint32_t*)(filecontent + WORLD_INFO_SEED_OFFSET);
+        }
+
         float* const fileYaw = (float*)(filecontent + WORLD_INFO_YAW_OFFSET);
         float* const filePitch = (float*)(filecontent + WORLD_INFO_PITCH_OFFSET);
         HxfVec3* const filePosition = (HxfVec3*)(filecontent + WORLD_INFO_POSITION_OFFSET);
@@ -164,14 +572,16 @@ static void loadWorldInfo(HxfWorldSaveData* restrict data) {
         data->cameraPosition->z = 0;
     }
 
-    hxfFree(filename);
+    hxfArenaReset(scratch, scratchMark);
 }
 
 static void saveWorldInfo(HxfWorldSaveData* restrict data) {
     // Get the filename
 
     int size = strlen(data->world->directoryPath);
-    char* filename = hxfMalloc(sizeof(char) * (size + 31)); // 10 characters for each world coordinates
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    char* filename = hxfArenaAlloc(scratch, sizeof(char) * (size + 31)); // 10 characters for each world coordinates
     memcpy(filename, data->world->directoryPath, size);
     memcpy(filename + size, "/info", 6);
 
@@ -185,16 +595,55 @@ static void saveWorldInfo(HxfWorldSaveData* restrict data) {
     float* fileYaw = (float*)(filecontent + WORLD_INFO_YAW_OFFSET);
     float* pitchFile = (float*)(filecontent + WORLD_INFO_PITCH_OFFSET);
     HxfVec3* positionFile = (HxfVec3*)(filecontent + WORLD_INFO_POSITION_OFFSET);
+    uint32_t* seedFile = (uint32_t*)(filecontent + WORLD_INFO_SEED_OFFSET);
 
     *fileYaw = *data->cameraYaw;
     *pitchFile = *data->cameraPitch;
     *positionFile = *data->cameraPosition;
+    *seedFile = data->world->seed;
 
-    // Write the buffer to the file
+    // Write the buffer to the file, without the seed for a flat world so that it stays flat
 
-    fwrite(filecontent, sizeof(char), WORLD_INFO_FILE_SIZE, file);
+    fwrite(filecontent, sizeof(char), data->world->isFlat ? WORLD_INFO_FLAT_FILE_SIZE : WORLD_INFO_FILE_SIZE, file);
     fclose(file);
-    hxfFree(filename);
+    hxfArenaReset(scratch, scratchMark);
+}
+
+/**
+ * @brief Get the cubes of a world piece that are inside a box.
+ *
+ * @param piece The world piece.
+ * @param min The cube of the box with the lowest coordinates.
+ * @param max The cube of the box with the highest coordinates, it is included in the box.
+ * @param localMin Receives the first cube of the piece inside the box.
+ * @param localMax Receives the last cube of the piece inside the box.
+ *
+ * @return 1 if some cubes of the piece are inside the box, 0 otherwise.
+ */
+static int getPieceOverlap(const HxfWorldPiece* restrict piece, const HxfIvec3* restrict min, const HxfIvec3* restrict max, HxfIvec3* restrict localMin, HxfIvec3* restrict localMax) {
+    const int32_t pieceMin[3] = {
+        piece->position.x * HXF_WORLD_PIECE_SIZE,
+        piece->position.y * HXF_WORLD_PIECE_SIZE,
+        piece->position.z * HXF_WORLD_PIECE_SIZE
+    };
+    const int32_t boxMin[3] = { min->x, min->y, min->z };
+    const int32_t boxMax[3] = { max->x, max->y, max->z };
+    int32_t first[3];
+    int32_t last[3];
+
+    for (int i = 0; i != 3; i++) {
+        first[i] = boxMin[i] > pieceMin[i] ? boxMin[i] - pieceMin[i] : 0;
+        last[i] = boxMax[i] < pieceMin[i] + HXF_WORLD_PIECE_SIZE - 1 ? boxMax[i] - pieceMin[i] : HXF_WORLD_PIECE_SIZE - 1;
+
+        if (first[i] > last[i]) {
+            return 0;
+        }
+    }
+
+    *localMin = (HxfIvec3){ first[0], first[1], first[2] };
+    *localMax = (HxfIvec3){ last[0], last[1], last[2] };
+
+    return 1;
 }
 
 HxfIvec3 hxfWorldGetPiecePositionF(const HxfVec3* restrict globalPosition) {
@@ -265,13 +714,487 @@ HxfIvec3 hxfWorldGetLocalPosition(const HxfIvec3* restrict globalPosition) {
     return localPosition;
 }
 
-void hxfWorldLoad(HxfWorldSaveData* restrict data) {
+uint16_t hxfWorldGetSidesBit(int sideA, int sideB) {
+    if (sideA > sideB) {
+        const int side = sideA;
+        sideA = sideB;
+        sideB = side;
+    }
+
+    // The pairs are numbered in order: (0, 1) ... (0, 5), (1, 2) ... (4, 5)
+    return 1 << (sideA * (2 * HXF_WORLD_PIECE_SIDE_COUNT - 1 - sideA) / 2 + sideB - sideA - 1);
+}
+
+uint16_t hxfWorldGetPieceConnectivity(const HxfWorldPiece* restrict piece) {
+    if (piece->block == NULL) {
+        return piece->uniformCube == 0 ? HXF_WORLD_PIECE_FULLY_CONNECTED : 0;
+    }
+
+    const int last = HXF_WORLD_PIECE_SIZE - 1;
+    uint8_t isVisited[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE] = { 0 };
+    HxfIvec3 stack[HXF_WORLD_PIECE_CUBE_COUNT]; // Each cube is pushed at most once
+    uint16_t connectivity = 0;
+
+    // Flood fill each air region and connect all the sides it touches
+
+    for (int x = 0; x != HXF_WORLD_PIECE_SIZE; x++) {
+        for (int y = 0; y != HXF_WORLD_PIECE_SIZE; y++) {
+            for (int z = 0; z != HXF_WORLD_PIECE_SIZE; z++) {
+                if (piece->block->cubes[x][y][z] != 0 || isVisited[x][y][z]) {
+                    continue;
+                }
+
+                int stackSize = 1;
+                stack[0] = (HxfIvec3){ x, y, z };
+                isVisited[x][y][z] = 1;
+                uint32_t sides = 0;
+
+                while (stackSize != 0) {
+                    const HxfIvec3 cube = stack[--stackSize];
+
+                    if (cube.y == last) sides |= 1 << 0; // Top
+                    if (cube.z == 0) sides |= 1 << 1;    // Back
+                    if (cube.y == 0) sides |= 1 << 2;    // Bottom
+                    if (cube.z == last) sides |= 1 << 3; // Front
+                    if (cube.x == last) sides |= 1 << 4; // Right
+                    if (cube.x == 0) sides |= 1 << 5;    // Left
+
+                    const HxfIvec3 neighbors[] = {
+                        { cube.x, cube.y + 1, cube.z },
+                        { cube.x, cube.y, cube.z - 1 },
+                        { cube.x, cube.y - 1, cube.z },
+                        { cube.x, cube.y, cube.z + 1 },
+                        { cube.x + 1, cube.y, cube.z },
+                        { cube.x - 1, cube.y, cube.z }
+                    };
+
+                    for (int i = 0; i != HXF_WORLD_PIECE_SIDE_COUNT; i++) {
+                        const HxfIvec3* const neighbor = &neighbors[i];
+
+                        if (neighbor->x >= 0 && neighbor->x <= last
+                            && neighbor->y >= 0 && neighbor->y <= last
+                            && neighbor->z >= 0 && neighbor->z <= last
+                            && piece->block->cubes[neighbor->x][neighbor->y][neighbor->z] == 0
+                            && !isVisited[neighbor->x][neighbor->y][neighbor->z]) {
+                            isVisited[neighbor->x][neighbor->y][neighbor->z] = 1;
+                            stack[stackSize++] = *neighbor;
+                        }
+                    }
+                }
+
+                for (int sideA = 0; sideA != HXF_WORLD_PIECE_SIDE_COUNT; sideA++) {
+                    for (int sideB = sideA + 1; sideB != HXF_WORLD_PIECE_SIDE_COUNT; sideB++) {
+                        if ((sides & (1 << sideA)) && (sides & (1 << sideB))) {
+                            connectivity |= hxfWorldGetSidesBit(sideA, sideB);
+                        }
+                    }
+                }
+
+                if (connectivity == HXF_WORLD_PIECE_FULLY_CONNECTED) {
+                    return connectivity;
+                }
+            }
+        }
+    }
+
+    return connectivity;
+}
+
+void hxfWorldDownsamplePiece(const HxfWorldPiece* restrict piece, uint32_t level, uint32_t cubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE]) {
+    const int width = 1 << level; // The number of cubes of the piece covered in each dimension
+    const int cubeCount = HXF_WORLD_PIECE_SIZE >> level;
+
+    if (piece->block == NULL) {
+        for (int x = 0; x != cubeCount; x++) {
+            for (int y = 0; y != cubeCount; y++) {
+                fillCubes(cubes[x][y], cubeCount, piece->uniformCube);
+            }
+        }
+        return;
+    }
+
+    for (int x = 0; x != cubeCount; x++) {
+        for (int y = 0; y != cubeCount; y++) {
+            for (int z = 0; z != cubeCount; z++) {
+                int solidCount = 0;
+                uint32_t texture = 0;
+
+                // From the top, so the first solid cube found is the highest one
+                for (int j = width - 1; j != -1; j--) {
+                    for (int i = 0; i != width; i++) {
+                        for (int k = 0; k != width; k++) {
+                            const uint32_t cube = piece->block->cubes[x * width + i][y * width + j][z * width + k];
+
+                            if (cube != 0) {
+                                if (texture == 0) {
+                                    texture = cube;
+                                }
+                                solidCount++;
+                            }
+                        }
+                    }
+                }
+
+                cubes[x][y][z] = 2 * solidCount >= width * width * width ? texture : 0;
+            }
+        }
+    }
+}
+
+uint32_t hxfWorldFill(HxfWorld* restrict world, const HxfIvec3* restrict min, const HxfIvec3* restrict max, uint32_t textureIndex) {
+    uint32_t changedPieceCount = 0;
+
+    for (HxfMapElement* iterator = world->pieces.start; iterator != NULL; iterator = iterator->next) {
+        HxfWorldPiece* const piece = (HxfWorldPiece*)iterator->value;
+        HxfIvec3 localMin;
+        HxfIvec3 localMax;
+
+        if (piece->block == NULL && piece->uniformCube == textureIndex) {
+            continue;
+        }
+
+        if (getPieceOverlap(piece, min, max, &localMin, &localMax)) {
+            const int last = HXF_WORLD_PIECE_SIZE - 1;
+
+            // A piece inside the box does not need its cubes
+            if (localMin.x == 0 && localMin.y == 0 && localMin.z == 0 && localMax.x == last && localMax.y == last && localMax.z == last) {
+                setPieceUniform(world, piece, textureIndex);
+                changedPieceCount++;
+                continue;
+            }
+
+            HxfWorldBlock* const block = hxfWorldGetWritableBlock(world, piece);
+
+            for (int32_t x = localMin.x; x <= localMax.x; x++) {
+                for (int32_t y = localMin.y; y <= localMax.y; y++) {
+                    fillCubes(&block->cubes[x][y][localMin.z], localMax.z - localMin.z + 1, textureIndex);
+                }
+            }
+            changedPieceCount++;
+        }
+    }
+
+    return changedPieceCount;
+}
+
+uint32_t hxfWorldCarveSphere(HxfWorld* restrict world, const HxfVec3* restrict center, float radius) {
+    const HxfIvec3 min = {
+        (int32_t)ceilf(center->x - radius),
+        (int32_t)ceilf(center->y - radius),
+        (int32_t)ceilf(center->z - radius)
+    };
+    const HxfIvec3 max = {
+        (int32_t)floorf(center->x + radius),
+        (int32_t)floorf(center->y + radius),
+        (int32_t)floorf(center->z + radius)
+    };
+    uint32_t changedPieceCount = 0;
+
+    for (HxfMapElement* iterator = world->pieces.start; iterator != NULL; iterator = iterator->next) {
+        HxfWorldPiece* const piece = (HxfWorldPiece*)iterator->value;
+        HxfIvec3 localMin;
+        HxfIvec3 localMax;
+
+        // A piece of air stays the same
+        if (piece->block == NULL && piece->uniformCube == 0) {
+            continue;
+        }
+
+        if (getPieceOverlap(piece, &min, &max, &localMin, &localMax)) {
+            const HxfIvec3 pieceOrigin = {
+                piece->position.x * HXF_WORLD_PIECE_SIZE,
+                piece->position.y * HXF_WORLD_PIECE_SIZE,
+                piece->position.z * HXF_WORLD_PIECE_SIZE
+            };
+            HxfWorldBlock* block = NULL; // Only taken once a cube is inside the sphere, as it can copy the block
+
+            // Each row along z crosses the sphere in a single span of cubes
+            for (int32_t x = localMin.x; x <= localMax.x; x++) {
+                for (int32_t y = localMin.y; y <= localMax.y; y++) {
+                    const float dx = (float)(pieceOrigin.x + x) - center->x;
+                    const float dy = (float)(pieceOrigin.y + y) - center->y;
+                    const float remaining = radius * radius - dx * dx - dy * dy;
+
+                    if (remaining < 0.0f) {
+                        continue;
+                    }
+
+                    const float halfLength = sqrtf(remaining);
+                    int32_t first = (int32_t)ceilf(center->z - halfLength) - pieceOrigin.z;
+                    int32_t last = (int32_t)floorf(center->z + halfLength) - pieceOrigin.z;
+                    if (first < localMin.z) first = localMin.z;
+                    if (last > localMax.z) last = localMax.z;
+
+                    if (first <= last) {
+                        if (block == NULL) {
+                            block = hxfWorldGetWritableBlock(world, piece);
+                        }
+                        fillCubes(&block->cubes[x][y][first], last - first + 1, 0);
+                    }
+                }
+            }
+
+            if (block != NULL) {
+                changedPieceCount++;
+            }
+        }
+    }
+
+    return changedPieceCount;
+}
+
+uint32_t hxfWorldPaste(HxfWorld* restrict world, const HxfWorldStructure* restrict structure, const HxfIvec3* restrict position) {
+    if (structure->size.x <= 0 || structure->size.y <= 0 || structure->size.z <= 0) {
+        return 0;
+    }
+
+    const HxfIvec3 max = {
+        position->x + structure->size.x - 1,
+        position->y + structure->size.y - 1,
+        position->z + structure->size.z - 1
+    };
+    uint32_t changedPieceCount = 0;
+
+    for (HxfMapElement* iterator = world->pieces.start; iterator != NULL; iterator = iterator->next) {
+        HxfWorldPiece* const piece = (HxfWorldPiece*)iterator->value;
+        HxfIvec3 localMin;
+        HxfIvec3 localMax;
+
+        if (getPieceOverlap(piece, position, &max, &localMin, &localMax)) {
+            // The position of the first cube of the piece inside the structure
+            const HxfIvec3 structureOffset = {
+                piece->position.x * HXF_WORLD_PIECE_SIZE - position->x,
+                piece->position.y * HXF_WORLD_PIECE_SIZE - position->y,
+                piece->position.z * HXF_WORLD_PIECE_SIZE - position->z
+            };
+            HxfWorldBlock* const block = hxfWorldGetWritableBlock(world, piece);
+
+            for (int32_t x = localMin.x; x <= localMax.x; x++) {
+                for (int32_t y = localMin.y; y <= localMax.y; y++) {
+                    const size_t rowIndex = ((size_t)(structureOffset.x + x) * structure->size.y + (structureOffset.y + y)) * structure->size.z
+                        + (structureOffset.z + localMin.z);
+                    memcpy(&block->cubes[x][y][localMin.z], &structure->cubes[rowIndex], sizeof(uint32_t) * (localMax.z - localMin.z + 1));
+                }
+            }
+            changedPieceCount++;
+        }
+    }
+
+    return changedPieceCount;
+}
+
+HxfWorldBlock* hxfWorldGetWritableBlock(HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    HxfWorldBlock* block = piece->block;
+
+    if (block == NULL) {
+        // The uniform piece gets back its cubes
+        block = hxfMalloc(sizeof(HxfWorldBlock), HXF_ALLOC_WORLD);
+        fillCubes(&block->cubes[0][0][0], HXF_WORLD_PIECE_CUBE_COUNT, piece->uniformCube);
+        block->refCount = 1;
+        block->isShared = 0;
+
+        piece->block = block;
+        world->blockCount++;
+        world->uniformPieceCount--;
+    }
+    else if (block->refCount > 1) {
+        // Copy on write, the other pieces keep the shared block
+        HxfWorldBlock* const copy = hxfMalloc(sizeof(HxfWorldBlock), HXF_ALLOC_WORLD);
+        memcpy(copy->cubes, block->cubes, sizeof(block->cubes));
+        copy->refCount = 1;
+        copy->isShared = 0;
+
+        block->refCount--;
+        piece->block = copy;
+        world->blockCount++;
+        block = copy;
+    }
+    else if (block->isShared) {
+        // Its hash will not match its cubes anymore
+        hxfMapRemove(&world->blocks, &block->hash);
+        block->isShared = 0;
+    }
+
+    block->isFileSaved = 0;
+
+    return block;
+}
+
+HxfResult hxfWorldReadPiece(const HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    FILE* file = fopen(getWorldPieceFilename(world->directoryPath, &piece->position, scratch), "rb");
+    hxfArenaReset(scratch, scratchMark);
+
+    if (file == NULL) {
+        return HXF_ERROR;
+    }
+
+    char filecontent[WORLD_PIECE_FILE_SIZE] = { 0 };
+    const size_t readSize = fread(filecontent, sizeof(char), WORLD_PIECE_FILE_SIZE, file);
+    fclose(file);
+
+    if (readSize == WORLD_UNIFORM_PIECE_FILE_SIZE
+        && memcmp(filecontent, WORLD_UNIFORM_PIECE_MAGIC, WORLD_UNIFORM_PIECE_MAGIC_SIZE) == 0) {
+        uint32_t textureIndex;
+        memcpy(&textureIndex, filecontent + WORLD_UNIFORM_PIECE_MAGIC_SIZE, sizeof(uint32_t));
+        fillCubes(&piece->block->cubes[0][0][0], HXF_WORLD_PIECE_CUBE_COUNT, textureIndex);
+
+        return HXF_SUCCESS;
+    }
+    if (readSize != WORLD_BLOCK_REFERENCE_FILE_SIZE
+        || memcmp(filecontent, WORLD_BLOCK_REFERENCE_MAGIC, WORLD_BLOCK_REFERENCE_MAGIC_SIZE) != 0) {
+        readCubes(filecontent, piece->block);
+
+        return HXF_SUCCESS;
+    }
+
+    // The piece file refers to a block file
+
+    uint64_t hash;
+    memcpy(&hash, filecontent + WORLD_BLOCK_REFERENCE_MAGIC_SIZE, sizeof(uint64_t));
+
+    FILE* blockFile = fopen(getBlockFilename(world->directoryPath, hash, scratch), "rb");
+    hxfArenaReset(scratch, scratchMark);
+
+    if (blockFile == NULL) {
+        return HXF_MISSING_FILE_ERROR;
+    }
+
+    memset(filecontent, 0, sizeof(filecontent));
+    fread(filecontent, sizeof(char), WORLD_PIECE_FILE_SIZE, blockFile);
+    fclose(blockFile);
+
+    readCubes(filecontent, piece->block);
+
+    // A block file that was changed is written again with its new hash
+    piece->block->hash = hashBlock(piece->block);
+    piece->block->isFileSaved = piece->block->hash == hash;
+
+    return HXF_SUCCESS;
+}
+
+HxfResult hxfWorldGetPieceBlockHash(const HxfWorld* restrict world, const HxfIvec3* restrict position, uint64_t* restrict hash) {
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    FILE* file = fopen(getWorldPieceFilename(world->directoryPath, position, scratch), "rb");
+    hxfArenaReset(scratch, scratchMark);
+
+    if (file == NULL) {
+        return HXF_ERROR;
+    }
+
+    // One more byte than a reference tells it from a piece file that has its cubes
+    char filecontent[WORLD_BLOCK_REFERENCE_FILE_SIZE + 1];
+    const size_t readSize = fread(filecontent, sizeof(char), sizeof(filecontent), file);
+    fclose(file);
+
+    if (readSize != WORLD_BLOCK_REFERENCE_FILE_SIZE
+        || memcmp(filecontent, WORLD_BLOCK_REFERENCE_MAGIC, WORLD_BLOCK_REFERENCE_MAGIC_SIZE) != 0) {
+        return HXF_ERROR;
+    }
+
+    memcpy(hash, filecontent + WORLD_BLOCK_REFERENCE_MAGIC_SIZE, sizeof(uint64_t));
+
+    return HXF_SUCCESS;
+}
+
+HxfResult hxfWorldGetPieceUniformCube(const HxfWorld* restrict world, const HxfIvec3* restrict position, uint32_t* restrict textureIndex) {
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    FILE* file = fopen(getWorldPieceFilename(world->directoryPath, position, scratch), "rb");
+    hxfArenaReset(scratch, scratchMark);
+
+    if (file == NULL) {
+        return HXF_ERROR;
+    }
+
+    // One more byte than a uniform piece file tells it from a longer file
+    char filecontent[WORLD_UNIFORM_PIECE_FILE_SIZE + 1];
+    const size_t readSize = fread(filecontent, sizeof(char), sizeof(filecontent), file);
+    fclose(file);
+
+    if (readSize != WORLD_UNIFORM_PIECE_FILE_SIZE
+        || memcmp(filecontent, WORLD_UNIFORM_PIECE_MAGIC, WORLD_UNIFORM_PIECE_MAGIC_SIZE) != 0) {
+        return HXF_ERROR;
+    }
+
+    memcpy(textureIndex, filecontent + WORLD_UNIFORM_PIECE_MAGIC_SIZE, sizeof(uint32_t));
+
+    return HXF_SUCCESS;
+}
+
+void hxfWorldWritePiece(const HxfWorld* restrict world, const HxfWorldPiece* restrict piece) {
+    saveWorldPiece(piece, world->directoryPath);
+}
+
+void hxfWorldGeneratePiece(const HxfWorld* restrict world, HxfWorldPiece* restrict piece) {
+    if (world->isFlat) {
+        generateFlatWorldPiece(piece);
+    }
+    else {
+        hxfGenerateWorldPiece(piece, world->seed);
+    }
+}
+
+uint32_t hxfWorldGenerateRegion(HxfWorld* restrict world, const HxfIvec3* restrict min, const HxfIvec3* restrict max) {
+    // The region is generated in batches so that the positions fit in the scratch arena
+    const uint32_t batchSize = 1024;
+
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    HxfIvec3* const positions = hxfArenaAlloc(scratch, sizeof(HxfIvec3) * batchSize);
+    PieceLoading loading = {
+        .world = world,
+        .positions = positions,
+        .generationDurations = hxfArenaAlloc(scratch, sizeof(double) * batchSize),
+    };
+    uint32_t generatedPieceCount = 0;
+    uint32_t count = 0;
+
+    for (int32_t x = min->x; x <= max->x; x++) {
+        for (int32_t z = min->z; z <= max->z; z++) {
+            positions[count] = (HxfIvec3){ x, 0, z };
+            count++;
+
+            if (count == batchSize || (x == max->x && z == max->z)) {
+                hxfThreadPoolRun(&world->threadPool, generateWorldPieceTask, &loading, count);
+
+                for (uint32_t i = 0; i != count; i++) {
+                    if (loading.generationDurations[i] >= 0.0) {
+                        generatedPieceCount++;
+                        world->generatedPieceCount++;
+                        world->generationDuration += loading.generationDurations[i];
+                    }
+                }
+                count = 0;
+            }
+        }
+    }
+
+    hxfArenaReset(scratch, scratchMark);
+
+    return generatedPieceCount;
+}
+
+void hxfWorldOpen(HxfWorldSaveData* restrict data) {
     loadWorldInfo(data);
 
     // Initialize the world pieces
 
     HxfMap* const cubesMap = &data->world->pieces;
     cubesMap->compareKey = worldPieceMapCompareKey;
+    data->world->blocks.compareKey = blockMapCompareKey;
+
+    hxfThreadPoolCreate(&data->world->threadPool, HXF_WORLD_THREAD_COUNT);
+}
+
+void hxfWorldClose(HxfWorld* restrict world) {
+    hxfThreadPoolDestroy(&world->threadPool);
+}
+
+void hxfWorldLoad(HxfWorldSaveData* restrict data) {
+    hxfWorldOpen(data);
 
     // Load the world pieces around the camera position according to the view distance
 
@@ -281,13 +1204,36 @@ void hxfWorldLoad(HxfWorldSaveData* restrict data) {
     const int32_t minZ = worldPiecePosition.z - HXF_HORIZONTAL_VIEW_DISTANCE / 2;
     const int32_t maxZ = worldPiecePosition.z + HXF_HORIZONTAL_VIEW_DISTANCE / 2;
 
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    HxfIvec3* positions = hxfArenaAlloc(scratch, sizeof(HxfIvec3) * HXF_HORIZONTAL_VIEW_DISTANCE * HXF_HORIZONTAL_VIEW_DISTANCE);
+    uint32_t count = 0;
+
     for (int32_t x = minX; x != maxX; x++) {
         for (int32_t z = minZ; z != maxZ; z++) {
-            HxfIvec3 pos = { x, 0, z };
-            HxfWorldPiece* piece = loadWorldPiece(data->world->directoryPath, &pos);
-            hxfMapSet(cubesMap, &piece->position, piece);
+            positions[count] = (HxfIvec3){ x, 0, z };
+            count++;
         }
     }
+
+    loadWorldPieces(data->world, positions, count);
+    hxfArenaReset(scratch, scratchMark);
+
+    if (data->world->printStatistics && data->world->generatedPieceCount != 0) {
+        printf(
+            "World: %u pieces generated with the seed %u, %.0f pieces per second per thread\n",
+            data->world->generatedPieceCount, data->world->seed,
+            data->world->generatedPieceCount / data->world->generationDuration
+        );
+    }
+    if (data->world->printStatistics) {
+        printf(
+            "World: %u pieces share %u blocks of cubes, %u pieces are uniform, %.1f KiB instead of %.1f KiB\n",
+            data->world->pieceCount, data->world->blockCount, data->world->uniformPieceCount,
+            data->world->blockCount * sizeof(HxfWorldBlock) / 1024.0,
+            data->world->pieceCount * sizeof(HxfWorldBlock) / 1024.0
+        );
+    }
 }
 
 void hxfWorldSave(HxfWorldSaveData* restrict data) {
@@ -305,14 +1251,17 @@ void hxfWorldSave(HxfWorldSaveData* restrict data) {
         saveWorldPiece(value, directoryPath);
 
         // Delete the map element and free the piece
-        hxfMapRemove(map, start->key);
-        hxfFree(value);
+        freeWorldPiece(data->world, value);
 
         start = map->start;
     }
+
+    hxfWorldClose(data->world);
 }
 
 int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict position) {
+    HXF_ZONE("world.updatePiece");
+
     /**
      * @brief Set to one when a world piece was removed.
      *
@@ -320,7 +1269,6 @@ int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict positi
      */
     int wasUpdated = 0;
     HxfMap* const worldPieces = &world->pieces;
-    const char* const worldDirectory = world->directoryPath;
 
     // Get the minimum and maximum world piece coordinate that will be loaded.
     // Minimum is exclusive and maximum inclusive.
@@ -334,7 +1282,11 @@ int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict positi
     // Remove the world piece that are out of the view distance
 
     HxfMapElement* iterator = worldPieces->start;
-    HxfMapElement* toRemove[HXF_HORIZONTAL_VIEW_DISTANCE * HXF_VERTICAL_VIEW_DISTANCE * 2]; // The size of two layers to be sure there is enough place
+    // The pieces are kept rather than their elements, as removing an element can free another one.
+    // All the loaded pieces are removed when the camera moves farther than the view distance
+    HxfArena* const scratch = hxfGetScratchArena();
+    const size_t scratchMark = scratch->offset;
+    HxfWorldPiece** toRemove = hxfArenaAlloc(scratch, sizeof(HxfWorldPiece*) * HXF_HORIZONTAL_VIEW_DISTANCE * HXF_HORIZONTAL_VIEW_DISTANCE);
 
     // Find the pieces that need to be removed
 
@@ -343,7 +1295,7 @@ int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict positi
         HxfIvec3* position = (HxfIvec3*)iterator->key;
 
         if (position->x < minX || position->x >= maxX || position->z < minZ || position->z >= maxZ) {
-            toRemove[i] = iterator;
+            toRemove[i] = iterator->value;
             i++;
         }
         iterator = iterator->next;
@@ -354,13 +1306,15 @@ int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict positi
     if (i != 0) {
         wasUpdated = 1;
         for (int j = 0; j != i; j++) {
-            void* value = toRemove[j]->value;
-            hxfMapRemove(worldPieces, toRemove[j]->key);
-            hxfFree(value);
+            freeWorldPiece(world, toRemove[j]);
         }
     }
+    hxfArenaReset(scratch, scratchMark);
 
-    // Add the new world piece
+    // Add the new world piece, they are all loaded at once by the threads of the world
+
+    HxfIvec3* positions = hxfArenaAlloc(scratch, sizeof(HxfIvec3) * HXF_HORIZONTAL_VIEW_DISTANCE * HXF_HORIZONTAL_VIEW_DISTANCE);
+    uint32_t count = 0;
 
     for (int32_t x = minX; x != maxX; x++) {
         for (int32_t z = minZ; z != maxZ; z++) {
@@ -368,11 +1322,14 @@ int hxfWorldUpdatePiece(HxfWorld* restrict world, const HxfVec3* restrict positi
 
             const HxfIvec3 position = { x, 0, z };
             if (hxfMapGet(worldPieces, &position) == NULL) {
-                HxfWorldPiece* piece = loadWorldPiece(worldDirectory, &position);
-                hxfMapSet(worldPieces, &piece->position, piece);
+                positions[count] = position;
+                count++;
             }
         }
     }
 
+    loadWorldPieces(world, positions, count);
+    hxfArenaReset(scratch, scratchMark);
+
     return wasUpdated;
 }
@@ -2,6 +2,8 @@
 
 #include "math/linear-algebra.h"
 #include "container/map.h"
+#include "thread/thread-pool.h"
+#include "hxf.h"
 #include <stdint.h>
 
 /**
@@ -13,17 +15,72 @@
  *
  */
 #define HXF_WORLD_PIECE_CUBE_COUNT HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE * HXF_WORLD_PIECE_SIZE
+/**
+ * @brief The number of textures of the cubes, the texture index 0 is air.
+ */
+#define HXF_TEXTURE_COUNT 5
 #define HXF_HORIZONTAL_VIEW_DISTANCE 16 // Must be even
 #define HXF_VERTICAL_VIEW_DISTANCE 1   // Must be even, not used for now
 
+/**
+ * @brief The number of threads that load and generate the world pieces.
+ */
+#define HXF_WORLD_THREAD_COUNT 4
+
+/**
+ * @brief The number of sides of a world piece.
+ *
+ * The sides are in the same order as the faces directions: top (+y), back (-z), bottom (-y),
+ * front (+z), right (+x) and left (-x).
+ */
+#define HXF_WORLD_PIECE_SIDE_COUNT 6
+
+/**
+ * @brief A connectivity mask where all the sides of a piece can see each other.
+ */
+#define HXF_WORLD_PIECE_FULLY_CONNECTED 0x7FFF
+
+/**
+ * @brief The number of levels of detail of a piece.
+ *
+ * The cubes of the level l are 2^l cubes wide, so the level 0 is the piece itself and the
+ * last level has 4×4×4 cubes in each of its cubes.
+ */
+#define HXF_WORLD_LOD_COUNT 3
+
+/**
+ * @brief The start of the name of the block files, it is followed by the hash of the cubes in
+ * hexadecimal.
+ *
+ * A block file has the cubes of several pieces that have the same cubes, the file of each of
+ * these pieces only refers to it.
+ */
+#define HXF_WORLD_BLOCK_FILE_PREFIX "block-"
+
+/**
+ * @brief The cubes of a world piece, shared by the loaded pieces that have the same cubes.
+ *
+ * The cubes of a block used by several pieces must not change, hxfWorldGetWritableBlock gives
+ * a piece its own copy before it is changed.
+ */
+typedef struct HxfWorldBlock {
+    uint32_t cubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE]; ///< The array of cubes.
+    uint64_t hash; ///< The hash of the cubes, it is up to date while the block is shared or has a block file.
+    uint32_t refCount; ///< The number of pieces that use the block.
+    int isShared; ///< Set to 1 if the block is in the blocks of the world, so that the next pieces with the same cubes use it.
+    int isFileSaved; ///< Set to 1 if the block file of the cubes exists, the pieces that use the block can refer to it.
+} HxfWorldBlock;
+
 /**
  * @brief A piece of the world.
  *
- * It’s a big cube of 16×16×16 cubes.
+ * It’s a big cube of 16×16×16 cubes. A piece whose cubes all have the same texture, such as
+ * a piece of air, has no block: only that texture is kept.
  */
 typedef struct HxfWorldPiece {
     HxfIvec3 position; ///< The world piece position inside the world.
-    uint32_t cubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE]; ///< The array of cubes of the world piece.
+    HxfWorldBlock* block; ///< The cubes of the world piece, only read through it, NULL if the piece is uniform.
+    uint32_t uniformCube; ///< The texture index of all the cubes when the piece has no block.
 } HxfWorldPiece;
 
 /**
@@ -32,8 +89,32 @@ typedef struct HxfWorldPiece {
 typedef struct HxfWorld {
     HxfMap pieces;
     char* directoryPath; ///< The path to the directory of the world.
+    /**
+     * @brief The seed of the terrain generator.
+     *
+     * It is set before hxfWorldLoad for a new world, and replaced by the seed of the info file
+     * of an existing world.
+     */
+    uint32_t seed;
+    int isFlat; ///< Set to 1 for the worlds made before the terrain generator, their new pieces stay flat.
+    HxfThreadPool threadPool; ///< The threads that load and generate the pieces, between hxfWorldLoad and hxfWorldSave.
+    uint32_t generatedPieceCount; ///< The number of pieces generated since the world was loaded.
+    double generationDuration; ///< The time (in seconds) the threads spent generating them.
+    int printStatistics; ///< If set to 1, hxfWorldLoad prints how many pieces were generated and how their cubes are shared.
+    HxfMap blocks; ///< The shared blocks, by hash of their cubes.
+    uint32_t pieceCount; ///< The number of loaded pieces.
+    uint32_t blockCount; ///< The number of blocks used by the loaded pieces.
+    uint32_t uniformPieceCount; ///< The number of loaded pieces that have no block.
 } HxfWorld;
 
+/**
+ * @brief A block of cubes that can be pasted into the world with hxfWorldPaste.
+ */
+typedef struct HxfWorldStructure {
+    HxfIvec3 size; ///< The number of cubes in each dimension.
+    const uint32_t* cubes; ///< The cubes, in the same order as the cubes of a world piece: z first, then y, then x.
+} HxfWorldStructure;
+
 /**
  * @brief Arguments passed to hxfWorldLoad or hxfWorldSave
  */
@@ -72,10 +153,186 @@ HxfIvec3 hxfWorldGetPiecePositionI(const HxfIvec3* restrict globalPosition);
 HxfIvec3 hxfWorldGetLocalPosition(const HxfIvec3* restrict globalPosition);
 
 
+/**
+ * @brief Get the bit of a connectivity mask that tells if two sides of a piece are connected.
+ *
+ * @param sideA A side of the piece.
+ * @param sideB Another side of the piece, different from sideA.
+ *
+ * @return The bit, one of the 15 lowest bits.
+ */
+uint16_t hxfWorldGetSidesBit(int sideA, int sideB);
+
+/**
+ * @brief Compute which sides of a world piece can see each other through air.
+ *
+ * Two sides are connected if an air region of the piece touches both of them.
+ *
+ * @param piece The world piece.
+ *
+ * @return A mask that contains the hxfWorldGetSidesBit of each connected pair of sides.
+ */
+uint16_t hxfWorldGetPieceConnectivity(const HxfWorldPiece* restrict piece);
+
+/**
+ * @brief Build a level of detail of a world piece, where each cube covers several cubes of the piece.
+ *
+ * A cube of the level is solid if at least half of the cubes it covers are solid, and it takes
+ * the texture of the highest of them, so that the surface of the ground keeps its texture.
+ *
+ * @param piece The world piece.
+ * @param level The level of detail, from 1 to HXF_WORLD_LOD_COUNT - 1.
+ * @param cubes The array that receives the cubes of the level, only the first
+ * HXF_WORLD_PIECE_SIZE >> level cubes of each dimension are written.
+ */
+void hxfWorldDownsamplePiece(const HxfWorldPiece* restrict piece, uint32_t level, uint32_t cubes[HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE][HXF_WORLD_PIECE_SIZE]);
+
+/**
+ * @brief Set all the cubes of a box to a texture index.
+ *
+ * Only the cubes of the loaded pieces are changed. Each row of cubes is written at once, and
+ * the pieces entirely inside the box become uniform.
+ *
+ * @param world The world where the cubes are.
+ * @param min The cube of the box with the lowest coordinates.
+ * @param max The cube of the box with the highest coordinates, it is included in the box.
+ * @param textureIndex The texture index to set, 0 for air.
+ *
+ * @return The number of pieces that were changed.
+ */
+uint32_t hxfWorldFill(HxfWorld* restrict world, const HxfIvec3* restrict min, const HxfIvec3* restrict max, uint32_t textureIndex);
+
+/**
+ * @brief Replace the cubes whose center is inside a sphere by air.
+ *
+ * Only the cubes of the loaded pieces are changed.
+ *
+ * @param world The world where the cubes are.
+ * @param center The center of the sphere.
+ * @param radius The radius of the sphere (in cubes).
+ *
+ * @return The number of pieces that were changed.
+ */
+uint32_t hxfWorldCarveSphere(HxfWorld* restrict world, const HxfVec3* restrict center, float radius);
+
+/**
+ * @brief Copy a structure into the world, its air cubes replace the cubes of the world too.
+ *
+ * Only the cubes of the loaded pieces are changed.
+ *
+ * @param world The world where the cubes are.
+ * @param structure The structure to copy.
+ * @param position The position of the first cube of the structure.
+ *
+ * @return The number of pieces that were changed.
+ */
+uint32_t hxfWorldPaste(HxfWorld* restrict world, const HxfWorldStructure* restrict structure, const HxfIvec3* restrict position);
+
+/**
+ * @brief Get the block of a world piece to change its cubes.
+ *
+ * The block is copied first if other pieces use it, and it stops being shared, so that the
+ * other pieces keep their cubes. A uniform piece gets a block filled with its texture.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece.
+ *
+ * @return The block of the piece, that only this piece uses.
+ */
+HxfWorldBlock* hxfWorldGetWritableBlock(HxfWorld* restrict world, HxfWorldPiece* restrict piece);
+
+/**
+ * @brief Read a world piece from its file, or from the block file it refers to.
+ *
+ * The block of a uniform piece is filled with its texture. The cubes missing from a file
+ * shorter than a piece are air.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece, its position and its block must be set.
+ *
+ * @return HXF_ERROR if the piece has no file, HXF_MISSING_FILE_ERROR if its block file is
+ * missing, HXF_SUCCESS otherwise.
+ */
+HxfResult hxfWorldReadPiece(const HxfWorld* restrict world, HxfWorldPiece* restrict piece);
+
+/**
+ * @brief Get the hash of the block file a piece file refers to.
+ *
+ * @param world The world the piece belongs to.
+ * @param position The position of the world piece.
+ * @param hash Receives the hash.
+ *
+ * @return HXF_ERROR if the piece file has the cubes itself or does not exist, HXF_SUCCESS
+ * otherwise.
+ */
+HxfResult hxfWorldGetPieceBlockHash(const HxfWorld* restrict world, const HxfIvec3* restrict position, uint64_t* restrict hash);
+
+/**
+ * @brief Get the texture of the cubes of a piece whose file is the one of a uniform piece.
+ *
+ * @param world The world the piece belongs to.
+ * @param position The position of the world piece.
+ * @param textureIndex Receives the texture index of the cubes.
+ *
+ * @return HXF_ERROR if the piece file has the cubes or refers to a block file, or does not
+ * exist, HXF_SUCCESS otherwise.
+ */
+HxfResult hxfWorldGetPieceUniformCube(const HxfWorld* restrict world, const HxfIvec3* restrict position, uint32_t* restrict textureIndex);
+
+/**
+ * @brief Write a world piece to its file.
+ *
+ * The file of a uniform piece only has its texture. The file of a piece whose block is shared
+ * or has a block file only refers to the block file, which is written once.
+ *
+ * @param world The world the piece belongs to.
+ * @param piece The world piece.
+ */
+void hxfWorldWritePiece(const HxfWorld* restrict world, const HxfWorldPiece* restrict piece);
+
+/**
+ * @brief Generate the cubes a world piece has before it is saved for the first time.
+ *
+ * @param world The world the piece belongs to, it gives the seed.
+ * @param piece The world piece, its position and its block must be set and its cubes must be air.
+ */
+void hxfWorldGeneratePiece(const HxfWorld* restrict world, HxfWorldPiece* restrict piece);
+
+/**
+ * @brief Generate and save the pieces of a region that were never saved, with the threads of the world.
+ *
+ * The pieces are not added to the world, so a region larger than the view distance can be
+ * generated ahead of time.
+ *
+ * @param world The world, opened with hxfWorldOpen.
+ * @param min The piece of the region with the lowest x and z, the region only has pieces at y = 0.
+ * @param max The piece of the region with the highest x and z, it is included in the region.
+ *
+ * @return The number of pieces generated.
+ */
+uint32_t hxfWorldGenerateRegion(HxfWorld* restrict world, const HxfIvec3* restrict min, const HxfIvec3* restrict max);
+
+/**
+ * @brief Read the info file of a world and start its threads, without loading any piece.
+ *
+ * @param data A pointer to the data that will be load.
+ */
+void hxfWorldOpen(HxfWorldSaveData* restrict data);
+
+/**
+ * @brief Stop the threads of a world opened with hxfWorldOpen, without saving it.
+ *
+ * It must have no piece left.
+ *
+ * @param world The world.
+ */
+void hxfWorldClose(HxfWorld* restrict world);
+
 /**
  * @brief Load a world from a disk.
  *
- * If the file does not exist, it creates a new default world file.
+ * If the file does not exist, it creates a new default world file. The pieces are loaded, or
+ * generated if they were never saved, by the threads of the world.
  *
  * @param data A pointer to the data that will be load.
  */